@@ -0,0 +1,408 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_analysis.c - Single-pass capture analysis for MCT's Trigger 5 and Trigger 6 protocols.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mct_analysis.h"
+#include "mct_le.h"
+
+
+static const uint16_t MCT_USB_VID = 0x0711;
+static const uint16_t INSIGNIA_USB_VID = 0x19FF;
+
+#define USB_DT_DEVICE 1
+#define USB_DT_STRING 3
+#define USB_DEVICE_DESCRIPTOR_ID_LEN 12
+#define USB_DEVICE_DESCRIPTOR_LEN 18
+#define USB_REQ_GET_DESCRIPTOR 6
+
+#define USB_SETUP_TYPE_VENDOR 2
+
+/* The same ranges the Wireshark dissectors register for. */
+mct_protocol_t mct_protocol_from_usb_id(uint16_t vid, uint16_t pid) {
+    if ((vid == MCT_USB_VID) && (pid >= 0x5800) && (pid <= 0x581F)) {
+        return MCT_PROTOCOL_T5;
+    }
+
+    if (((vid == MCT_USB_VID) || (vid == INSIGNIA_USB_VID)) && (pid >= 0x5600) && (pid <= 0x561F)) {
+        return MCT_PROTOCOL_T6;
+    }
+
+    return MCT_PROTOCOL_UNKNOWN;
+}
+
+const char * mct_protocol_name(mct_protocol_t protocol) {
+    switch (protocol) {
+        case MCT_PROTOCOL_T5:
+            return "Trigger 5";
+        case MCT_PROTOCOL_T6:
+            return "Trigger 6";
+        default:
+            return "Unknown";
+    }
+}
+
+void mct_analysis_init(mct_analysis_t *analysis, mct_protocol_t default_protocol) {
+    memset(analysis, 0, sizeof(*analysis));
+    analysis->default_protocol = default_protocol;
+}
+
+static mct_device_stats_t * device_lookup(mct_analysis_t *analysis, uint32_t device_id) {
+    for (uint32_t i = 0; i < analysis->device_count; i++) {
+        if (analysis->devices[i].device_id == device_id) {
+            return &analysis->devices[i];
+        }
+    }
+
+    if (analysis->device_count >= MCT_ANALYSIS_MAX_DEVICES) {
+        return NULL;
+    }
+
+    mct_device_stats_t * device = &analysis->devices[analysis->device_count++];
+    memset(device, 0, sizeof(*device));
+    device->device_id = device_id;
+    device->protocol = analysis->default_protocol;
+
+    return device;
+}
+
+static void count_frame(mct_device_stats_t *device, uint64_t ts_ns, bool compressed, uint64_t frame_bytes) {
+    if (device->frames == 0) {
+        device->first_frame_ts_ns = ts_ns;
+    }
+    device->last_frame_ts_ns = ts_ns;
+
+    device->frames++;
+    device->frame_bytes += frame_bytes;
+    if (compressed) {
+        device->compressed_frames++;
+    }
+}
+
+/* Follows the same steps as handle_bulk() in the Trigger 5 dissector, with resync always enabled. */
+static void handle_t5_bulk(mct_device_stats_t *device, uint64_t ts_ns, const mct_usb_urb_t *urb) {
+    const uint8_t * buf = urb->data;
+    size_t len = urb->data_len;
+    bool have_header = len >= MCT_T5_BULK_HEADER_LEN;
+
+    ptrdiff_t header_offset = -1;
+    if (mct_t5_bulk_expects_header(&device->t5_state)) {
+        if (have_header && mct_t5_bulk_header_magic_valid(buf)) {
+            header_offset = 0;
+        } else {
+            header_offset = mct_t5_bulk_header_find(buf, len, 1);
+            if (header_offset < 0) {
+                return;
+            }
+            device->t5_resyncs++;
+        }
+    } else if (have_header && mct_t5_bulk_header_magic_valid(buf) && mct_t5_bulk_header_checksum_valid(buf)) {
+        header_offset = 0;
+        device->t5_resyncs++;
+    }
+
+    if (header_offset < 0) {
+        mct_t5_bulk_fragment_t fragment = { 0 };
+        mct_t5_bulk_continue_packet(&device->t5_state, urb->reported_len, &fragment);
+        return;
+    }
+
+    const uint8_t * header_buf = &buf[header_offset];
+    if (!mct_t5_bulk_header_checksum_valid(header_buf)) {
+        device->t5_checksum_errors++;
+    }
+
+    mct_t5_bulk_header_t header = { 0 };
+    mct_t5_bulk_header_parse(header_buf, &header);
+
+    mct_t5_bulk_fragment_t fragment = { 0 };
+    mct_t5_bulk_start_packet(&device->t5_state, &header, urb->reported_len - header_offset, &fragment);
+
+    count_frame(device, ts_ns, (header.frame_flags & MCT_T5_BULK_FRAME_FLAG_COMPRESSED) != 0,
+        MCT_T5_BULK_HEADER_LEN + header.payload_len);
+}
+
+/* Follows the same steps as handle_bulk() in the Trigger 6 dissector. */
+static void handle_t6_bulk(mct_device_stats_t *device, uint64_t ts_ns, const mct_usb_urb_t *urb) {
+    if (mct_t6_bulk_expects_selector(&device->t6_state)) {
+        if (urb->data_len < MCT_T6_SELECTOR_LEN) {
+            return;
+        }
+
+        mct_t6_selector_t selector = { 0 };
+        mct_t6_selector_parse(urb->data, &selector);
+        mct_t6_bulk_select(&device->t6_state, &selector);
+        device->t6_selectors++;
+        return;
+    }
+
+    uint32_t session_num = device->t6_state.selector.session_num;
+    uint32_t payload_offset = mct_t6_bulk_continue(&device->t6_state, urb->reported_len);
+
+    if (session_num < MCT_ANALYSIS_MAX_SESSIONS) {
+        device->t6_session_bytes[session_num] += urb->reported_len;
+    }
+
+    if ((session_num == MCT_T6_SESSION_VIDEO) && (payload_offset == 0) &&
+        (urb->data_len >= MCT_T6_VIDEO_HEADER_LEN)) {
+        mct_t6_video_header_t header = { 0 };
+        mct_t6_video_header_parse(urb->data, &header);
+
+        bool compressed = mct_t6_video_payload_is_jpeg(&urb->data[MCT_T6_VIDEO_HEADER_LEN],
+            urb->data_len - MCT_T6_VIDEO_HEADER_LEN);
+        count_frame(device, ts_ns, compressed, (uint64_t)MCT_T6_VIDEO_HEADER_LEN + header.data_len);
+    }
+}
+
+static void handle_device_descriptor(mct_analysis_t *analysis, const mct_usb_urb_t *urb) {
+    const uint8_t * buf = urb->data;
+    if ((urb->data_len < USB_DEVICE_DESCRIPTOR_ID_LEN) || (buf[1] != USB_DT_DEVICE)) {
+        return;
+    }
+
+    mct_device_stats_t * device = device_lookup(analysis, mct_usb_device_id(urb));
+    if (!device) {
+        return;
+    }
+
+    device->vid = mct_le16(&buf[8]);
+    device->pid = mct_le16(&buf[10]);
+    if (urb->data_len >= USB_DEVICE_DESCRIPTOR_LEN) {
+        device->serial_index = buf[16];
+    }
+
+    mct_protocol_t protocol = mct_protocol_from_usb_id(device->vid, device->pid);
+    if (protocol != MCT_PROTOCOL_UNKNOWN) {
+        device->protocol = protocol;
+    }
+
+    /* The device was (re-)enumerated, so whatever was left of the bulk stream is gone. */
+    memset(&device->t5_state, 0, sizeof(device->t5_state));
+    memset(&device->t6_state, 0, sizeof(device->t6_state));
+}
+
+/* String descriptors can't be told apart by their contents, so remember which one was asked for last. */
+static void handle_get_string_descriptor(mct_analysis_t *analysis, const mct_usb_urb_t *urb) {
+    mct_device_stats_t * device = device_lookup(analysis, mct_usb_device_id(urb));
+    if (device) {
+        device->pending_string_index = urb->setup[2];
+    }
+}
+
+static void handle_string_descriptor(mct_analysis_t *analysis, const mct_usb_urb_t *urb) {
+    mct_device_stats_t * device = device_lookup(analysis, mct_usb_device_id(urb));
+    if (!device || (device->serial_index == 0) || (device->pending_string_index != device->serial_index)) {
+        return;
+    }
+    device->pending_string_index = 0;
+
+    /* UTF-16LE, only the ASCII characters of which are kept. */
+    const uint8_t * buf = urb->data;
+    uint32_t len = (buf[0] < urb->data_len) ? buf[0] : urb->data_len;
+    size_t serial_len = 0;
+    for (uint32_t i = 2; (i + 1 < len) && (serial_len < MCT_ANALYSIS_MAX_SERIAL_LEN); i += 2) {
+        uint16_t c = mct_le16(&buf[i]);
+        if ((c >= 0x20) && (c < 0x7F)) {
+            device->serial[serial_len++] = (char)c;
+        }
+    }
+    device->serial[serial_len] = '\0';
+}
+
+static void handle_vendor_setup(mct_analysis_t *analysis, const mct_usb_urb_t *urb) {
+    mct_device_stats_t * device = device_lookup(analysis, mct_usb_device_id(urb));
+    if (!device) {
+        return;
+    }
+
+    uint8_t bRequest = urb->setup[1];
+    if (device->protocol == MCT_PROTOCOL_T5) {
+        if (bRequest == MCT_T5_CTRL_REQ_SET_VIDEO_MODE) {
+            device->mode_changes++;
+        } else if (bRequest == MCT_T5_CTRL_REQ_GET_EDID_BLOCK) {
+            device->edid_reads++;
+        }
+    } else if (device->protocol == MCT_PROTOCOL_T6) {
+        if (bRequest == MCT_T6_CONTROL_REQ_SET_VIDEO_MODE) {
+            device->mode_changes++;
+        } else if (bRequest == MCT_T6_CONTROL_REQ_GET_EDID_BLOCK) {
+            device->edid_reads++;
+        }
+    }
+}
+
+void mct_analysis_add_urb(mct_analysis_t *analysis, uint64_t ts_ns, const mct_usb_urb_t *urb) {
+    if ((urb->transfer_type == MCT_USB_TRANSFER_CONTROL) && (urb->endpoint == 0)) {
+        if (urb->is_submit && urb->has_setup && (((urb->setup[0] >> 5) & 0x3) == USB_SETUP_TYPE_VENDOR)) {
+            handle_vendor_setup(analysis, urb);
+        } else if (urb->is_submit && urb->has_setup && (urb->setup[0] == 0x80) &&
+            (urb->setup[1] == USB_REQ_GET_DESCRIPTOR) && (urb->setup[3] == USB_DT_STRING)) {
+            handle_get_string_descriptor(analysis, urb);
+        } else if (urb->direction_in && !urb->is_submit && (urb->data_len >= 2) && (urb->data[1] == USB_DT_STRING)) {
+            handle_string_descriptor(analysis, urb);
+        } else if (urb->direction_in && !urb->is_submit && (urb->data_len > 0) && (urb->data[0] == 18)) {
+            /* Device descriptors can be recognized by their contents, so there's no need to track the setup packet
+             * that asked for them. */
+            handle_device_descriptor(analysis, urb);
+        }
+        return;
+    }
+
+    if ((urb->transfer_type != MCT_USB_TRANSFER_BULK) || urb->direction_in || !urb->is_submit ||
+        (urb->data_len == 0)) {
+        return;
+    }
+
+    mct_device_stats_t * device = device_lookup(analysis, mct_usb_device_id(urb));
+    if (!device) {
+        return;
+    }
+
+    if (device->protocol == MCT_PROTOCOL_T5 && urb->endpoint == 1) {
+        /* BULK 1 OUT */
+        handle_t5_bulk(device, ts_ns, urb);
+    } else if (device->protocol == MCT_PROTOCOL_T6 && urb->endpoint == 2) {
+        /* BULK 2 OUT */
+        handle_t6_bulk(device, ts_ns, urb);
+    } else {
+        return;
+    }
+
+    if (device->bulk_transfers == 0) {
+        device->first_ts_ns = ts_ns;
+    }
+    device->last_ts_ns = ts_ns;
+
+    device->bulk_transfers++;
+    device->bulk_bytes += urb->reported_len;
+}
+
+/* Reads every packet from the capture, returning 0 on success or -1 if the capture couldn't be read. */
+int mct_analysis_run(mct_analysis_t *analysis, mct_pcapng_reader_t *reader) {
+    mct_pcapng_packet_t packet = { 0 };
+    int ret = 0;
+    while ((ret = mct_pcapng_next(reader, &packet)) > 0) {
+        analysis->packets++;
+
+        mct_usb_urb_t urb = { 0 };
+        if (mct_usb_urb_decode(packet.linktype, packet.data, packet.caplen, packet.origlen, &urb)) {
+            mct_analysis_add_urb(analysis, packet.ts_ns, &urb);
+        }
+    }
+
+    return ret;
+}
+
+bool mct_device_reportable(const mct_device_stats_t *device) {
+    return (device->protocol != MCT_PROTOCOL_UNKNOWN) && (device->bulk_transfers > 0);
+}
+
+void mct_device_totals_add(mct_device_totals_t *totals, const mct_device_stats_t *device) {
+    totals->device_id = device->device_id;
+    memcpy(totals->serial, device->serial, sizeof(totals->serial));
+    totals->vid = device->vid;
+    totals->pid = device->pid;
+    totals->protocol = device->protocol;
+    totals->devices++;
+
+    totals->bulk_transfers += device->bulk_transfers;
+    totals->bulk_bytes += device->bulk_bytes;
+    totals->bulk_duration_ns += device->last_ts_ns - device->first_ts_ns;
+
+    totals->frames += device->frames;
+    totals->compressed_frames += device->compressed_frames;
+    totals->frame_bytes += device->frame_bytes;
+    if (device->frames > 1) {
+        totals->frame_intervals += device->frames - 1;
+        totals->frame_duration_ns += device->last_frame_ts_ns - device->first_frame_ts_ns;
+    }
+
+    totals->mode_changes += device->mode_changes;
+    totals->edid_reads += device->edid_reads;
+
+    totals->t5_checksum_errors += device->t5_checksum_errors;
+    totals->t5_resyncs += device->t5_resyncs;
+
+    totals->t6_selectors += device->t6_selectors;
+    for (uint32_t i = 0; i < MCT_ANALYSIS_MAX_SESSIONS; i++) {
+        totals->t6_session_bytes[i] += device->t6_session_bytes[i];
+    }
+}
+
+void mct_device_totals_print(const mct_device_totals_t *totals, const char *title, FILE *out) {
+    fprintf(out, "%s\n", title);
+
+    double duration = totals->bulk_duration_ns / 1e9;
+    fprintf(out, "  Bulk transfers: %" PRIu64 " (%" PRIu64 " bytes over %.3f s", totals->bulk_transfers,
+        totals->bulk_bytes, duration);
+    if (duration > 0) {
+        fprintf(out, ", %.1f kB/s", totals->bulk_bytes / duration / 1e3);
+    }
+    fprintf(out, ")\n");
+
+    fprintf(out, "  Frames: %" PRIu64 " (%" PRIu64 " compressed, %" PRIu64 " uncompressed)\n", totals->frames,
+        totals->compressed_frames, totals->frames - totals->compressed_frames);
+    if (totals->frames > 0) {
+        fprintf(out, "  Bytes per frame: %.1f\n", (double)totals->frame_bytes / totals->frames);
+    }
+    if (totals->frame_duration_ns > 0) {
+        fprintf(out, "  Frames per second: %.2f\n", totals->frame_intervals / (totals->frame_duration_ns / 1e9));
+    }
+
+    fprintf(out, "  Mode changes: %" PRIu64 "\n", totals->mode_changes);
+    fprintf(out, "  EDID block reads: %" PRIu64 "\n", totals->edid_reads);
+
+    if (totals->protocol == MCT_PROTOCOL_T5) {
+        fprintf(out, "  Header checksum errors: %" PRIu64 "\n", totals->t5_checksum_errors);
+        fprintf(out, "  Resyncs: %" PRIu64 "\n", totals->t5_resyncs);
+    } else {
+        fprintf(out, "  Select session packets: %" PRIu64 "\n", totals->t6_selectors);
+        for (uint32_t session_num = 0; session_num < MCT_ANALYSIS_MAX_SESSIONS; session_num++) {
+            if (totals->t6_session_bytes[session_num] > 0) {
+                fprintf(out, "  Session %u bytes: %" PRIu64 "\n", session_num, totals->t6_session_bytes[session_num]);
+            }
+        }
+    }
+}
+
+void mct_analysis_print(const mct_analysis_t *analysis, FILE *out) {
+    for (uint32_t i = 0; i < analysis->device_count; i++) {
+        const mct_device_stats_t * device = &analysis->devices[i];
+        if (!mct_device_reportable(device)) {
+            continue;
+        }
+
+        mct_device_totals_t totals = { 0 };
+        mct_device_totals_add(&totals, device);
+
+        char title[160];
+        if (device->serial[0]) {
+            snprintf(title, sizeof(title), "Device %u.%u (%04x:%04x, serial %s): %s", device->device_id >> 16,
+                device->device_id & 0xFFFF, device->vid, device->pid, device->serial, mct_protocol_name(device->protocol));
+        } else {
+            snprintf(title, sizeof(title), "Device %u.%u (%04x:%04x): %s", device->device_id >> 16,
+                device->device_id & 0xFFFF, device->vid, device->pid, mct_protocol_name(device->protocol));
+        }
+        mct_device_totals_print(&totals, title, out);
+    }
+}
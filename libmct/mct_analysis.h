@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_analysis.h - Single-pass capture analysis for MCT's Trigger 5 and Trigger 6 protocols.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_ANALYSIS_H_INCLUDED
+#define MCT_ANALYSIS_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "mct_pcapng.h"
+#include "mct_t5.h"
+#include "mct_t6.h"
+#include "mct_usb.h"
+
+#define MCT_ANALYSIS_MAX_DEVICES 32
+#define MCT_ANALYSIS_MAX_SESSIONS 8
+#define MCT_ANALYSIS_MAX_SERIAL_LEN 64
+
+typedef enum {
+    MCT_PROTOCOL_UNKNOWN,
+    MCT_PROTOCOL_T5,
+    MCT_PROTOCOL_T6,
+} mct_protocol_t;
+
+typedef struct mct_device_stats_s {
+    uint32_t device_id;
+    uint16_t vid;
+    uint16_t pid;
+    mct_protocol_t protocol;
+    /* Only known if both the device descriptor and the serial number string descriptor were captured, and empty
+     * otherwise. */
+    char serial[MCT_ANALYSIS_MAX_SERIAL_LEN + 1];
+    uint8_t serial_index;
+    uint8_t pending_string_index;
+
+    uint64_t first_ts_ns;
+    uint64_t last_ts_ns;
+
+    uint64_t bulk_transfers;
+    uint64_t bulk_bytes;
+
+    /* A frame is one T5 bulk packet (a single screen update) or one T6 video session payload. */
+    uint64_t frames;
+    uint64_t compressed_frames;
+    uint64_t frame_bytes;
+    uint64_t first_frame_ts_ns;
+    uint64_t last_frame_ts_ns;
+
+    uint64_t mode_changes;
+    uint64_t edid_reads;
+
+    mct_t5_bulk_state_t t5_state;
+    uint64_t t5_checksum_errors;
+    uint64_t t5_resyncs;
+
+    mct_t6_bulk_state_t t6_state;
+    uint64_t t6_selectors;
+    uint64_t t6_session_bytes[MCT_ANALYSIS_MAX_SESSIONS];
+} mct_device_stats_t;
+
+/* The counters of one device (the same bus, address, and serial number), possibly from different captures. Durations
+ * only cover the time the device was active, so the rates are still meaningful after adding captures together. */
+typedef struct mct_device_totals_s {
+    uint32_t device_id;
+    uint16_t vid;
+    uint16_t pid;
+    mct_protocol_t protocol;
+    char serial[MCT_ANALYSIS_MAX_SERIAL_LEN + 1];
+    /* The number of captures the device was found in. */
+    uint32_t devices;
+
+    uint64_t bulk_transfers;
+    uint64_t bulk_bytes;
+    uint64_t bulk_duration_ns;
+
+    uint64_t frames;
+    uint64_t compressed_frames;
+    uint64_t frame_bytes;
+    uint64_t frame_intervals;
+    uint64_t frame_duration_ns;
+
+    uint64_t mode_changes;
+    uint64_t edid_reads;
+
+    uint64_t t5_checksum_errors;
+    uint64_t t5_resyncs;
+
+    uint64_t t6_selectors;
+    uint64_t t6_session_bytes[MCT_ANALYSIS_MAX_SESSIONS];
+} mct_device_totals_t;
+
+typedef struct mct_analysis_s {
+    /* Used for devices whose device descriptor wasn't captured. */
+    mct_protocol_t default_protocol;
+    uint64_t packets;
+    uint32_t device_count;
+    mct_device_stats_t devices[MCT_ANALYSIS_MAX_DEVICES];
+} mct_analysis_t;
+
+mct_protocol_t mct_protocol_from_usb_id(uint16_t vid, uint16_t pid);
+const char * mct_protocol_name(mct_protocol_t protocol);
+
+void mct_analysis_init(mct_analysis_t *analysis, mct_protocol_t default_protocol);
+void mct_analysis_add_urb(mct_analysis_t *analysis, uint64_t ts_ns, const mct_usb_urb_t *urb);
+int mct_analysis_run(mct_analysis_t *analysis, mct_pcapng_reader_t *reader);
+void mct_analysis_print(const mct_analysis_t *analysis, FILE *out);
+
+bool mct_device_reportable(const mct_device_stats_t *device);
+void mct_device_totals_add(mct_device_totals_t *totals, const mct_device_stats_t *device);
+void mct_device_totals_print(const mct_device_totals_t *totals, const char *title, FILE *out);
+
+#endif // MCT_ANALYSIS_H_INCLUDED
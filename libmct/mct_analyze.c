@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_analyze.c - Capture analyzer for MCT's Trigger 5 and Trigger 6 protocols.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mct_analysis.h"
+#include "mct_pcapng.h"
+
+
+static size_t file_read(void *ctx, void *buf, size_t len) {
+    return fread(buf, 1, len, (FILE *)ctx);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-t t5|t6] <capture.pcapng|->\n", argv0);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -t t5|t6  Protocol to assume for devices whose device descriptor wasn't captured.\n");
+}
+
+int main(int argc, char **argv) {
+    mct_protocol_t default_protocol = MCT_PROTOCOL_UNKNOWN;
+
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "ht:")) != -1) {
+        switch (opt) {
+            case 't':
+                if (strcmp(optarg, "t5") == 0) {
+                    default_protocol = MCT_PROTOCOL_T5;
+                } else if (strcmp(optarg, "t6") == 0) {
+                    default_protocol = MCT_PROTOCOL_T6;
+                } else {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char * path = argv[optind];
+    FILE * file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    mct_pcapng_reader_t reader;
+    mct_pcapng_init(&reader, file_read, file);
+
+    mct_analysis_t analysis;
+    mct_analysis_init(&analysis, default_protocol);
+
+    int ret = mct_analysis_run(&analysis, &reader);
+    if (ret < 0) {
+        fprintf(stderr, "%s: Not a valid pcapng file, or it's truncated\n", path);
+    }
+
+    mct_analysis_print(&analysis, stdout);
+
+    mct_pcapng_free(&reader);
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    return (ret < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,337 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_batch.c - Parallel capture analyzer for MCT's Trigger 5 and Trigger 6 protocols.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "mct_analysis.h"
+#include "mct_pcapng.h"
+
+
+/* Large enough that inflate isn't called for every small block. */
+#define GZ_BUFFER_SIZE (256 * 1024)
+
+typedef struct job_s {
+    char * path;
+    int ret;
+    mct_analysis_t analysis;
+} job_t;
+
+typedef struct pool_s {
+    job_t * jobs;
+    size_t job_count;
+    atomic_size_t next_job;
+    mct_protocol_t default_protocol;
+} pool_t;
+
+/* An adapter's totals over the captures it was found in. Adapters with a serial number are merged across captures by
+ * it, but bus addresses are assigned at enumeration and mean nothing in another capture, so an adapter without one is
+ * only merged within the capture it was found in. */
+typedef struct batch_totals_s {
+    /* The capture the adapter was found in, or NULL if it's identified by its serial number. */
+    const char * path;
+    mct_device_totals_t totals;
+} batch_totals_t;
+
+typedef struct path_list_s {
+    char ** paths;
+    size_t count;
+    size_t capacity;
+} path_list_t;
+
+static size_t gz_read(void *ctx, void *buf, size_t len) {
+    int read = gzread((gzFile)ctx, buf, (unsigned)len);
+    return (read > 0) ? (size_t)read : 0;
+}
+
+/* gzread() passes uncompressed files through unchanged, so plain pcapng files work too. */
+static int run_job(job_t *job, mct_protocol_t default_protocol) {
+    mct_analysis_init(&job->analysis, default_protocol);
+
+    gzFile file = gzopen(job->path, "rb");
+    if (!file) {
+        return -1;
+    }
+    gzbuffer(file, GZ_BUFFER_SIZE);
+
+    mct_pcapng_reader_t reader;
+    mct_pcapng_init(&reader, gz_read, file);
+
+    int ret = mct_analysis_run(&job->analysis, &reader);
+
+    mct_pcapng_free(&reader);
+    gzclose(file);
+
+    return ret;
+}
+
+static void * worker(void *arg) {
+    pool_t * pool = (pool_t *)arg;
+
+    for (;;) {
+        size_t index = atomic_fetch_add(&pool->next_job, 1);
+        if (index >= pool->job_count) {
+            break;
+        }
+
+        job_t * job = &pool->jobs[index];
+        job->ret = run_job(job, pool->default_protocol);
+    }
+
+    return NULL;
+}
+
+static bool path_list_add(path_list_t *list, const char *path) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 64;
+        char ** paths = realloc(list->paths, capacity * sizeof(char *));
+        if (!paths) {
+            return false;
+        }
+        list->paths = paths;
+        list->capacity = capacity;
+    }
+
+    list->paths[list->count] = strdup(path);
+    return list->paths[list->count++] != NULL;
+}
+
+static bool has_suffix(const char *str, const char *suffix) {
+    size_t str_len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+    return (str_len >= suffix_len) && (strcmp(&str[str_len - suffix_len], suffix) == 0);
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Adds every capture file in the directory, sorted by name so the report doesn't depend on the directory order. */
+static bool path_list_add_dir(path_list_t *list, const char *dir_path) {
+    DIR * dir = opendir(dir_path);
+    if (!dir) {
+        perror(dir_path);
+        return false;
+    }
+
+    size_t first = list->count;
+    struct dirent * entry = NULL;
+    bool ok = true;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        if (!has_suffix(entry->d_name, ".pcapng") && !has_suffix(entry->d_name, ".pcapng.gz")) {
+            continue;
+        }
+
+        size_t path_len = strlen(dir_path) + 1 + strlen(entry->d_name) + 1;
+        char * path = malloc(path_len);
+        if (!path) {
+            ok = false;
+            break;
+        }
+        snprintf(path, path_len, "%s/%s", dir_path, entry->d_name);
+        ok = path_list_add(list, path);
+        free(path);
+    }
+    closedir(dir);
+
+    qsort(&list->paths[first], list->count - first, sizeof(char *), compare_paths);
+
+    return ok;
+}
+
+static mct_device_totals_t * totals_lookup(batch_totals_t *totals, size_t *count, const char *path, const mct_device_stats_t *device) {
+    const char * device_path = device->serial[0] ? NULL : path;
+    for (size_t i = 0; i < *count; i++) {
+        mct_device_totals_t * entry = &totals[i].totals;
+        if ((entry->protocol != device->protocol) || (entry->vid != device->vid) || (entry->pid != device->pid)) {
+            continue;
+        }
+
+        if (device_path ? ((totals[i].path == device_path) && (entry->device_id == device->device_id)) :
+            (!totals[i].path && (strcmp(entry->serial, device->serial) == 0))) {
+            return entry;
+        }
+    }
+
+    batch_totals_t * new_totals = &totals[(*count)++];
+    memset(new_totals, 0, sizeof(*new_totals));
+    new_totals->path = device_path;
+    return &new_totals->totals;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-j jobs] [-t t5|t6] [-v] <capture|directory>...\n", argv0);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -j jobs   Number of captures to analyze at the same time (default: number of CPUs).\n");
+    fprintf(stderr, "  -t t5|t6  Protocol to assume for devices whose device descriptor wasn't captured.\n");
+    fprintf(stderr, "  -v        Also print the report for each device in each capture.\n");
+}
+
+int main(int argc, char **argv) {
+    mct_protocol_t default_protocol = MCT_PROTOCOL_UNKNOWN;
+    long job_limit = sysconf(_SC_NPROCESSORS_ONLN);
+    bool verbose = false;
+
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "hj:t:v")) != -1) {
+        switch (opt) {
+            case 'j':
+                job_limit = strtol(optarg, NULL, 0);
+                if (job_limit < 1) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 't':
+                if (strcmp(optarg, "t5") == 0) {
+                    default_protocol = MCT_PROTOCOL_T5;
+                } else if (strcmp(optarg, "t6") == 0) {
+                    default_protocol = MCT_PROTOCOL_T6;
+                } else {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    path_list_t paths = { 0 };
+    for (int i = optind; i < argc; i++) {
+        struct stat st;
+        bool ok = (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) ? path_list_add_dir(&paths, argv[i]) :
+            path_list_add(&paths, argv[i]);
+        if (!ok) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    pool_t pool = { 0 };
+    pool.job_count = paths.count;
+    pool.default_protocol = default_protocol;
+    atomic_init(&pool.next_job, 0);
+    pool.jobs = calloc(paths.count ? paths.count : 1, sizeof(job_t));
+    if (!pool.jobs) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < paths.count; i++) {
+        pool.jobs[i].path = paths.paths[i];
+    }
+
+    size_t thread_count = ((size_t)job_limit < paths.count) ? (size_t)job_limit : paths.count;
+    pthread_t * threads = calloc(thread_count ? thread_count : 1, sizeof(pthread_t));
+    if (!threads) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    size_t started = 0;
+    for (; started < thread_count; started++) {
+        if (pthread_create(&threads[started], NULL, worker, &pool) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        /* Couldn't start any threads, so do all the work here. */
+        worker(&pool);
+    }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Every capture can add at most MCT_ANALYSIS_MAX_DEVICES adapters. */
+    batch_totals_t * totals = calloc(paths.count * MCT_ANALYSIS_MAX_DEVICES + 1, sizeof(batch_totals_t));
+    if (!totals) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+    size_t totals_count = 0;
+
+    int failures = 0;
+    uint64_t packets = 0;
+    for (size_t i = 0; i < paths.count; i++) {
+        const job_t * job = &pool.jobs[i];
+        packets += job->analysis.packets;
+
+        if (job->ret < 0) {
+            fprintf(stderr, "%s: Not a valid pcapng file, or it's truncated\n", job->path);
+            failures++;
+        }
+
+        if (verbose) {
+            printf("%s: %" PRIu64 " packets\n", job->path, job->analysis.packets);
+            mct_analysis_print(&job->analysis, stdout);
+        }
+
+        for (uint32_t j = 0; j < job->analysis.device_count; j++) {
+            const mct_device_stats_t * device = &job->analysis.devices[j];
+            if (mct_device_reportable(device)) {
+                mct_device_totals_add(totals_lookup(totals, &totals_count, job->path, device), device);
+            }
+        }
+    }
+
+    printf("%zu captures, %" PRIu64 " packets, %d failed\n", paths.count, packets, failures);
+    for (size_t i = 0; i < totals_count; i++) {
+        const mct_device_totals_t * entry = &totals[i].totals;
+        char title[512];
+        if (!totals[i].path) {
+            snprintf(title, sizeof(title), "Adapter %04x:%04x, serial %s: %s, %u captures", entry->vid, entry->pid,
+                entry->serial, mct_protocol_name(entry->protocol), entry->devices);
+        } else {
+            snprintf(title, sizeof(title), "Unidentified adapter %04x:%04x at %u.%u in %s: %s", entry->vid, entry->pid,
+                entry->device_id >> 16, entry->device_id & 0xFFFF, totals[i].path, mct_protocol_name(entry->protocol));
+        }
+        mct_device_totals_print(entry, title, stdout);
+    }
+
+    for (size_t i = 0; i < paths.count; i++) {
+        free(paths.paths[i]);
+    }
+    free(paths.paths);
+    free(pool.jobs);
+    free(threads);
+    free(totals);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_bulk_pool.c - A pool of preallocated, pipelined libusb bulk OUT transfers.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libusb.h>
+
+#include "mct_bulk_pool.h"
+
+
+static void LIBUSB_CALL transfer_done(struct libusb_transfer *transfer) {
+    mct_bulk_slot_t * slot = transfer->user_data;
+    mct_bulk_pool_t * pool = slot->pool;
+
+    slot->busy = false;
+    pool->in_flight--;
+
+    if ((transfer->status != LIBUSB_TRANSFER_COMPLETED) || (transfer->actual_length != transfer->length)) {
+        if (!pool->failed) {
+            pool->failed = true;
+            pool->failed_status = transfer->status;
+        }
+        return;
+    }
+
+    pool->transfers++;
+    pool->bytes += transfer->actual_length;
+}
+
+/* Returns 0 on success or -1 if the arguments are out of range or the transfers couldn't be allocated. */
+int mct_bulk_pool_init(mct_bulk_pool_t *pool, libusb_context *ctx, libusb_device_handle *handle, uint8_t endpoint,
+    uint32_t slot_count, uint32_t slot_size) {
+    memset(pool, 0, sizeof(*pool));
+    if ((slot_count == 0) || (slot_count > MCT_BULK_POOL_MAX_SLOTS) || (slot_size == 0)) {
+        return -1;
+    }
+
+    pool->ctx = ctx;
+    pool->handle = handle;
+    pool->endpoint = endpoint;
+    pool->timeout_ms = 5000;
+    pool->slot_count = slot_count;
+    pool->slot_size = slot_size;
+
+    for (uint32_t i = 0; i < slot_count; i++) {
+        mct_bulk_slot_t * slot = &pool->slots[i];
+        slot->pool = pool;
+        slot->buf = malloc(slot_size);
+        slot->transfer = libusb_alloc_transfer(0);
+        if (!slot->buf || !slot->transfer) {
+            mct_bulk_pool_free(pool);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Should only be called after mct_bulk_pool_drain(). The slots that are somehow still in flight are leaked, since
+ * libusb still owns their transfers. */
+void mct_bulk_pool_free(mct_bulk_pool_t *pool) {
+    for (uint32_t i = 0; i < pool->slot_count; i++) {
+        if (pool->slots[i].busy) {
+            continue;
+        }
+        libusb_free_transfer(pool->slots[i].transfer);
+        free(pool->slots[i].buf);
+        pool->slots[i].transfer = NULL;
+        pool->slots[i].buf = NULL;
+    }
+    pool->slot_count = 0;
+}
+
+static bool handle_events(mct_bulk_pool_t *pool) {
+    int ret = libusb_handle_events(pool->ctx);
+    if ((ret < 0) && (ret != LIBUSB_ERROR_INTERRUPTED)) {
+        if (!pool->failed) {
+            pool->failed = true;
+            pool->failed_status = LIBUSB_TRANSFER_ERROR;
+        }
+        return false;
+    }
+    return true;
+}
+
+/* Returns the free part of the slot being filled, waiting for its previous transfer to complete if it's still in
+ * flight, or NULL if a transfer has failed. */
+uint8_t * mct_bulk_pool_space(mct_bulk_pool_t *pool, uint32_t *avail) {
+    mct_bulk_slot_t * slot = &pool->slots[pool->next_slot];
+    while (slot->busy && !pool->failed) {
+        if (!handle_events(pool)) {
+            break;
+        }
+    }
+
+    if (pool->failed) {
+        *avail = 0;
+        return NULL;
+    }
+
+    *avail = pool->slot_size - slot->len;
+    return &slot->buf[slot->len];
+}
+
+static bool submit_slot(mct_bulk_pool_t *pool, mct_bulk_slot_t *slot) {
+    libusb_fill_bulk_transfer(slot->transfer, pool->handle, pool->endpoint, slot->buf, slot->len, transfer_done, slot,
+        pool->timeout_ms);
+    if (libusb_submit_transfer(slot->transfer) != 0) {
+        pool->failed = true;
+        pool->failed_status = LIBUSB_TRANSFER_ERROR;
+        return false;
+    }
+
+    /* Until the transfer completes, the slot is empty but can't be filled. */
+    slot->busy = true;
+    slot->len = 0;
+    pool->in_flight++;
+    return true;
+}
+
+/* Submits the ended slots, oldest first, and then the slot being filled if anything has been written into it. */
+static bool submit(mct_bulk_pool_t *pool) {
+    if (pool->failed) {
+        return false;
+    }
+
+    for (; pool->pending > 0; pool->pending--) {
+        uint32_t index = (pool->next_slot + pool->slot_count - pool->pending) % pool->slot_count;
+        if (!submit_slot(pool, &pool->slots[index])) {
+            return false;
+        }
+    }
+
+    mct_bulk_slot_t * slot = &pool->slots[pool->next_slot];
+    if (slot->len == 0) {
+        return true;
+    }
+    if (!submit_slot(pool, slot)) {
+        return false;
+    }
+    pool->next_slot = (pool->next_slot + 1) % pool->slot_count;
+    return true;
+}
+
+/* Adds len bytes that were written into the space returned by mct_bulk_pool_space() to the stream, submitting the slot
+ * if it's full. */
+bool mct_bulk_pool_commit(mct_bulk_pool_t *pool, uint32_t len) {
+    mct_bulk_slot_t * slot = &pool->slots[pool->next_slot];
+    slot->len += len;
+    if (slot->len < pool->slot_size) {
+        return true;
+    }
+    return submit(pool);
+}
+
+bool mct_bulk_pool_write(mct_bulk_pool_t *pool, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        uint32_t avail = 0;
+        uint8_t * space = mct_bulk_pool_space(pool, &avail);
+        if (!space) {
+            return false;
+        }
+
+        uint32_t chunk = (len < avail) ? (uint32_t)len : avail;
+        memcpy(space, data, chunk);
+        if (!mct_bulk_pool_commit(pool, chunk)) {
+            return false;
+        }
+        data += chunk;
+        len -= chunk;
+    }
+
+    return true;
+}
+
+/* Ends the transfer in the slot being filled, even if it isn't full, so the next write starts a new one, but leaves it
+ * to be submitted along with the following transfers by the next flush (or once every slot has been ended). */
+bool mct_bulk_pool_end_transfer(mct_bulk_pool_t *pool) {
+    if (pool->failed) {
+        return false;
+    }
+    if (pool->slots[pool->next_slot].len == 0) {
+        return true;
+    }
+
+    pool->pending++;
+    pool->next_slot = (pool->next_slot + 1) % pool->slot_count;
+    if (pool->pending == pool->slot_count) {
+        /* The next slot to fill is the oldest ended one. */
+        return submit(pool);
+    }
+    return true;
+}
+
+/* Submits the slot being filled, even if it isn't full, so the next write starts a new transfer. */
+bool mct_bulk_pool_flush(mct_bulk_pool_t *pool) {
+    return submit(pool);
+}
+
+/* Flushes the stream and waits for every transfer to complete. Returns false if any of them failed. */
+bool mct_bulk_pool_drain(mct_bulk_pool_t *pool) {
+    submit(pool);
+    while (pool->in_flight > 0) {
+        if (!handle_events(pool)) {
+            break;
+        }
+    }
+    return !pool->failed;
+}
+
+const char * mct_bulk_pool_status_name(enum libusb_transfer_status status) {
+    switch (status) {
+        case LIBUSB_TRANSFER_COMPLETED:
+            return "Short write";
+        case LIBUSB_TRANSFER_ERROR:
+            return "Transfer error";
+        case LIBUSB_TRANSFER_TIMED_OUT:
+            return "Timed out";
+        case LIBUSB_TRANSFER_CANCELLED:
+            return "Cancelled";
+        case LIBUSB_TRANSFER_STALL:
+            return "Endpoint stalled";
+        case LIBUSB_TRANSFER_NO_DEVICE:
+            return "Device disconnected";
+        case LIBUSB_TRANSFER_OVERFLOW:
+            return "Overflow";
+        default:
+            return "Unknown";
+    }
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_bulk_pool.h - A pool of preallocated, pipelined libusb bulk OUT transfers.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_BULK_POOL_H_INCLUDED
+#define MCT_BULK_POOL_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libusb.h>
+
+#define MCT_BULK_POOL_MAX_SLOTS 32
+
+struct mct_bulk_pool_s;
+
+typedef struct mct_bulk_slot_s {
+    struct mct_bulk_pool_s * pool;
+    struct libusb_transfer * transfer;
+    uint8_t * buf;
+    uint32_t len;
+    bool busy;
+} mct_bulk_slot_t;
+
+/* The bulk stream is written into the slots in turn, and each one is submitted once it's full or the stream is
+ * flushed, so up to slot_count transfers are in flight while the next one is being filled. Since the slots are reused
+ * in the same order, they also complete in that order, and the buffers are only ever allocated once. A slot can also
+ * be ended without submitting it, so that several transfers (e.g., a header and the data it describes) are submitted
+ * together by the next flush. */
+typedef struct mct_bulk_pool_s {
+    libusb_context * ctx;
+    libusb_device_handle * handle;
+    uint8_t endpoint;
+    unsigned int timeout_ms;
+
+    uint32_t slot_count;
+    uint32_t slot_size;
+    mct_bulk_slot_t slots[MCT_BULK_POOL_MAX_SLOTS];
+    uint32_t next_slot;
+    /* The slots right before next_slot that were ended but not submitted yet. */
+    uint32_t pending;
+    uint32_t in_flight;
+
+    /* The status of the first transfer that failed or was cut short, after which nothing else is submitted. */
+    bool failed;
+    enum libusb_transfer_status failed_status;
+
+    uint64_t transfers;
+    uint64_t bytes;
+} mct_bulk_pool_t;
+
+int mct_bulk_pool_init(mct_bulk_pool_t *pool, libusb_context *ctx, libusb_device_handle *handle, uint8_t endpoint,
+    uint32_t slot_count, uint32_t slot_size);
+void mct_bulk_pool_free(mct_bulk_pool_t *pool);
+
+uint8_t * mct_bulk_pool_space(mct_bulk_pool_t *pool, uint32_t *avail);
+bool mct_bulk_pool_commit(mct_bulk_pool_t *pool, uint32_t len);
+bool mct_bulk_pool_write(mct_bulk_pool_t *pool, const uint8_t *data, size_t len);
+bool mct_bulk_pool_end_transfer(mct_bulk_pool_t *pool);
+bool mct_bulk_pool_flush(mct_bulk_pool_t *pool);
+bool mct_bulk_pool_drain(mct_bulk_pool_t *pool);
+const char * mct_bulk_pool_status_name(enum libusb_transfer_status status);
+
+#endif // MCT_BULK_POOL_H_INCLUDED
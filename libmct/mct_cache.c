@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_cache.c - On-disk cache of what an adapter reports about itself and its monitor.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mct_cache.h"
+#include "mct_le.h"
+
+/* The file format is the magic, the format version, and then the key, info, modes, and EDID, each as a 32-bit length
+ * followed by that many bytes. All integers are little-endian. */
+static const uint8_t CACHE_MAGIC[8] = { 'M', 'C', 'T', 'C', 'A', 'C', 'H', 'E' };
+#define CACHE_FORMAT_VERSION 1
+
+#define CACHE_PATH_MAX_LEN 4096
+
+
+/* Writes the directory the clients cache adapters in by default to buf, returning its length, or 0 if there's no
+ * home directory to put it in. */
+size_t mct_cache_default_dir(char *buf, size_t len) {
+    const char * xdg_cache_home = getenv("XDG_CACHE_HOME");
+    const char * home = getenv("HOME");
+
+    int ret = -1;
+    if (xdg_cache_home && (xdg_cache_home[0] == '/')) {
+        ret = snprintf(buf, len, "%s/mct-usb-display-adapter", xdg_cache_home);
+    } else if (home && (home[0] != '\0')) {
+        ret = snprintf(buf, len, "%s/.cache/mct-usb-display-adapter", home);
+    }
+
+    if ((ret < 0) || ((size_t)ret >= len)) {
+        return 0;
+    }
+    return ret;
+}
+
+/* Keys are used as file names, so they're limited to characters that are safe in one. */
+bool mct_cache_key_valid(const char *key) {
+    size_t len = strlen(key);
+    if ((len == 0) || (len >= MCT_CACHE_KEY_MAX_LEN) || (key[0] == '.')) {
+        return false;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        char c = key[i];
+        if (!(((c >= '0') && (c <= '9')) || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || (c == '-') ||
+            (c == '_') || (c == '.'))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool cache_path(const char *dir, const char *key, const char *suffix, char path[CACHE_PATH_MAX_LEN]) {
+    if (!mct_cache_key_valid(key)) {
+        return false;
+    }
+
+    int ret = snprintf(path, CACHE_PATH_MAX_LEN, "%s/%s%s", dir, key, suffix);
+    return (ret > 0) && (ret < CACHE_PATH_MAX_LEN);
+}
+
+static bool read_field(FILE *file, uint8_t *buf, uint32_t max_len, uint32_t *len) {
+    uint8_t len_buf[4];
+    if (fread(len_buf, 1, sizeof(len_buf), file) != sizeof(len_buf)) {
+        return false;
+    }
+
+    *len = mct_le32(len_buf);
+    return (*len <= max_len) && (fread(buf, 1, *len, file) == *len);
+}
+
+static bool write_field(FILE *file, const uint8_t *buf, uint32_t len) {
+    uint8_t len_buf[4];
+    mct_set_le32(len_buf, len);
+    return (fwrite(len_buf, 1, sizeof(len_buf), file) == sizeof(len_buf)) && (fwrite(buf, 1, len, file) == len);
+}
+
+/* Loads the entry for key from dir. Returns false, leaving an empty entry for key, if there's no entry for it, or if
+ * the entry can't be used (it's truncated, from a different format version, or stored under a different key). */
+bool mct_cache_load(const char *dir, const char *key, mct_cache_entry_t *entry) {
+    /* The key can be the entry's own, so it's copied before the entry is cleared. */
+    char entry_key[MCT_CACHE_KEY_MAX_LEN];
+    snprintf(entry_key, sizeof(entry_key), "%s", key);
+    key = entry_key;
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->key, sizeof(entry->key), "%s", key);
+
+    char path[CACHE_PATH_MAX_LEN];
+    if (!cache_path(dir, key, ".bin", path)) {
+        return false;
+    }
+
+    FILE * file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    uint8_t header[sizeof(CACHE_MAGIC) + 4];
+    uint32_t key_len = 0;
+    bool ok = (fread(header, 1, sizeof(header), file) == sizeof(header)) &&
+        (memcmp(header, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0) &&
+        (mct_le32(&header[sizeof(CACHE_MAGIC)]) == CACHE_FORMAT_VERSION) &&
+        read_field(file, (uint8_t *)entry->key, MCT_CACHE_KEY_MAX_LEN - 1, &key_len) &&
+        read_field(file, entry->info, sizeof(entry->info), &entry->info_len) &&
+        read_field(file, entry->modes, sizeof(entry->modes), &entry->modes_len) &&
+        read_field(file, entry->edid, sizeof(entry->edid), &entry->edid_len) &&
+        (fgetc(file) == EOF);
+    fclose(file);
+
+    if (ok) {
+        entry->key[key_len] = '\0';
+        ok = strcmp(entry->key, key) == 0;
+    }
+    if (!ok) {
+        memset(entry, 0, sizeof(*entry));
+        snprintf(entry->key, sizeof(entry->key), "%s", key);
+    }
+
+    return ok;
+}
+
+/* Saves the entry to dir, creating dir (but not its parents, other than the user's cache directory) if it doesn't
+ * exist. The entry is written to a temporary file that then replaces the old one, so a client that's interrupted
+ * while saving never leaves a truncated entry behind. Returns 0 on success, or -1 with errno set on error. */
+int mct_cache_save(const char *dir, const mct_cache_entry_t *entry) {
+    char path[CACHE_PATH_MAX_LEN];
+    char tmp_path[CACHE_PATH_MAX_LEN];
+    if (!cache_path(dir, entry->key, ".bin", path) || !cache_path(dir, entry->key, ".tmp", tmp_path)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((mkdir(dir, 0755) != 0) && (errno == ENOENT)) {
+        /* Most likely ~/.cache on a fresh account. */
+        char parent[CACHE_PATH_MAX_LEN];
+        snprintf(parent, sizeof(parent), "%s", dir);
+        char * slash = strrchr(parent, '/');
+        if (slash && (slash != parent)) {
+            *slash = '\0';
+            mkdir(parent, 0700);
+        }
+        mkdir(dir, 0755);
+    }
+
+    FILE * file = fopen(tmp_path, "wb");
+    if (!file) {
+        return -1;
+    }
+
+    uint8_t header[sizeof(CACHE_MAGIC) + 4];
+    memcpy(header, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    mct_set_le32(&header[sizeof(CACHE_MAGIC)], CACHE_FORMAT_VERSION);
+    bool ok = (fwrite(header, 1, sizeof(header), file) == sizeof(header)) &&
+        write_field(file, (const uint8_t *)entry->key, strlen(entry->key)) &&
+        write_field(file, entry->info, entry->info_len) &&
+        write_field(file, entry->modes, entry->modes_len) &&
+        write_field(file, entry->edid, entry->edid_len);
+    int saved_errno = errno;
+    if ((fclose(file) != 0) && ok) {
+        saved_errno = errno;
+        ok = false;
+    }
+
+    if (ok && (rename(tmp_path, path) != 0)) {
+        saved_errno = errno;
+        ok = false;
+    }
+    if (!ok) {
+        unlink(tmp_path);
+        errno = saved_errno;
+        return -1;
+    }
+
+    return 0;
+}
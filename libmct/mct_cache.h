@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_cache.h - On-disk cache of what an adapter reports about itself and its monitor.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_CACHE_H_INCLUDED
+#define MCT_CACHE_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mct_edid.h"
+
+#define MCT_CACHE_KEY_MAX_LEN 64
+#define MCT_CACHE_INFO_MAX_LEN 64
+
+/* Enough for 128 T6 modes, the most a T6 client reads. */
+#define MCT_CACHE_MODES_MAX_LEN 4096
+
+#define MCT_CACHE_EDID_MAX_LEN (MCT_EDID_MAX_BLOCKS * MCT_EDID_BLOCK_LEN)
+
+/* What a client has to read from an adapter before it can start streaming, stored under a key that changes whenever
+ * any of it could have (the adapter's serial number and firmware version). The EDID belongs to whatever monitor was
+ * connected last, so it's only used if its first block still matches what the monitor returns. */
+typedef struct mct_cache_entry_s {
+    char key[MCT_CACHE_KEY_MAX_LEN];
+
+    /* Anything else the client only ever reads once, like the T6 hardware platform and video RAM size, in whatever
+     * layout the client uses. */
+    uint32_t info_len;
+    uint8_t info[MCT_CACHE_INFO_MAX_LEN];
+
+    /* The mode table, as returned by the adapter. */
+    uint32_t modes_len;
+    uint8_t modes[MCT_CACHE_MODES_MAX_LEN];
+
+    uint32_t edid_len;
+    uint8_t edid[MCT_CACHE_EDID_MAX_LEN];
+} mct_cache_entry_t;
+
+size_t mct_cache_default_dir(char *buf, size_t len);
+bool mct_cache_key_valid(const char *key);
+
+bool mct_cache_load(const char *dir, const char *key, mct_cache_entry_t *entry);
+int mct_cache_save(const char *dir, const mct_cache_entry_t *entry);
+
+#endif // MCT_CACHE_H_INCLUDED
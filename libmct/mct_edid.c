@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_edid.c - Reassembly and parsing of monitor EDIDs read through MCT's display adapters.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mct_edid.h"
+#include "mct_le.h"
+
+
+static const uint8_t EDID_HEADER[8] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+
+bool mct_edid_header_valid(const uint8_t block[MCT_EDID_BLOCK_LEN]) {
+    return memcmp(block, EDID_HEADER, sizeof(EDID_HEADER)) == 0;
+}
+
+bool mct_edid_block_checksum_valid(const uint8_t block[MCT_EDID_BLOCK_LEN]) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < MCT_EDID_BLOCK_LEN; i++) {
+        sum += block[i];
+    }
+    return sum == 0;
+}
+
+void mct_edid_assembly_reset(mct_edid_assembly_t *assembly) {
+    assembly->blocks_present = 0;
+}
+
+/* Adds a block to the EDID, returning the length of the whole EDID once the base block and every extension block it
+ * announces have been read, or 0 if some are still missing. Blocks past MCT_EDID_MAX_BLOCKS are ignored. */
+size_t mct_edid_assembly_add_block(mct_edid_assembly_t *assembly, uint32_t block_num,
+    const uint8_t block[MCT_EDID_BLOCK_LEN]) {
+    if (block_num >= MCT_EDID_MAX_BLOCKS) {
+        return 0;
+    }
+
+    if (block_num == 0) {
+        mct_edid_assembly_reset(assembly);
+    }
+
+    memcpy(&assembly->data[block_num * MCT_EDID_BLOCK_LEN], block, MCT_EDID_BLOCK_LEN);
+    assembly->blocks_present |= 1u << block_num;
+
+    if (!(assembly->blocks_present & 1)) {
+        return 0;
+    }
+
+    uint32_t block_count = 1 + assembly->data[126];
+    if (block_count > MCT_EDID_MAX_BLOCKS) {
+        block_count = MCT_EDID_MAX_BLOCKS;
+    }
+
+    uint32_t blocks_needed = (1u << block_count) - 1;
+    if ((assembly->blocks_present & blocks_needed) != blocks_needed) {
+        return 0;
+    }
+
+    return block_count * MCT_EDID_BLOCK_LEN;
+}
+
+/* Returns false if the 18 bytes are a display descriptor rather than a detailed timing. */
+bool mct_edid_detailed_timing_parse(const uint8_t buf[MCT_EDID_DETAILED_TIMING_LEN], mct_edid_detailed_timing_t *timing) {
+    uint16_t pixel_clock_10khz = mct_le16(&buf[0]);
+    if (pixel_clock_10khz == 0) {
+        return false;
+    }
+
+    timing->pixel_clock_khz = pixel_clock_10khz * 10;
+    timing->h_active = buf[2] | ((buf[4] & 0xF0) << 4);
+    timing->h_blank = buf[3] | ((buf[4] & 0x0F) << 8);
+    timing->v_active = buf[5] | ((buf[7] & 0xF0) << 4);
+    timing->v_blank = buf[6] | ((buf[7] & 0x0F) << 8);
+    timing->h_front_porch = buf[8] | ((buf[11] & 0xC0) << 2);
+    timing->h_sync_width = buf[9] | ((buf[11] & 0x30) << 4);
+    timing->v_front_porch = (buf[10] >> 4) | ((buf[11] & 0x0C) << 2);
+    timing->v_sync_width = (buf[10] & 0x0F) | ((buf[11] & 0x03) << 4);
+    timing->interlaced = (buf[17] & 0x80) != 0;
+
+    return true;
+}
+
+/* For interlaced timings this is the field rate, since v_active is the number of lines in each field. */
+double mct_edid_detailed_timing_refresh_rate_hz(const mct_edid_detailed_timing_t *timing) {
+    uint32_t h_total = timing->h_active + timing->h_blank;
+    uint32_t v_total = timing->v_active + timing->v_blank;
+    if (h_total == 0 || v_total == 0) {
+        return 0;
+    }
+    return timing->pixel_clock_khz * 1e3 / (h_total * v_total);
+}
+
+static void parse_descriptor_text(const uint8_t *buf, char text[14]) {
+    size_t len = 0;
+    while ((len < 13) && (buf[len] != 0x0A)) {
+        text[len] = ((buf[len] >= 0x20) && (buf[len] < 0x7F)) ? (char)buf[len] : '?';
+        len++;
+    }
+    while ((len > 0) && (text[len - 1] == ' ')) {
+        len--;
+    }
+    text[len] = '\0';
+}
+
+static void add_detailed_timing(mct_edid_info_t *info, const mct_edid_detailed_timing_t *timing) {
+    if (timing->pixel_clock_khz > info->max_timing_pixel_clock_khz) {
+        info->max_timing_pixel_clock_khz = timing->pixel_clock_khz;
+    }
+}
+
+/* Parses the base block and the CTA-861 extension blocks of an EDID. buf must hold at least the base block. */
+void mct_edid_parse(const uint8_t *buf, size_t len, mct_edid_info_t *info) {
+    memset(info, 0, sizeof(*info));
+
+    uint16_t manufacturer = (buf[8] << 8) | buf[9];
+    info->manufacturer[0] = '@' + ((manufacturer >> 10) & 0x1F);
+    info->manufacturer[1] = '@' + ((manufacturer >> 5) & 0x1F);
+    info->manufacturer[2] = '@' + (manufacturer & 0x1F);
+    info->manufacturer[3] = '\0';
+    info->product_code = mct_le16(&buf[10]);
+    info->serial_number = mct_le32(&buf[12]);
+    info->version = buf[18];
+    info->revision = buf[19];
+    info->extension_count = buf[126];
+
+    /* The first descriptor is the preferred timing. */
+    for (size_t offset = 54; offset < 126; offset += MCT_EDID_DETAILED_TIMING_LEN) {
+        mct_edid_detailed_timing_t timing;
+        if (mct_edid_detailed_timing_parse(&buf[offset], &timing)) {
+            if (offset == 54) {
+                info->has_preferred_timing = true;
+                info->preferred_timing = timing;
+            }
+            add_detailed_timing(info, &timing);
+        } else if (buf[offset + 3] == MCT_EDID_DESCRIPTOR_TAG_PRODUCT_NAME) {
+            parse_descriptor_text(&buf[offset + 5], info->product_name);
+        } else if (buf[offset + 3] == MCT_EDID_DESCRIPTOR_TAG_RANGE_LIMITS) {
+            info->max_pixel_clock_khz = buf[offset + 9] * 10000;
+        }
+    }
+
+    for (size_t block = MCT_EDID_BLOCK_LEN; block + MCT_EDID_BLOCK_LEN <= len; block += MCT_EDID_BLOCK_LEN) {
+        const uint8_t * ext = &buf[block];
+        if (ext[0] != MCT_EDID_EXTENSION_TAG_CTA) {
+            continue;
+        }
+
+        /* Byte 2 is the offset of the first detailed timing, or 0 if there aren't any. */
+        for (size_t offset = ext[2]; (offset >= 4) && (offset + MCT_EDID_DETAILED_TIMING_LEN < MCT_EDID_BLOCK_LEN);
+            offset += MCT_EDID_DETAILED_TIMING_LEN) {
+            mct_edid_detailed_timing_t timing;
+            if (!mct_edid_detailed_timing_parse(&ext[offset], &timing)) {
+                break;
+            }
+            add_detailed_timing(info, &timing);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_edid.h - Reassembly and parsing of monitor EDIDs read through MCT's display adapters.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_EDID_H_INCLUDED
+#define MCT_EDID_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MCT_EDID_BLOCK_LEN 128
+#define MCT_EDID_DETAILED_TIMING_LEN 18
+
+/* The base block and up to seven extension blocks. Monitors with more than that haven't been seen. */
+#define MCT_EDID_MAX_BLOCKS 8
+
+#define MCT_EDID_EXTENSION_TAG_CTA 0x02
+#define MCT_EDID_EXTENSION_TAG_VTB 0x10
+#define MCT_EDID_EXTENSION_TAG_DI 0x40
+#define MCT_EDID_EXTENSION_TAG_LS 0x50
+#define MCT_EDID_EXTENSION_TAG_DPVL 0x60
+#define MCT_EDID_EXTENSION_TAG_DISPLAYID 0x70
+#define MCT_EDID_EXTENSION_TAG_BLOCK_MAP 0xF0
+#define MCT_EDID_EXTENSION_TAG_MANUFACTURER 0xFF
+
+#define MCT_EDID_DESCRIPTOR_TAG_PRODUCT_NAME 0xFC
+#define MCT_EDID_DESCRIPTOR_TAG_RANGE_LIMITS 0xFD
+
+/* The blocks of an EDID as they're read, one control request at a time. Reading block 0 starts a new EDID, since
+ * that's what the driver does after a monitor is connected. */
+typedef struct mct_edid_assembly_s {
+    uint8_t data[MCT_EDID_MAX_BLOCKS * MCT_EDID_BLOCK_LEN];
+    uint32_t blocks_present;
+} mct_edid_assembly_t;
+
+typedef struct mct_edid_detailed_timing_s {
+    uint32_t pixel_clock_khz;
+    uint16_t h_active;
+    uint16_t h_blank;
+    uint16_t h_front_porch;
+    uint16_t h_sync_width;
+    uint16_t v_active;
+    uint16_t v_blank;
+    uint16_t v_front_porch;
+    uint16_t v_sync_width;
+    bool interlaced;
+} mct_edid_detailed_timing_t;
+
+typedef struct mct_edid_info_s {
+    char manufacturer[4];
+    uint16_t product_code;
+    uint32_t serial_number;
+    uint8_t version;
+    uint8_t revision;
+    uint8_t extension_count;
+    char product_name[14];
+
+    bool has_preferred_timing;
+    mct_edid_detailed_timing_t preferred_timing;
+
+    /* From the display range limits descriptor, or 0 if there isn't one. */
+    uint32_t max_pixel_clock_khz;
+
+    /* The highest pixel clock of all the detailed timings in the base block and the CTA-861 extensions. */
+    uint32_t max_timing_pixel_clock_khz;
+} mct_edid_info_t;
+
+bool mct_edid_header_valid(const uint8_t block[MCT_EDID_BLOCK_LEN]);
+bool mct_edid_block_checksum_valid(const uint8_t block[MCT_EDID_BLOCK_LEN]);
+
+void mct_edid_assembly_reset(mct_edid_assembly_t *assembly);
+size_t mct_edid_assembly_add_block(mct_edid_assembly_t *assembly, uint32_t block_num,
+    const uint8_t block[MCT_EDID_BLOCK_LEN]);
+
+bool mct_edid_detailed_timing_parse(const uint8_t buf[MCT_EDID_DETAILED_TIMING_LEN], mct_edid_detailed_timing_t *timing);
+double mct_edid_detailed_timing_refresh_rate_hz(const mct_edid_detailed_timing_t *timing);
+
+void mct_edid_parse(const uint8_t *buf, size_t len, mct_edid_info_t *info);
+
+#endif // MCT_EDID_H_INCLUDED
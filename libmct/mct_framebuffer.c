@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_framebuffer.c - A framebuffer that replays the screen updates sent to MCT's display adapters.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mct_framebuffer.h"
+#include "mct_le.h"
+#include "mct_t5.h"
+
+
+void mct_framebuffer_init(mct_framebuffer_t *fb) {
+    memset(fb, 0, sizeof(*fb));
+}
+
+void mct_framebuffer_free(mct_framebuffer_t *fb) {
+    free(fb->pixels);
+    mct_framebuffer_init(fb);
+}
+
+/* Changes the size of the framebuffer, keeping the part of the old contents that still fits and filling the rest with
+ * black. Returns 0 on success or -1 if the size is too large or the memory couldn't be allocated. */
+int mct_framebuffer_resize(mct_framebuffer_t *fb, uint32_t width, uint32_t height) {
+    if ((width == fb->width) && (height == fb->height)) {
+        return 0;
+    }
+
+    if ((width == 0) || (height == 0) || (width > MCT_FB_MAX_DIM) || (height > MCT_FB_MAX_DIM)) {
+        return -1;
+    }
+
+    uint32_t * pixels = calloc((size_t)width * height, sizeof(uint32_t));
+    if (!pixels) {
+        return -1;
+    }
+
+    uint32_t copy_width = (width < fb->width) ? width : fb->width;
+    uint32_t copy_height = (height < fb->height) ? height : fb->height;
+    for (uint32_t y = 0; y < copy_height; y++) {
+        memcpy(&pixels[(size_t)y * width], &fb->pixels[(size_t)y * fb->width], copy_width * sizeof(uint32_t));
+    }
+
+    free(fb->pixels);
+    fb->pixels = pixels;
+    fb->width = width;
+    fb->height = height;
+
+    return 0;
+}
+
+/* Decodes a T5 damage rectangle straight into the framebuffer, growing the framebuffer if the rectangle doesn't fit
+ * (which happens when the video mode that was set wasn't captured). */
+mct_t5_rect_status_t mct_framebuffer_draw_t5(mct_framebuffer_t *fb, const mct_t5_bulk_header_t *header,
+    const uint8_t *payload, size_t len) {
+    if (header->frame_flags & MCT_T5_BULK_FRAME_FLAG_COMPRESSED) {
+        return MCT_T5_RECT_COMPRESSED;
+    }
+
+    if ((header->width == 0) || (header->height == 0)) {
+        return MCT_T5_RECT_OK;
+    }
+
+    uint32_t right = header->horiz_offset + header->width;
+    uint32_t bottom = header->vert_offset + header->height;
+    if ((right > fb->width) || (bottom > fb->height)) {
+        if (mct_framebuffer_resize(fb, (right > fb->width) ? right : fb->width,
+            (bottom > fb->height) ? bottom : fb->height) != 0) {
+            return MCT_T5_RECT_OFF_SCREEN;
+        }
+    }
+
+    uint32_t * origin = &fb->pixels[(size_t)header->vert_offset * fb->width + header->horiz_offset];
+    return mct_t5_rect_decode(header, payload, len, origin, fb->width);
+}
+
+/* Replaces the cursor image with width by height BGRA pixels, stride bytes apart. Images larger than
+ * MCT_FB_CURSOR_MAX_DIM are cropped. */
+void mct_framebuffer_set_cursor(mct_framebuffer_t *fb, const uint8_t *bgra, uint32_t width, uint32_t height,
+    size_t stride) {
+    fb->cursor.width = (width < MCT_FB_CURSOR_MAX_DIM) ? width : MCT_FB_CURSOR_MAX_DIM;
+    fb->cursor.height = (height < MCT_FB_CURSOR_MAX_DIM) ? height : MCT_FB_CURSOR_MAX_DIM;
+
+    for (uint32_t y = 0; y < fb->cursor.height; y++) {
+        for (uint32_t x = 0; x < fb->cursor.width; x++) {
+            fb->cursor.pixels[y * MCT_FB_CURSOR_MAX_DIM + x] = mct_le32(&bgra[y * stride + x * 4]);
+        }
+    }
+}
+
+static uint32_t blend_channel(uint32_t dst, uint32_t src, uint32_t alpha, uint32_t shift) {
+    uint32_t d = (dst >> shift) & 0xFF;
+    uint32_t s = (src >> shift) & 0xFF;
+    return ((s * alpha + d * (255 - alpha) + 127) / 255) << shift;
+}
+
+/* Writes what the monitor shows, the framebuffer with the cursor (if visible) on top, to out, which must have room for
+ * width * height pixels. */
+void mct_framebuffer_render(const mct_framebuffer_t *fb, uint32_t *out) {
+    memcpy(out, fb->pixels, (size_t)fb->width * fb->height * sizeof(uint32_t));
+
+    if (!fb->cursor_visible) {
+        return;
+    }
+
+    for (uint32_t cy = 0; cy < fb->cursor.height; cy++) {
+        int64_t y = (int64_t)fb->cursor_y + cy;
+        if ((y < 0) || (y >= fb->height)) {
+            continue;
+        }
+
+        for (uint32_t cx = 0; cx < fb->cursor.width; cx++) {
+            int64_t x = (int64_t)fb->cursor_x + cx;
+            if ((x < 0) || (x >= fb->width)) {
+                continue;
+            }
+
+            uint32_t src = fb->cursor.pixels[cy * MCT_FB_CURSOR_MAX_DIM + cx];
+            uint32_t alpha = src >> 24;
+            uint32_t * dst = &out[(size_t)y * fb->width + x];
+            *dst = blend_channel(*dst, src, alpha, 16) | blend_channel(*dst, src, alpha, 8) |
+                blend_channel(*dst, src, alpha, 0);
+        }
+    }
+}
+
+/* Finds the smallest rectangle that covers every pixel that differs between two width by height images. Returns false
+ * if they're the same. */
+bool mct_fb_dirty_rect(const uint32_t *prev, const uint32_t *cur, uint32_t width, uint32_t height, mct_fb_rect_t *rect) {
+    size_t row_size = (size_t)width * sizeof(uint32_t);
+    uint32_t top = 0;
+    while ((top < height) && (memcmp(&prev[(size_t)top * width], &cur[(size_t)top * width], row_size) == 0)) {
+        top++;
+    }
+    if (top == height) {
+        return false;
+    }
+
+    uint32_t bottom = height - 1;
+    while (memcmp(&prev[(size_t)bottom * width], &cur[(size_t)bottom * width], row_size) == 0) {
+        bottom--;
+    }
+
+    /* Narrow the rectangle from both sides, only looking at the pixels outside of it in each row. */
+    uint32_t left = width;
+    uint32_t right = 0;
+    for (uint32_t y = top; y <= bottom; y++) {
+        const uint32_t * a = &prev[(size_t)y * width];
+        const uint32_t * b = &cur[(size_t)y * width];
+        uint32_t x = 0;
+        while ((x < left) && (a[x] == b[x])) {
+            x++;
+        }
+        if (x < left) {
+            left = x;
+        }
+
+        x = width - 1;
+        while ((x > right) && (a[x] == b[x])) {
+            x--;
+        }
+        if ((x > right) && (a[x] != b[x])) {
+            right = x;
+        }
+    }
+
+    rect->x = left;
+    rect->y = top;
+    rect->width = right - left + 1;
+    rect->height = bottom - top + 1;
+    return true;
+}
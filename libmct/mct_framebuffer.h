@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_framebuffer.h - A framebuffer that replays the screen updates sent to MCT's display adapters.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_FRAMEBUFFER_H_INCLUDED
+#define MCT_FRAMEBUFFER_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mct_t5.h"
+
+#define MCT_FB_MAX_DIM 8191
+#define MCT_FB_CURSOR_MAX_DIM 128
+
+/* Pixels are XRGB8888 (ARGB8888 with straight alpha for the cursor), i.e., BGRX (BGRA) in memory on little-endian
+ * hosts. */
+typedef struct mct_fb_cursor_s {
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixels[MCT_FB_CURSOR_MAX_DIM * MCT_FB_CURSOR_MAX_DIM];
+} mct_fb_cursor_t;
+
+typedef struct mct_fb_rect_s {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} mct_fb_rect_t;
+
+typedef struct mct_framebuffer_s {
+    uint32_t width;
+    uint32_t height;
+    uint32_t * pixels;
+
+    mct_fb_cursor_t cursor;
+    bool cursor_visible;
+    int32_t cursor_x;
+    int32_t cursor_y;
+} mct_framebuffer_t;
+
+void mct_framebuffer_init(mct_framebuffer_t *fb);
+void mct_framebuffer_free(mct_framebuffer_t *fb);
+int mct_framebuffer_resize(mct_framebuffer_t *fb, uint32_t width, uint32_t height);
+mct_t5_rect_status_t mct_framebuffer_draw_t5(mct_framebuffer_t *fb, const mct_t5_bulk_header_t *header,
+    const uint8_t *payload, size_t len);
+void mct_framebuffer_set_cursor(mct_framebuffer_t *fb, const uint8_t *bgra, uint32_t width, uint32_t height,
+    size_t stride);
+void mct_framebuffer_render(const mct_framebuffer_t *fb, uint32_t *out);
+
+bool mct_fb_dirty_rect(const uint32_t *prev, const uint32_t *cur, uint32_t width, uint32_t height, mct_fb_rect_t *rect);
+
+#endif // MCT_FRAMEBUFFER_H_INCLUDED
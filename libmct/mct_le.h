@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_le.h - Little-endian field access for libmct.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_LE_H_INCLUDED
+#define MCT_LE_H_INCLUDED
+
+#include <stdint.h>
+
+static inline uint16_t mct_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t mct_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t mct_le64(const uint8_t *p) {
+    return (uint64_t)mct_le32(p) | ((uint64_t)mct_le32(&p[4]) << 32);
+}
+
+static inline void mct_set_le16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+
+static inline void mct_set_le32(uint8_t *p, uint32_t value) {
+    mct_set_le16(&p[0], value & 0xFFFF);
+    mct_set_le16(&p[2], value >> 16);
+}
+
+#endif // MCT_LE_H_INCLUDED
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_pcapng.c - Streaming pcapng reader for libmct.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mct_le.h"
+#include "mct_pcapng.h"
+
+
+#define BLOCK_TYPE_IDB 0x00000001
+#define BLOCK_TYPE_SPB 0x00000003
+#define BLOCK_TYPE_EPB 0x00000006
+#define BLOCK_TYPE_SHB 0x0A0D0D0A
+
+#define BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define BYTE_ORDER_MAGIC_SWAPPED 0x4D3C2B1A
+
+#define OPT_ENDOFOPT 0
+#define OPT_IF_TSRESOL 9
+
+/* Nothing legitimately needs blocks this big, so treat them as corruption instead of trying to allocate them. */
+#define MAX_BLOCK_LEN (256 * 1024 * 1024)
+
+static uint16_t get16(const mct_pcapng_reader_t *reader, const uint8_t *p) {
+    uint16_t value = mct_le16(p);
+    return reader->swapped ? (uint16_t)((value >> 8) | (value << 8)) : value;
+}
+
+static uint32_t get32(const mct_pcapng_reader_t *reader, const uint8_t *p) {
+    uint32_t value = mct_le32(p);
+    if (reader->swapped) {
+        value = ((value >> 24) & 0xFF) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+    return value;
+}
+
+static bool read_exact(mct_pcapng_reader_t *reader, void *buf, size_t len) {
+    return reader->read(reader->ctx, buf, len) == len;
+}
+
+static bool reserve(mct_pcapng_reader_t *reader, size_t len) {
+    if (len <= reader->buf_size) {
+        return true;
+    }
+
+    uint8_t * buf = realloc(reader->buf, len);
+    if (!buf) {
+        return false;
+    }
+
+    reader->buf = buf;
+    reader->buf_size = len;
+
+    return true;
+}
+
+static uint64_t ts_units_from_tsresol(uint8_t tsresol) {
+    uint64_t units = 1;
+    uint8_t exponent = tsresol & 0x7F;
+
+    for (uint8_t i = 0; i < exponent; i++) {
+        units *= (tsresol & 0x80) ? 2 : 10;
+    }
+
+    return units;
+}
+
+static void parse_idb(mct_pcapng_reader_t *reader, const uint8_t *body, size_t len) {
+    if ((len < 8) || (reader->interface_count >= MCT_PCAPNG_MAX_INTERFACES)) {
+        return;
+    }
+
+    mct_pcapng_interface_t * interface = &reader->interfaces[reader->interface_count++];
+    interface->linktype = get16(reader, &body[0]);
+    interface->ts_units = 1000000;
+
+    size_t offset = 8;
+    while (offset + 4 <= len) {
+        uint16_t code = get16(reader, &body[offset]);
+        uint16_t opt_len = get16(reader, &body[offset + 2]);
+        offset += 4;
+
+        if ((code == OPT_ENDOFOPT) || (offset + opt_len > len)) {
+            break;
+        }
+
+        if ((code == OPT_IF_TSRESOL) && (opt_len >= 1)) {
+            interface->ts_units = ts_units_from_tsresol(body[offset]);
+        }
+
+        offset += (opt_len + 3) & ~3u;
+    }
+}
+
+void mct_pcapng_init(mct_pcapng_reader_t *reader, mct_pcapng_read_fn read, void *ctx) {
+    memset(reader, 0, sizeof(*reader));
+    reader->read = read;
+    reader->ctx = ctx;
+}
+
+/* Reads blocks until the next packet, returning 1 if a packet was read, 0 at the end of the stream, or -1 if the
+ * stream isn't valid pcapng. */
+int mct_pcapng_next(mct_pcapng_reader_t *reader, mct_pcapng_packet_t *packet) {
+    for (;;) {
+        uint8_t block_header[8];
+        size_t header_read = reader->read(reader->ctx, block_header, sizeof(block_header));
+        if (header_read == 0) {
+            return 0;
+        } else if (header_read != sizeof(block_header)) {
+            return -1;
+        }
+
+        uint32_t block_type = mct_le32(&block_header[0]);
+        if (block_type == BLOCK_TYPE_SHB) {
+            /* Every section can have a different byte order, so look at its magic before trusting the length. */
+            uint8_t magic[4];
+            if (!read_exact(reader, magic, sizeof(magic))) {
+                return -1;
+            }
+
+            uint32_t byte_order_magic = mct_le32(magic);
+            if (byte_order_magic == BYTE_ORDER_MAGIC) {
+                reader->swapped = false;
+            } else if (byte_order_magic == BYTE_ORDER_MAGIC_SWAPPED) {
+                reader->swapped = true;
+            } else {
+                return -1;
+            }
+
+            uint32_t block_len = get32(reader, &block_header[4]);
+            if ((block_len < 28) || (block_len > MAX_BLOCK_LEN) || !reserve(reader, block_len - 12)) {
+                return -1;
+            }
+
+            if (!read_exact(reader, reader->buf, block_len - 12)) {
+                return -1;
+            }
+
+            reader->have_section = true;
+            reader->interface_count = 0;
+            continue;
+        }
+
+        if (!reader->have_section) {
+            /* Every pcapng file starts with a section header, so this must be something else. */
+            return -1;
+        }
+
+        uint32_t block_len = get32(reader, &block_header[4]);
+        if ((block_len < 12) || (block_len > MAX_BLOCK_LEN) || (block_len % 4) || !reserve(reader, block_len - 8)) {
+            return -1;
+        }
+
+        if (!read_exact(reader, reader->buf, block_len - 8)) {
+            return -1;
+        }
+
+        const uint8_t * body = reader->buf;
+        size_t body_len = block_len - 12;
+
+        if (block_type == BLOCK_TYPE_IDB) {
+            parse_idb(reader, body, body_len);
+        } else if ((block_type == BLOCK_TYPE_EPB) && (body_len >= 20)) {
+            uint32_t interface_id = get32(reader, &body[0]);
+            uint32_t caplen = get32(reader, &body[12]);
+            if ((interface_id >= reader->interface_count) || (caplen > body_len - 20)) {
+                return -1;
+            }
+
+            const mct_pcapng_interface_t * interface = &reader->interfaces[interface_id];
+            uint64_t ts = ((uint64_t)get32(reader, &body[4]) << 32) | get32(reader, &body[8]);
+
+            packet->linktype = interface->linktype;
+            packet->ts_ns = (ts / interface->ts_units) * 1000000000 + (ts % interface->ts_units) * 1000000000 / interface->ts_units;
+            packet->data = &body[20];
+            packet->caplen = caplen;
+            packet->origlen = get32(reader, &body[16]);
+
+            return 1;
+        } else if ((block_type == BLOCK_TYPE_SPB) && (body_len >= 4) && (reader->interface_count > 0)) {
+            uint32_t origlen = get32(reader, &body[0]);
+
+            packet->linktype = reader->interfaces[0].linktype;
+            packet->ts_ns = 0;
+            packet->data = &body[4];
+            packet->caplen = (origlen < body_len - 4) ? origlen : body_len - 4;
+            packet->origlen = origlen;
+
+            return 1;
+        }
+
+        /* Skip every other kind of block. */
+    }
+}
+
+void mct_pcapng_free(mct_pcapng_reader_t *reader) {
+    free(reader->buf);
+    reader->buf = NULL;
+    reader->buf_size = 0;
+}
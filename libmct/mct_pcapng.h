@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_pcapng.h - Streaming pcapng reader for libmct.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_PCAPNG_H_INCLUDED
+#define MCT_PCAPNG_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MCT_PCAPNG_MAX_INTERFACES 64
+
+/* Reads up to len bytes into buf, returning the number of bytes read. Short reads are only allowed at the end of the
+ * stream or on error. */
+typedef size_t (*mct_pcapng_read_fn)(void *ctx, void *buf, size_t len);
+
+typedef struct mct_pcapng_interface_s {
+    uint16_t linktype;
+    /* Timestamp units per second. */
+    uint64_t ts_units;
+} mct_pcapng_interface_t;
+
+typedef struct mct_pcapng_reader_s {
+    mct_pcapng_read_fn read;
+    void * ctx;
+    bool have_section;
+    bool swapped;
+    uint32_t interface_count;
+    mct_pcapng_interface_t interfaces[MCT_PCAPNG_MAX_INTERFACES];
+    /* Holds the body of the current block. The packet data points into it, so it's only valid until the next read. */
+    uint8_t * buf;
+    size_t buf_size;
+} mct_pcapng_reader_t;
+
+typedef struct mct_pcapng_packet_s {
+    uint16_t linktype;
+    uint64_t ts_ns;
+    const uint8_t * data;
+    uint32_t caplen;
+    uint32_t origlen;
+} mct_pcapng_packet_t;
+
+void mct_pcapng_init(mct_pcapng_reader_t *reader, mct_pcapng_read_fn read, void *ctx);
+int mct_pcapng_next(mct_pcapng_reader_t *reader, mct_pcapng_packet_t *packet);
+void mct_pcapng_free(mct_pcapng_reader_t *reader);
+
+#endif // MCT_PCAPNG_H_INCLUDED
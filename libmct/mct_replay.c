@@ -0,0 +1,956 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_replay.c - Replays the screen updates in a capture of an MCT display adapter as a video.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <jpeglib.h>
+
+#include "mct_analysis.h"
+#include "mct_framebuffer.h"
+#include "mct_le.h"
+#include "mct_pcapng.h"
+#include "mct_t5.h"
+#include "mct_t6.h"
+#include "mct_usb.h"
+
+#define USB_DT_DEVICE 1
+#define USB_DEVICE_DESCRIPTOR_ID_LEN 12
+#define USB_SETUP_TYPE_VENDOR 2
+
+/* Enough to keep the writer busy while the next frame is being rendered, without holding on to much memory. */
+#define QUEUE_DEPTH 4
+
+/* The largest bulk packet or session payload that will be buffered for replay: a full 8191x8191 32-bit rectangle. */
+#define MAX_PAYLOAD_LEN (MCT_T5_BULK_HEADER_LEN + MCT_FB_MAX_DIM * MCT_FB_MAX_DIM * 4)
+
+/* Video packet type 7 is a JPEG of a part of the screen, while the others are all full frames. */
+#define T6_VIDEO_TYPE_PARTIAL 7
+
+/* The adapter double or triple buffers each output, so this is enough for a couple of resolution changes. */
+#define T6_MAX_BUFFERS 8
+
+#define CURSOR_DATA_LEN (MCT_T6_CURSOR_HEADER_LEN + MCT_FB_CURSOR_MAX_DIM * MCT_FB_CURSOR_MAX_DIM * 4)
+
+typedef enum {
+    OUTPUT_PPM,
+    OUTPUT_RAW,
+} output_format_t;
+
+/* A rendered frame that's written out repeat times in a row. The replay renders into a free slot and hands it to the
+ * writer thread, which writes it straight out of the same buffer, so frames are never copied between the two. */
+typedef struct frame_slot_s {
+    uint32_t * pixels;
+    size_t capacity;
+    uint32_t width;
+    uint32_t height;
+    uint64_t repeat;
+} frame_slot_t;
+
+/* A bounded queue of the slots filled by the replay, in order from head. The slots outside of it belong to the
+ * replay, and the ones inside of it to the writer. */
+typedef struct frame_queue_s {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    frame_slot_t slots[QUEUE_DEPTH];
+    uint32_t head;
+    uint32_t count;
+    bool closed;
+    bool failed;
+
+    FILE * out;
+    output_format_t format;
+} frame_queue_t;
+
+typedef struct device_info_s {
+    uint32_t device_id;
+    mct_protocol_t protocol;
+} device_info_t;
+
+typedef struct cursor_upload_s {
+    uint8_t data[CURSOR_DATA_LEN];
+    uint32_t len;
+    uint32_t received;
+    bool complete;
+} cursor_upload_t;
+
+typedef struct replay_s {
+    mct_protocol_t default_protocol;
+    uint32_t device_count;
+    device_info_t devices[MCT_ANALYSIS_MAX_DEVICES];
+
+    /* The device being replayed, either the one picked with -d or the first one to send a screen update. */
+    bool have_device;
+    uint32_t device_id;
+    mct_protocol_t protocol;
+
+    mct_framebuffer_t fb;
+    uint64_t frame_period_ns;
+    uint64_t max_gap_ns;
+    uint64_t next_tick_ns;
+    frame_queue_t * queue;
+
+    /* The bulk packet (T5) or video session payload (T6) being received. */
+    uint8_t * payload;
+    size_t payload_capacity;
+    uint32_t payload_len;
+    bool payload_intact;
+
+    mct_t5_bulk_state_t t5_state;
+    mct_t5_bulk_header_t t5_header;
+
+    mct_t6_bulk_state_t t6_state;
+    uint32_t t6_output_width;
+    uint32_t t6_output_height;
+    uint32_t t6_buffer_count;
+    uint32_t t6_buffers[T6_MAX_BUFFERS];
+    uint32_t t6_cursor_index;
+    cursor_upload_t t6_cursors[MCT_T6_CURSOR_COUNT];
+
+    uint64_t updates;
+    uint64_t compressed_updates;
+    uint64_t truncated_updates;
+    uint64_t undecodable_updates;
+    uint64_t frames_written;
+} replay_t;
+
+typedef struct jpeg_error_s {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jmp;
+} jpeg_error_t;
+
+
+static bool write_frame(frame_queue_t *queue, const frame_slot_t *slot, uint8_t *row) {
+    size_t pixel_count = (size_t)slot->width * slot->height;
+
+    for (uint64_t i = 0; i < slot->repeat; i++) {
+        if (queue->format == OUTPUT_RAW) {
+            /* XRGB8888 is already laid out as FFmpeg's bgr0 on little-endian hosts. */
+            if (fwrite(slot->pixels, sizeof(uint32_t), pixel_count, queue->out) != pixel_count) {
+                return false;
+            }
+            continue;
+        }
+
+        fprintf(queue->out, "P6\n%u %u\n255\n", slot->width, slot->height);
+        for (uint32_t y = 0; y < slot->height; y++) {
+            const uint32_t * src = &slot->pixels[(size_t)y * slot->width];
+            for (uint32_t x = 0; x < slot->width; x++) {
+                row[3*x] = src[x] >> 16;
+                row[3*x+1] = src[x] >> 8;
+                row[3*x+2] = src[x];
+            }
+            if (fwrite(row, 3, slot->width, queue->out) != slot->width) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void * writer_thread(void *arg) {
+    frame_queue_t * queue = (frame_queue_t *)arg;
+    uint8_t * row = malloc(MCT_FB_MAX_DIM * 3);
+
+    pthread_mutex_lock(&queue->lock);
+    queue->failed = !row;
+    while (!queue->failed) {
+        while ((queue->count == 0) && !queue->closed) {
+            pthread_cond_wait(&queue->cond, &queue->lock);
+        }
+        if (queue->count == 0) {
+            break;
+        }
+
+        const frame_slot_t * slot = &queue->slots[queue->head];
+        pthread_mutex_unlock(&queue->lock);
+
+        bool ok = write_frame(queue, slot, row);
+
+        pthread_mutex_lock(&queue->lock);
+        queue->failed = !ok;
+        queue->head = (queue->head + 1) % QUEUE_DEPTH;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+
+    free(row);
+    return NULL;
+}
+
+/* Waits for a free slot, returning NULL if the writer has failed. */
+static frame_slot_t * queue_acquire(frame_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    while ((queue->count == QUEUE_DEPTH) && !queue->failed) {
+        pthread_cond_wait(&queue->cond, &queue->lock);
+    }
+    frame_slot_t * slot = queue->failed ? NULL : &queue->slots[(queue->head + queue->count) % QUEUE_DEPTH];
+    pthread_mutex_unlock(&queue->lock);
+
+    return slot;
+}
+
+static void queue_commit(frame_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void queue_close(frame_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/* Renders what's on screen into the next slot, to be shown for repeat frames. Returns false if the output failed. */
+static bool emit_frames(replay_t *replay, uint64_t repeat) {
+    frame_slot_t * slot = queue_acquire(replay->queue);
+    if (!slot) {
+        return false;
+    }
+
+    size_t pixel_count = (size_t)replay->fb.width * replay->fb.height;
+    if (slot->capacity < pixel_count) {
+        uint32_t * pixels = realloc(slot->pixels, pixel_count * sizeof(uint32_t));
+        if (!pixels) {
+            return false;
+        }
+        slot->pixels = pixels;
+        slot->capacity = pixel_count;
+    }
+
+    slot->width = replay->fb.width;
+    slot->height = replay->fb.height;
+    slot->repeat = repeat;
+    mct_framebuffer_render(&replay->fb, slot->pixels);
+
+    queue_commit(replay->queue);
+    replay->frames_written += repeat;
+
+    return true;
+}
+
+/* Emits the frames due before ts_ns, which show the screen as it was before whatever happens at ts_ns. Gaps longer
+ * than max_gap_ns (if set) are shortened to that. */
+static bool advance_to(replay_t *replay, uint64_t ts_ns) {
+    if (!replay->fb.pixels) {
+        /* Nothing has been shown yet, so the video starts with the first update. */
+        replay->next_tick_ns = ts_ns;
+        return true;
+    }
+
+    if (ts_ns <= replay->next_tick_ns) {
+        return true;
+    }
+
+    uint64_t gap_ns = ts_ns - replay->next_tick_ns;
+    if (replay->max_gap_ns && (gap_ns > replay->max_gap_ns)) {
+        gap_ns = replay->max_gap_ns;
+    }
+
+    uint64_t ticks = (gap_ns + replay->frame_period_ns - 1) / replay->frame_period_ns;
+    if (replay->max_gap_ns && (gap_ns == replay->max_gap_ns)) {
+        replay->next_tick_ns = ts_ns;
+    } else {
+        replay->next_tick_ns += ticks * replay->frame_period_ns;
+    }
+
+    return emit_frames(replay, ticks);
+}
+
+static mct_protocol_t device_protocol(replay_t *replay, uint32_t device_id) {
+    for (uint32_t i = 0; i < replay->device_count; i++) {
+        if (replay->devices[i].device_id == device_id) {
+            return replay->devices[i].protocol;
+        }
+    }
+
+    return replay->default_protocol;
+}
+
+static void handle_device_descriptor(replay_t *replay, const mct_usb_urb_t *urb) {
+    const uint8_t * buf = urb->data;
+    if ((urb->data_len < USB_DEVICE_DESCRIPTOR_ID_LEN) || (buf[1] != USB_DT_DEVICE)) {
+        return;
+    }
+
+    uint32_t device_id = mct_usb_device_id(urb);
+    mct_protocol_t protocol = mct_protocol_from_usb_id(mct_le16(&buf[8]), mct_le16(&buf[10]));
+
+    for (uint32_t i = 0; i < replay->device_count; i++) {
+        if (replay->devices[i].device_id == device_id) {
+            replay->devices[i].protocol = protocol;
+            return;
+        }
+    }
+
+    if (replay->device_count < MCT_ANALYSIS_MAX_DEVICES) {
+        replay->devices[replay->device_count].device_id = device_id;
+        replay->devices[replay->device_count].protocol = protocol;
+        replay->device_count++;
+    }
+}
+
+/* Returns whether the URB belongs to the device being replayed, picking it if there isn't one yet. */
+static bool follow_device(replay_t *replay, const mct_usb_urb_t *urb) {
+    uint32_t device_id = mct_usb_device_id(urb);
+    if (replay->have_device && (device_id != replay->device_id)) {
+        return false;
+    }
+
+    if (replay->protocol == MCT_PROTOCOL_UNKNOWN) {
+        replay->protocol = device_protocol(replay, device_id);
+        if (replay->protocol == MCT_PROTOCOL_UNKNOWN) {
+            return false;
+        }
+    }
+
+    replay->have_device = true;
+    replay->device_id = device_id;
+
+    return true;
+}
+
+static bool payload_reserve(replay_t *replay, uint32_t len) {
+    if (len > MAX_PAYLOAD_LEN) {
+        return false;
+    }
+
+    if (replay->payload_capacity < len) {
+        uint8_t * payload = realloc(replay->payload, len);
+        if (!payload) {
+            return false;
+        }
+        replay->payload = payload;
+        replay->payload_capacity = len;
+    }
+
+    return true;
+}
+
+/* Copies the captured part of a bulk transfer into the payload being received, remembering if any of it is missing. */
+static void payload_add(replay_t *replay, uint32_t offset, const uint8_t *data, uint32_t data_len, uint32_t len) {
+    if (!replay->payload_intact) {
+        return;
+    }
+
+    if ((data_len < len) || (offset + len > replay->payload_len)) {
+        replay->payload_intact = false;
+        return;
+    }
+
+    memcpy(&replay->payload[offset], data, len);
+}
+
+static void t5_finish_packet(replay_t *replay) {
+    const mct_t5_bulk_header_t * header = &replay->t5_header;
+    const uint8_t * payload = &replay->payload[MCT_T5_BULK_HEADER_LEN];
+    uint32_t payload_len = replay->payload_len - MCT_T5_BULK_HEADER_LEN;
+
+    if (header->payload_flags == MCT_T5_BULK_PAYLOAD_FLAGS_CURSOR_ENABLE) {
+        replay->fb.cursor_visible = true;
+        replay->fb.cursor_x = header->horiz_offset;
+        replay->fb.cursor_y = header->vert_offset;
+        return;
+    } else if (header->payload_flags == MCT_T5_BULK_PAYLOAD_FLAGS_CURSOR_DISABLE) {
+        replay->fb.cursor_visible = false;
+        return;
+    }
+
+    if (!replay->payload_intact) {
+        replay->truncated_updates++;
+        return;
+    }
+
+    if (header->upload_flags & MCT_T5_BULK_UPLOAD_FLAG_CURSOR_IMAGE) {
+        if ((size_t)header->width * header->height * 4 <= payload_len) {
+            mct_framebuffer_set_cursor(&replay->fb, payload, header->width, header->height, header->width * 4);
+        }
+        return;
+    }
+
+    switch (mct_framebuffer_draw_t5(&replay->fb, header, payload, payload_len)) {
+        case MCT_T5_RECT_OK:
+            replay->updates++;
+            break;
+        case MCT_T5_RECT_COMPRESSED:
+            replay->compressed_updates++;
+            break;
+        default:
+            replay->undecodable_updates++;
+            break;
+    }
+}
+
+/* Follows the same steps as handle_t5_bulk() in mct_analysis.c, but also buffers the packet. */
+static void t5_bulk(replay_t *replay, const mct_usb_urb_t *urb) {
+    const uint8_t * buf = urb->data;
+    size_t len = urb->data_len;
+    bool have_header = len >= MCT_T5_BULK_HEADER_LEN;
+
+    ptrdiff_t header_offset = -1;
+    if (mct_t5_bulk_expects_header(&replay->t5_state)) {
+        if (have_header && mct_t5_bulk_header_magic_valid(buf)) {
+            header_offset = 0;
+        } else {
+            header_offset = mct_t5_bulk_header_find(buf, len, 1);
+            if (header_offset < 0) {
+                return;
+            }
+        }
+    } else if (have_header && mct_t5_bulk_header_magic_valid(buf) && mct_t5_bulk_header_checksum_valid(buf)) {
+        header_offset = 0;
+    }
+
+    mct_t5_bulk_fragment_t fragment = { 0 };
+    if (header_offset < 0) {
+        mct_t5_bulk_continue_packet(&replay->t5_state, urb->reported_len, &fragment);
+        payload_add(replay, fragment.fragment_offset, buf, urb->data_len, fragment.fragment_len);
+    } else {
+        mct_t5_bulk_header_parse(&buf[header_offset], &replay->t5_header);
+        mct_t5_bulk_start_packet(&replay->t5_state, &replay->t5_header, urb->reported_len - header_offset, &fragment);
+
+        replay->payload_len = MCT_T5_BULK_HEADER_LEN + replay->t5_header.payload_len;
+        replay->payload_intact = payload_reserve(replay, replay->payload_len);
+        payload_add(replay, 0, &buf[header_offset], urb->data_len - header_offset, fragment.fragment_len);
+    }
+
+    if (fragment.packet_len_remaining == 0) {
+        t5_finish_packet(replay);
+    }
+}
+
+static void jpeg_error_exit(j_common_ptr cinfo) {
+    longjmp(((jpeg_error_t *)cinfo->err)->jmp, 1);
+}
+
+static void jpeg_emit_message(j_common_ptr cinfo, int msg_level) {
+    /* Corrupt data warnings would only repeat what the dissector already says about the frame. */
+}
+
+typedef enum {
+    DRAW_OK,
+    DRAW_OTHER_OUTPUT,
+    DRAW_FAILED,
+} draw_status_t;
+
+/* Returns whether a full frame of the given size is for the output being replayed, picking it if there isn't one
+ * yet. The outputs of a T6 are told apart by their resolution, since nothing in the video header says which output a
+ * frame is for. */
+static bool t6_follow_output(replay_t *replay, uint32_t width, uint32_t height) {
+    if (replay->t6_output_width == 0) {
+        replay->t6_output_width = width;
+        replay->t6_output_height = height;
+    }
+
+    return (width == replay->t6_output_width) && (height == replay->t6_output_height);
+}
+
+/* Decodes a JPEG straight into the framebuffer at (x, y). Full frames (when full is true) resize the framebuffer to
+ * the size of the JPEG, and are skipped if they're for another output. */
+static draw_status_t draw_jpeg(replay_t *replay, const uint8_t *buf, size_t len, uint32_t x, uint32_t y, bool full) {
+    mct_framebuffer_t * fb = &replay->fb;
+    struct jpeg_decompress_struct cinfo;
+    jpeg_error_t err;
+
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpeg_error_exit;
+    err.mgr.emit_message = jpeg_emit_message;
+    if (setjmp(err.jmp)) {
+        jpeg_destroy_decompress(&cinfo);
+        return DRAW_FAILED;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, buf, len);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_EXT_BGRX;
+    jpeg_start_decompress(&cinfo);
+
+    draw_status_t status = DRAW_OK;
+    if (full && !t6_follow_output(replay, cinfo.output_width, cinfo.output_height)) {
+        status = DRAW_OTHER_OUTPUT;
+    } else if (full && (mct_framebuffer_resize(fb, cinfo.output_width, cinfo.output_height) != 0)) {
+        status = DRAW_FAILED;
+    } else if ((x + cinfo.output_width > fb->width) || (y + cinfo.output_height > fb->height)) {
+        status = DRAW_FAILED;
+    }
+
+    if (status != DRAW_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        return status;
+    }
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = (JSAMPROW)&fb->pixels[(size_t)(y + cinfo.output_scanline) * fb->width + x];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    return DRAW_OK;
+}
+
+static uint32_t clamp_u8(int32_t value) {
+    return (value < 0) ? 0 : (value > 255) ? 255 : value;
+}
+
+/* Raw frames are either packed BGR (with no chroma stride) or NV12 (with equal luma and chroma strides), and either
+ * way fill the whole screen. The YCbCr is assumed to be full range BT.601, like in the JPEGs. */
+static draw_status_t draw_raw(replay_t *replay, const uint8_t *buf, size_t len, uint32_t luma_stride,
+    uint32_t chroma_stride) {
+    mct_framebuffer_t * fb = &replay->fb;
+    bool nv12 = chroma_stride != 0;
+
+    if ((luma_stride == 0) || (nv12 && (chroma_stride != luma_stride)) || (!nv12 && (luma_stride % 3 != 0))) {
+        return DRAW_FAILED;
+    }
+
+    uint32_t width = nv12 ? luma_stride : luma_stride / 3;
+    uint32_t height = nv12 ? (len * 2 / 3) / luma_stride : len / luma_stride;
+    if (!t6_follow_output(replay, width, height)) {
+        return DRAW_OTHER_OUTPUT;
+    }
+    if (mct_framebuffer_resize(fb, width, height) != 0) {
+        return DRAW_FAILED;
+    }
+
+    const uint8_t * chroma = &buf[(size_t)luma_stride * height];
+    for (uint32_t y = 0; y < height; y++) {
+        uint32_t * dst = &fb->pixels[(size_t)y * width];
+        const uint8_t * src = &buf[(size_t)y * luma_stride];
+        if (!nv12) {
+            for (uint32_t x = 0; x < width; x++) {
+                dst[x] = src[3*x] | ((uint32_t)src[3*x+1] << 8) | ((uint32_t)src[3*x+2] << 16);
+            }
+            continue;
+        }
+
+        const uint8_t * uv = &chroma[(size_t)(y / 2) * chroma_stride];
+        for (uint32_t x = 0; x < width; x++) {
+            int32_t luma = src[x];
+            int32_t cb = uv[x & ~1u] - 128;
+            int32_t cr = uv[x | 1u] - 128;
+            uint32_t r = clamp_u8(luma + ((91881 * cr) >> 16));
+            uint32_t g = clamp_u8(luma - ((22554 * cb + 46802 * cr) >> 16));
+            uint32_t b = clamp_u8(luma + ((116130 * cb) >> 16));
+            dst[x] = (r << 16) | (g << 8) | b;
+        }
+    }
+
+    return DRAW_OK;
+}
+
+/* Remembers the address of the luma plane of a full frame of the output being replayed, to find where later partial
+ * updates go. */
+static void t6_add_buffer(replay_t *replay, uint32_t luma_addr) {
+    for (uint32_t i = 0; i < replay->t6_buffer_count; i++) {
+        if (replay->t6_buffers[i] == luma_addr) {
+            return;
+        }
+    }
+
+    replay->t6_buffers[replay->t6_buffer_count % T6_MAX_BUFFERS] = luma_addr;
+    if (replay->t6_buffer_count < T6_MAX_BUFFERS) {
+        replay->t6_buffer_count++;
+    }
+}
+
+/* Partial updates don't have an offset, just the address of their top-left corner in the luma plane of one of the
+ * output's framebuffers. */
+static draw_status_t t6_draw_partial(replay_t *replay, const uint8_t *header, const uint8_t *data, size_t data_len) {
+    uint32_t luma_stride = mct_le16(&header[20]);
+    uint32_t luma_addr = mct_le32(&header[24]);
+
+    for (uint32_t i = 0; i < replay->t6_buffer_count; i++) {
+        uint32_t base = replay->t6_buffers[i];
+        if ((luma_stride == 0) || (luma_addr < base) ||
+            ((uint64_t)luma_addr - base >= (uint64_t)luma_stride * replay->fb.height)) {
+            continue;
+        }
+
+        uint32_t offset = luma_addr - base;
+        return draw_jpeg(replay, data, data_len, offset % luma_stride, offset / luma_stride, false);
+    }
+
+    return DRAW_OTHER_OUTPUT;
+}
+
+/* The video header layout differs between full frames and partial updates:
+ *   - Full frames: 0x10 is the chroma and luma strides, and 0x14 is the address of the luma plane.
+ *   - Partial updates: 0x10 is the size of the update, 0x14 is the strides, and 0x18 is the luma address.
+ * This was worked out from captures, and isn't what the dissector shows yet. */
+static void t6_finish_video(replay_t *replay) {
+    if (!replay->payload_intact || (replay->payload_len < MCT_T6_VIDEO_HEADER_LEN)) {
+        replay->truncated_updates++;
+        return;
+    }
+
+    const uint8_t * header = replay->payload;
+    const uint8_t * data = &replay->payload[MCT_T6_VIDEO_HEADER_LEN];
+    size_t data_len = replay->payload_len - MCT_T6_VIDEO_HEADER_LEN;
+    bool jpeg = mct_t6_video_payload_is_jpeg(data, data_len);
+
+    draw_status_t status = DRAW_FAILED;
+    if (mct_le32(&header[0]) == T6_VIDEO_TYPE_PARTIAL) {
+        status = jpeg ? t6_draw_partial(replay, header, data, data_len) : DRAW_FAILED;
+    } else {
+        if (jpeg) {
+            status = draw_jpeg(replay, data, data_len, 0, 0, true);
+        } else {
+            status = draw_raw(replay, data, data_len, mct_le16(&header[16]), mct_le16(&header[18]));
+        }
+        if (status == DRAW_OK) {
+            t6_add_buffer(replay, mct_le32(&header[20]));
+        }
+    }
+
+    if (status == DRAW_OK) {
+        replay->updates++;
+    } else if (status == DRAW_FAILED) {
+        replay->undecodable_updates++;
+    }
+}
+
+/* Follows the same steps as handle_t6_bulk() in mct_analysis.c, but also buffers the video session payload. */
+static void t6_bulk(replay_t *replay, const mct_usb_urb_t *urb) {
+    if (mct_t6_bulk_expects_selector(&replay->t6_state)) {
+        if (urb->data_len >= MCT_T6_SELECTOR_LEN) {
+            mct_t6_selector_t selector = { 0 };
+            mct_t6_selector_parse(urb->data, &selector);
+            mct_t6_bulk_select(&replay->t6_state, &selector);
+        }
+        return;
+    }
+
+    uint32_t session_num = replay->t6_state.selector.session_num;
+    uint32_t payload_offset = mct_t6_bulk_continue(&replay->t6_state, urb->reported_len);
+    if (session_num != MCT_T6_SESSION_VIDEO) {
+        return;
+    }
+
+    if (payload_offset == 0) {
+        replay->payload_len = replay->t6_state.selector.payload_len;
+        replay->payload_intact = payload_reserve(replay, replay->payload_len);
+    }
+    payload_add(replay, payload_offset, urb->data, urb->data_len, urb->reported_len);
+
+    if (replay->t6_state.payload_len_remaining == 0) {
+        t6_finish_video(replay);
+    }
+}
+
+static void t6_apply_cursor(replay_t *replay) {
+    const cursor_upload_t * upload = &replay->t6_cursors[replay->t6_cursor_index];
+    if (!upload->complete) {
+        return;
+    }
+
+    uint16_t width = mct_le16(&upload->data[2]);
+    uint16_t height = mct_le16(&upload->data[4]);
+    uint16_t stride = mct_le16(&upload->data[6]);
+    if ((width * 4 > stride) || (MCT_T6_CURSOR_HEADER_LEN + (uint32_t)height * stride > upload->len)) {
+        return;
+    }
+
+    mct_framebuffer_set_cursor(&replay->fb, &upload->data[MCT_T6_CURSOR_HEADER_LEN], width, height, stride);
+}
+
+/* Collects the fragments of a cursor upload, which are sent in order, each with its byte offset in wIndex. */
+static void t6_upload_cursor(replay_t *replay, const mct_usb_urb_t *urb, uint16_t cursor_index, uint16_t offset) {
+    if (cursor_index >= MCT_T6_CURSOR_COUNT) {
+        return;
+    }
+
+    cursor_upload_t * upload = &replay->t6_cursors[cursor_index];
+    if (offset == 0) {
+        upload->complete = false;
+        upload->received = 0;
+        upload->len = 0;
+        if (urb->data_len >= MCT_T6_CURSOR_HEADER_LEN) {
+            upload->len = MCT_T6_CURSOR_HEADER_LEN + mct_le16(&urb->data[4]) * mct_le16(&urb->data[6]);
+        }
+        if (upload->len > sizeof(upload->data)) {
+            upload->len = 0;
+        }
+    }
+
+    if ((upload->len == 0) || (offset != upload->received) || (urb->data_len < urb->reported_len) ||
+        (offset + urb->data_len > upload->len)) {
+        upload->len = 0;
+        return;
+    }
+
+    memcpy(&upload->data[offset], urb->data, urb->data_len);
+    upload->received += urb->data_len;
+    upload->complete = upload->received == upload->len;
+
+    if (upload->complete && (cursor_index == replay->t6_cursor_index)) {
+        t6_apply_cursor(replay);
+    }
+}
+
+static void handle_vendor_setup(replay_t *replay, const mct_usb_urb_t *urb) {
+    uint8_t bRequest = urb->setup[1];
+    uint16_t wValue = mct_le16(&urb->setup[2]);
+    uint16_t wIndex = mct_le16(&urb->setup[4]);
+    uint16_t wLength = mct_le16(&urb->setup[6]);
+
+    if (replay->protocol == MCT_PROTOCOL_T5) {
+        if ((bRequest == MCT_T5_CTRL_REQ_SET_VIDEO_MODE) && (wLength == MCT_T5_CUSTOM_VIDEO_MODE_LEN) &&
+            (urb->data_len >= 4)) {
+            uint16_t height = (urb->data[0] << 8) | urb->data[1];
+            uint16_t width = (urb->data[2] << 8) | urb->data[3];
+            mct_framebuffer_resize(&replay->fb, width, height);
+        } else if (bRequest == MCT_T5_CTRL_REQ_SET_CURSOR_POS) {
+            replay->fb.cursor_x = wValue;
+            replay->fb.cursor_y = wIndex;
+        }
+    } else if (replay->protocol == MCT_PROTOCOL_T6) {
+        if (bRequest == MCT_T6_CONTROL_REQ_SET_CURSOR_POS) {
+            replay->fb.cursor_x = wValue;
+            replay->fb.cursor_y = wIndex;
+        } else if (bRequest == MCT_T6_CONTROL_REQ_SET_CURSOR_STATE) {
+            replay->fb.cursor_visible = wIndex == 1;
+            if (wValue < MCT_T6_CURSOR_COUNT) {
+                replay->t6_cursor_index = wValue;
+                t6_apply_cursor(replay);
+            }
+        } else if (bRequest == MCT_T6_CONTROL_REQ_UPLOAD_CURSOR) {
+            t6_upload_cursor(replay, urb, wValue, wIndex);
+        }
+    }
+}
+
+/* Applies one URB of the capture to the screen. Returns false if the output failed. */
+static bool replay_urb(replay_t *replay, uint64_t ts_ns, const mct_usb_urb_t *urb) {
+    if ((urb->transfer_type == MCT_USB_TRANSFER_CONTROL) && (urb->endpoint == 0)) {
+        if (urb->is_submit && urb->has_setup && (((urb->setup[0] >> 5) & 0x3) == USB_SETUP_TYPE_VENDOR) &&
+            !(urb->setup[0] & 0x80) && follow_device(replay, urb)) {
+            if (!advance_to(replay, ts_ns)) {
+                return false;
+            }
+            handle_vendor_setup(replay, urb);
+        } else if (urb->direction_in && !urb->is_submit && (urb->data_len > 0) && (urb->data[0] == 18)) {
+            handle_device_descriptor(replay, urb);
+        }
+        return true;
+    }
+
+    if ((urb->transfer_type != MCT_USB_TRANSFER_BULK) || urb->direction_in || !urb->is_submit ||
+        (urb->data_len == 0) || !follow_device(replay, urb)) {
+        return true;
+    }
+
+    if (!advance_to(replay, ts_ns)) {
+        return false;
+    }
+
+    if ((replay->protocol == MCT_PROTOCOL_T5) && (urb->endpoint == 1)) {
+        t5_bulk(replay, urb);
+    } else if ((replay->protocol == MCT_PROTOCOL_T6) && (urb->endpoint == 2)) {
+        t6_bulk(replay, urb);
+    }
+
+    return true;
+}
+
+static size_t file_read(void *ctx, void *buf, size_t len) {
+    return fread(buf, 1, len, (FILE *)ctx);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-d bus.address] [-f ppm|raw] [-g seconds] [-o output] [-r fps] [-t t5|t6] <capture.pcapng|->\n", argv0);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -d bus.address  Device to replay (default: the first one to send a screen update).\n");
+    fprintf(stderr, "  -f ppm|raw      Output a stream of PPM images (default), or raw bgr0 frames.\n");
+    fprintf(stderr, "  -g seconds      Shorten gaps between updates longer than this (default: keep them).\n");
+    fprintf(stderr, "  -o output       File to write the frames to (default: stdout).\n");
+    fprintf(stderr, "  -r fps          Output frame rate (default: 60).\n");
+    fprintf(stderr, "  -t t5|t6        Protocol to assume for devices whose device descriptor wasn't captured.\n");
+}
+
+int main(int argc, char **argv) {
+    static replay_t replay;
+    replay.default_protocol = MCT_PROTOCOL_UNKNOWN;
+    mct_framebuffer_init(&replay.fb);
+
+    static frame_queue_t queue;
+    queue.format = OUTPUT_PPM;
+    queue.out = stdout;
+
+    const char * output_path = NULL;
+    double fps = 60;
+    double max_gap_s = 0;
+
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "d:f:g:ho:r:t:")) != -1) {
+        unsigned int bus = 0;
+        unsigned int address = 0;
+        switch (opt) {
+            case 'd':
+                if (sscanf(optarg, "%u.%u", &bus, &address) != 2) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                replay.have_device = true;
+                replay.device_id = (bus << 16) | (address & 0xFFFF);
+                break;
+            case 'f':
+                if (strcmp(optarg, "ppm") == 0) {
+                    queue.format = OUTPUT_PPM;
+                } else if (strcmp(optarg, "raw") == 0) {
+                    queue.format = OUTPUT_RAW;
+                } else {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'g':
+                max_gap_s = atof(optarg);
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'r':
+                fps = atof(optarg);
+                if (fps <= 0) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 't':
+                if (strcmp(optarg, "t5") == 0) {
+                    replay.default_protocol = MCT_PROTOCOL_T5;
+                } else if (strcmp(optarg, "t6") == 0) {
+                    replay.default_protocol = MCT_PROTOCOL_T6;
+                } else {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    replay.frame_period_ns = 1e9 / fps;
+    replay.max_gap_ns = max_gap_s * 1e9;
+    replay.queue = &queue;
+
+    const char * path = argv[optind];
+    FILE * file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    if (output_path) {
+        queue.out = fopen(output_path, "wb");
+        if (!queue.out) {
+            perror(output_path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.cond, NULL);
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, writer_thread, &queue) != 0) {
+        perror("pthread_create");
+        return EXIT_FAILURE;
+    }
+
+    mct_pcapng_reader_t reader;
+    mct_pcapng_init(&reader, file_read, file);
+
+    bool ok = true;
+    uint64_t last_ts_ns = 0;
+    mct_pcapng_packet_t packet = { 0 };
+    int ret = 0;
+    while (ok && (ret = mct_pcapng_next(&reader, &packet)) > 0) {
+        mct_usb_urb_t urb = { 0 };
+        if (mct_usb_urb_decode(packet.linktype, packet.data, packet.caplen, packet.origlen, &urb)) {
+            ok = replay_urb(&replay, packet.ts_ns, &urb);
+            last_ts_ns = packet.ts_ns;
+        }
+    }
+
+    /* Show the final state of the screen for one more frame, so the last update always makes it into the video. */
+    if (ok && replay.fb.pixels) {
+        ok = advance_to(&replay, last_ts_ns) && emit_frames(&replay, 1);
+    }
+
+    queue_close(&queue);
+    pthread_join(writer, NULL);
+    ok = ok && !queue.failed && (fflush(queue.out) == 0);
+
+    if (ret < 0) {
+        fprintf(stderr, "%s: Not a valid pcapng file, or it's truncated\n", path);
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: Failed to write the video\n", output_path ? output_path : "stdout");
+    }
+
+    if (replay.have_device) {
+        fprintf(stderr, "Device %u.%u (%s): %ux%u, %" PRIu64 " updates, %" PRIu64 " compressed, %" PRIu64
+            " truncated, %" PRIu64 " undecodable, %" PRIu64 " frames written\n", replay.device_id >> 16,
+            replay.device_id & 0xFFFF, mct_protocol_name(replay.protocol), replay.fb.width, replay.fb.height,
+            replay.updates, replay.compressed_updates, replay.truncated_updates, replay.undecodable_updates,
+            replay.frames_written);
+    } else {
+        fprintf(stderr, "No Trigger 5 or Trigger 6 screen updates found\n");
+    }
+
+    mct_pcapng_free(&reader);
+    if (file != stdin) {
+        fclose(file);
+    }
+    if (queue.out != stdout) {
+        fclose(queue.out);
+    }
+    for (uint32_t i = 0; i < QUEUE_DEPTH; i++) {
+        free(queue.slots[i].pixels);
+    }
+    free(replay.payload);
+    mct_framebuffer_free(&replay.fb);
+
+    return (ret < 0 || !ok) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_t5.c - Protocol decoding for MCT's Trigger 5 protocol.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mct_le.h"
+#include "mct_t5.h"
+
+
+uint8_t mct_t5_bulk_header_checksum(const uint8_t *buf, size_t len) {
+    int32_t checksum = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        checksum += buf[i];
+    }
+
+    return (-checksum) & 0xFF;
+}
+
+bool mct_t5_bulk_header_magic_valid(const uint8_t buf[MCT_T5_BULK_HEADER_LEN]) {
+    return (buf[0] == 0xfb) && (buf[1] == MCT_T5_BULK_HEADER_LEN);
+}
+
+bool mct_t5_bulk_header_checksum_valid(const uint8_t buf[MCT_T5_BULK_HEADER_LEN]) {
+    return mct_t5_bulk_header_checksum(buf, MCT_T5_BULK_HEADER_LEN - 1) == buf[MCT_T5_BULK_HEADER_LEN - 1];
+}
+
+void mct_t5_bulk_header_parse(const uint8_t buf[MCT_T5_BULK_HEADER_LEN], mct_t5_bulk_header_t *header) {
+    uint16_t frame_counter_and_flags = mct_le16(&buf[2]);
+    header->frame_counter = frame_counter_and_flags & 0x0FFF;
+    header->frame_flags = frame_counter_and_flags >> 12;
+    header->horiz_offset = mct_le16(&buf[4]) & 0x1FFF;
+    header->vert_offset = mct_le16(&buf[6]) & 0x1FFF;
+    header->width = mct_le16(&buf[8]) & 0x1FFF;
+    header->height = mct_le16(&buf[10]) & 0x1FFF;
+    header->payload_len = mct_le32(&buf[12]) & 0x0FFFFFFF;
+    header->payload_flags = mct_le32(&buf[12]) >> 28;
+    header->upload_flags = buf[17];
+}
+
+/* The inverse of mct_t5_bulk_header_parse(), including the magic, the required flag, and the checksum. */
+void mct_t5_bulk_header_build(const mct_t5_bulk_header_t *header, uint8_t buf[MCT_T5_BULK_HEADER_LEN]) {
+    buf[0] = 0xfb;
+    buf[1] = MCT_T5_BULK_HEADER_LEN;
+    mct_set_le16(&buf[2], (header->frame_counter & 0x0FFF) | (header->frame_flags << 12));
+    mct_set_le16(&buf[4], header->horiz_offset & 0x1FFF);
+    mct_set_le16(&buf[6], header->vert_offset & 0x1FFF);
+    mct_set_le16(&buf[8], header->width & 0x1FFF);
+    mct_set_le16(&buf[10], header->height & 0x1FFF);
+    mct_set_le32(&buf[12], (header->payload_len & 0x0FFFFFFF) | (header->payload_flags << 28));
+    buf[16] = MCT_T5_BULK_OTHER_FLAGS_REQUIRED;
+    buf[17] = header->upload_flags;
+    buf[18] = 0;
+    buf[19] = mct_t5_bulk_header_checksum(buf, MCT_T5_BULK_HEADER_LEN - 1);
+}
+
+/* Returns the offset of the first header with a valid magic and checksum at or after start_offset, or -1. */
+ptrdiff_t mct_t5_bulk_header_find(const uint8_t *buf, size_t len, size_t start_offset) {
+    size_t offset = start_offset;
+    while ((offset + MCT_T5_BULK_HEADER_LEN) <= len) {
+        const uint8_t * magic = memchr(&buf[offset], 0xfb, len - MCT_T5_BULK_HEADER_LEN + 1 - offset);
+        if (!magic) {
+            return -1;
+        }
+
+        offset = magic - buf;
+        if (mct_t5_bulk_header_magic_valid(magic) && mct_t5_bulk_header_checksum_valid(magic)) {
+            return offset;
+        }
+
+        offset++;
+    }
+
+    return -1;
+}
+
+bool mct_t5_bulk_expects_header(const mct_t5_bulk_state_t *state) {
+    return state->packet_len_remaining == 0;
+}
+
+/* Starts a new packet with the given header. len is the reported length of the bulk transfer from the header on. */
+void mct_t5_bulk_start_packet(mct_t5_bulk_state_t *state, const mct_t5_bulk_header_t *header, uint32_t len,
+    mct_t5_bulk_fragment_t *fragment) {
+    uint32_t total_packet_length = MCT_T5_BULK_HEADER_LEN + header->payload_len;
+
+    fragment->fragment_offset = 0;
+    fragment->fragment_len = (total_packet_length < len) ? total_packet_length : len;
+    fragment->packet_len_remaining = total_packet_length - fragment->fragment_len;
+
+    state->fragment_offset = fragment->fragment_len;
+    state->packet_len_remaining = fragment->packet_len_remaining;
+}
+
+/* Continues the current packet with a bulk transfer of the given reported length. */
+void mct_t5_bulk_continue_packet(mct_t5_bulk_state_t *state, uint32_t len, mct_t5_bulk_fragment_t *fragment) {
+    fragment->fragment_offset = state->fragment_offset;
+    fragment->fragment_len = (state->packet_len_remaining < len) ? state->packet_len_remaining : len;
+    fragment->packet_len_remaining = state->packet_len_remaining - fragment->fragment_len;
+
+    state->fragment_offset += fragment->fragment_len;
+    state->packet_len_remaining = fragment->packet_len_remaining;
+}
+
+mct_t5_depth_t mct_t5_bulk_depth(const mct_t5_bulk_header_t *header) {
+    return (header->frame_flags & MCT_T5_BULK_FRAME_FLAG_DEPTH_MASK) >> MCT_T5_BULK_FRAME_FLAG_DEPTH_SHIFT;
+}
+
+/* Returns 0 for the reserved bit depth. */
+uint32_t mct_t5_bulk_bytes_per_pixel(const mct_t5_bulk_header_t *header) {
+    switch (mct_t5_bulk_depth(header)) {
+        case MCT_T5_DEPTH_24:
+            return 3;
+        case MCT_T5_DEPTH_32:
+            return 4;
+        case MCT_T5_DEPTH_16:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+const char * mct_t5_rect_status_name(mct_t5_rect_status_t status) {
+    switch (status) {
+        case MCT_T5_RECT_OK:
+            return "OK";
+        case MCT_T5_RECT_COMPRESSED:
+            return "Compressed";
+        case MCT_T5_RECT_UNKNOWN_DEPTH:
+            return "Unknown bit depth";
+        case MCT_T5_RECT_SHORT_PAYLOAD:
+            return "Short payload";
+        case MCT_T5_RECT_OFF_SCREEN:
+            return "Off screen";
+        default:
+            return "Unknown";
+    }
+}
+
+/* The row converters are kept free of branches and aliasing so the compiler can vectorize them. */
+static void rect_row_24(uint32_t * restrict dst, const uint8_t * restrict src, size_t width) {
+    for (size_t x = 0; x < width; x++) {
+        /* Pixels are sent as little-endian 0xRRGGBB, i.e., in BGR byte order. */
+        dst[x] = src[3*x] | ((uint32_t)src[3*x+1] << 8) | ((uint32_t)src[3*x+2] << 16);
+    }
+}
+
+static void rect_row_32(uint32_t * restrict dst, const uint8_t * restrict src, size_t width) {
+    for (size_t x = 0; x < width; x++) {
+        dst[x] = src[4*x] | ((uint32_t)src[4*x+1] << 8) | ((uint32_t)src[4*x+2] << 16);
+    }
+}
+
+static void rect_row_16(uint32_t * restrict dst, const uint8_t * restrict src, size_t width) {
+    for (size_t x = 0; x < width; x++) {
+        /* Assumed to be little-endian RGB565, since that's what every other 16-bit framebuffer uses. */
+        uint32_t pixel = src[2*x] | ((uint32_t)src[2*x+1] << 8);
+        uint32_t r = (pixel >> 11) & 0x1f;
+        uint32_t g = (pixel >> 5) & 0x3f;
+        uint32_t b = pixel & 0x1f;
+        dst[x] = (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+    }
+}
+
+/* Converts the uncompressed payload of a bulk packet (the bytes after the header) into header->width by
+ * header->height XRGB8888 pixels, stride pixels apart. The compression format hasn't been figured out yet, so
+ * compressed payloads are rejected rather than decoded. */
+mct_t5_rect_status_t mct_t5_rect_decode(const mct_t5_bulk_header_t *header, const uint8_t *payload, size_t len,
+    uint32_t *pixels, size_t stride) {
+    if (header->frame_flags & MCT_T5_BULK_FRAME_FLAG_COMPRESSED) {
+        return MCT_T5_RECT_COMPRESSED;
+    }
+
+    uint32_t bytes_per_pixel = mct_t5_bulk_bytes_per_pixel(header);
+    if (bytes_per_pixel == 0) {
+        return MCT_T5_RECT_UNKNOWN_DEPTH;
+    }
+
+    size_t row_len = (size_t)header->width * bytes_per_pixel;
+    if (len < row_len * header->height) {
+        return MCT_T5_RECT_SHORT_PAYLOAD;
+    }
+
+    for (size_t y = 0; y < header->height; y++) {
+        uint32_t * dst = &pixels[y * stride];
+        const uint8_t * src = &payload[y * row_len];
+        switch (bytes_per_pixel) {
+            case 3:
+                rect_row_24(dst, src, header->width);
+                break;
+            case 4:
+                rect_row_32(dst, src, header->width);
+                break;
+            case 2:
+                rect_row_16(dst, src, header->width);
+                break;
+        }
+    }
+
+    return MCT_T5_RECT_OK;
+}
+
+/* The inverse of the 24-bit case of mct_t5_rect_decode(): converts width by height XRGB8888 pixels, stride pixels
+ * apart, into an uncompressed payload. Returns the length of the payload. */
+size_t mct_t5_rect_encode_24(const uint32_t *pixels, size_t stride, uint32_t width, uint32_t height, uint8_t *payload) {
+    size_t row_len = (size_t)width * 3;
+    for (size_t y = 0; y < height; y++) {
+        const uint32_t * restrict src = &pixels[y * stride];
+        uint8_t * restrict dst = &payload[y * row_len];
+        for (size_t x = 0; x < width; x++) {
+            dst[3*x] = src[x] & 0xFF;
+            dst[3*x+1] = (src[x] >> 8) & 0xFF;
+            dst[3*x+2] = (src[x] >> 16) & 0xFF;
+        }
+    }
+
+    return row_len * height;
+}
+
+/* Parses up to max_modes entries of a "Get array of video modes" response. Returns the number of modes parsed, which
+ * is less than the reported number of modes if the response is short. */
+uint32_t mct_t5_video_modes_parse(const uint8_t *buf, size_t len, mct_t5_video_mode_t *modes, uint32_t max_modes) {
+    if (len < MCT_T5_VIDEO_MODES_HEADER_LEN) {
+        return 0;
+    }
+
+    uint32_t count = (buf[0] << 8) | buf[1];
+    if (count > max_modes) {
+        count = max_modes;
+    }
+
+    uint32_t i = 0;
+    for (; i < count; i++) {
+        size_t offset = MCT_T5_VIDEO_MODES_HEADER_LEN + (size_t)i * MCT_T5_VIDEO_MODE_LEN;
+        if (offset + MCT_T5_VIDEO_MODE_LEN > len) {
+            break;
+        }
+
+        const uint8_t * entry = &buf[offset];
+        modes[i].refresh_rate_hz = entry[0];
+        modes[i].pixel_clock_mhz = entry[1];
+        modes[i].bits_per_pixel = entry[2];
+        modes[i].mode_number = entry[3];
+        modes[i].height = mct_le16(&entry[4]);
+        modes[i].width = mct_le16(&entry[6]);
+    }
+
+    return i;
+}
+
+double mct_t5_pll_freq_khz(uint32_t pre_div, uint32_t mul0, uint32_t mul1, uint32_t div0, uint32_t div1) {
+    return 10e3 / pre_div * mul0 * mul1 / div0 / div1;
+}
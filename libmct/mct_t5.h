@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_t5.h - Protocol decoding for MCT's Trigger 5 protocol.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_T5_H_INCLUDED
+#define MCT_T5_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MCT_T5_CTRL_REQ_KEEPALIVE 0x91
+#define MCT_T5_CTRL_REQ_GET_INFO 0xA1
+#define MCT_T5_CTRL_REQ_GET_VIDEO_MODES 0xA4
+#define MCT_T5_CTRL_REQ_GET_HPD 0xA6
+#define MCT_T5_CTRL_REQ_SET_VIDEO_MODE 0xC3
+#define MCT_T5_CTRL_REQ_SET_REGISTER 0xC4
+#define MCT_T5_CTRL_REQ_SET_CURSOR_POS 0xC8
+#define MCT_T5_CTRL_REQ_GET_EDID_BLOCK 0xA8
+#define MCT_T5_CTRL_REQ_FIRMWARE_RESET 0xD1
+
+#define MCT_T5_INFO_LEN 512
+
+/* The video modes array starts with the big-endian number of modes and two bytes of padding. */
+#define MCT_T5_VIDEO_MODES_LEN 420
+#define MCT_T5_VIDEO_MODES_HEADER_LEN 4
+#define MCT_T5_VIDEO_MODE_LEN 8
+#define MCT_T5_MAX_VIDEO_MODES ((MCT_T5_VIDEO_MODES_LEN - MCT_T5_VIDEO_MODES_HEADER_LEN) / MCT_T5_VIDEO_MODE_LEN)
+
+/* Custom video modes start with the big-endian vertical and horizontal resolution. */
+#define MCT_T5_CUSTOM_VIDEO_MODE_LEN 35
+
+#define MCT_T5_BULK_HEADER_LEN 20
+
+#define MCT_T5_BULK_FRAME_FLAG_COMPRESSED 0x1
+#define MCT_T5_BULK_FRAME_FLAG_DEPTH_MASK 0x6
+#define MCT_T5_BULK_FRAME_FLAG_DEPTH_SHIFT 1
+
+#define MCT_T5_BULK_PAYLOAD_FLAGS_CURSOR_ENABLE 0x3
+#define MCT_T5_BULK_PAYLOAD_FLAGS_CURSOR_DISABLE 0x5
+
+/* Bit 0 of the byte after the payload info has to be set, but it's not known what it means. */
+#define MCT_T5_BULK_OTHER_FLAGS_REQUIRED 0x01
+
+/* Set in the byte after the other flags when the payload is the (32-bit BGRA) cursor image instead of a rectangle of
+ * the screen. */
+#define MCT_T5_BULK_UPLOAD_FLAG_CURSOR_IMAGE 0x10
+
+typedef enum {
+    MCT_T5_DEPTH_24 = 0,
+    MCT_T5_DEPTH_32 = 1,
+    MCT_T5_DEPTH_16 = 2,
+} mct_t5_depth_t;
+
+typedef enum {
+    MCT_T5_RECT_OK,
+    MCT_T5_RECT_COMPRESSED,
+    MCT_T5_RECT_UNKNOWN_DEPTH,
+    MCT_T5_RECT_SHORT_PAYLOAD,
+    MCT_T5_RECT_OFF_SCREEN,
+} mct_t5_rect_status_t;
+
+/* One entry of the "Get array of video modes" response. */
+typedef struct mct_t5_video_mode_s {
+    uint8_t refresh_rate_hz;
+    uint8_t pixel_clock_mhz;
+    uint8_t bits_per_pixel;
+    uint8_t mode_number;
+    uint16_t height;
+    uint16_t width;
+} mct_t5_video_mode_t;
+
+typedef struct mct_t5_bulk_header_s {
+    uint16_t frame_counter;
+    uint16_t frame_flags;
+    uint16_t horiz_offset;
+    uint16_t vert_offset;
+    uint16_t width;
+    uint16_t height;
+    uint32_t payload_len;
+    uint32_t payload_flags;
+    uint8_t upload_flags;
+} mct_t5_bulk_header_t;
+
+/* Where the bulk stream is within the current packet. A zeroed state expects a header. */
+typedef struct mct_t5_bulk_state_s {
+    uint32_t fragment_offset;
+    uint32_t packet_len_remaining;
+} mct_t5_bulk_state_t;
+
+/* The part of the current packet carried by one bulk transfer. */
+typedef struct mct_t5_bulk_fragment_s {
+    uint32_t fragment_offset;
+    uint32_t fragment_len;
+    uint32_t packet_len_remaining;
+} mct_t5_bulk_fragment_t;
+
+uint8_t mct_t5_bulk_header_checksum(const uint8_t *buf, size_t len);
+bool mct_t5_bulk_header_magic_valid(const uint8_t buf[MCT_T5_BULK_HEADER_LEN]);
+bool mct_t5_bulk_header_checksum_valid(const uint8_t buf[MCT_T5_BULK_HEADER_LEN]);
+void mct_t5_bulk_header_parse(const uint8_t buf[MCT_T5_BULK_HEADER_LEN], mct_t5_bulk_header_t *header);
+void mct_t5_bulk_header_build(const mct_t5_bulk_header_t *header, uint8_t buf[MCT_T5_BULK_HEADER_LEN]);
+ptrdiff_t mct_t5_bulk_header_find(const uint8_t *buf, size_t len, size_t start_offset);
+
+bool mct_t5_bulk_expects_header(const mct_t5_bulk_state_t *state);
+void mct_t5_bulk_start_packet(mct_t5_bulk_state_t *state, const mct_t5_bulk_header_t *header, uint32_t len,
+    mct_t5_bulk_fragment_t *fragment);
+void mct_t5_bulk_continue_packet(mct_t5_bulk_state_t *state, uint32_t len, mct_t5_bulk_fragment_t *fragment);
+
+mct_t5_depth_t mct_t5_bulk_depth(const mct_t5_bulk_header_t *header);
+uint32_t mct_t5_bulk_bytes_per_pixel(const mct_t5_bulk_header_t *header);
+const char * mct_t5_rect_status_name(mct_t5_rect_status_t status);
+mct_t5_rect_status_t mct_t5_rect_decode(const mct_t5_bulk_header_t *header, const uint8_t *payload, size_t len,
+    uint32_t *pixels, size_t stride);
+size_t mct_t5_rect_encode_24(const uint32_t *pixels, size_t stride, uint32_t width, uint32_t height, uint8_t *payload);
+
+uint32_t mct_t5_video_modes_parse(const uint8_t *buf, size_t len, mct_t5_video_mode_t *modes, uint32_t max_modes);
+
+double mct_t5_pll_freq_khz(uint32_t pre_div, uint32_t mul0, uint32_t mul1, uint32_t div0, uint32_t div1);
+
+#endif // MCT_T5_H_INCLUDED
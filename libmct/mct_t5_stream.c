@@ -0,0 +1,635 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_t5_stream.c - Streams raw video frames to an MCT Trigger 5 display adapter over libusb.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libusb.h>
+
+#include "mct_analysis.h"
+#include "mct_bulk_pool.h"
+#include "mct_cache.h"
+#include "mct_edid.h"
+#include "mct_framebuffer.h"
+#include "mct_le.h"
+#include "mct_t5.h"
+
+#define T5_INTERFACE 0
+#define T5_BULK_OUT_ENDPOINT 0x01
+
+#define CONTROL_IN (LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE)
+#define CONTROL_OUT (LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE)
+#define CONTROL_TIMEOUT_MS 1000
+
+/* Writing 1 to this register hides the hardware cursor, which would otherwise show whatever was last uploaded. */
+#define T5_REG_CURSOR_DISABLE 0xE868
+
+/* The display output is turned off if no keepalive is received for a few seconds, and test_t5.py sends one every
+ * two. */
+#define KEEPALIVE_INTERVAL_NS 2000000000ULL
+
+#define HPD_POLL_INTERVAL_MS 100
+#define HPD_POLL_TRIES 50
+
+#define DEFAULT_SLOT_COUNT 8
+#define DEFAULT_SLOT_SIZE (256 * 1024)
+
+typedef struct stream_s {
+    libusb_device_handle * handle;
+    mct_bulk_pool_t pool;
+
+    uint32_t width;
+    uint32_t height;
+    /* The frame being read and the last one that was sent, which is what the monitor is showing. */
+    uint32_t * cur;
+    uint32_t * prev;
+    bool have_prev;
+    uint8_t * row;
+
+    uint16_t frame_counter;
+    uint64_t last_keepalive_ns;
+
+    uint64_t frames_read;
+    uint64_t packets_sent;
+    uint64_t frames_unchanged;
+    uint64_t dirty_pixels;
+} stream_t;
+
+static volatile sig_atomic_t STOP_REQUESTED;
+static uint32_t CONTROL_REQUESTS;
+
+
+static void handle_signal(int signum) {
+    (void)signum;
+    STOP_REQUESTED = 1;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR) && !STOP_REQUESTED) {
+        continue;
+    }
+}
+
+static int control_in(libusb_device_handle *handle, uint8_t request, uint16_t value, uint16_t index, uint8_t *buf,
+    uint16_t len) {
+    CONTROL_REQUESTS++;
+    return libusb_control_transfer(handle, CONTROL_IN, request, value, index, buf, len, CONTROL_TIMEOUT_MS);
+}
+
+static int control_out(libusb_device_handle *handle, uint8_t request, uint16_t value, uint16_t index, uint8_t *buf,
+    uint16_t len) {
+    CONTROL_REQUESTS++;
+    return libusb_control_transfer(handle, CONTROL_OUT, request, value, index, buf, len, CONTROL_TIMEOUT_MS);
+}
+
+/* Opens the first Trigger 5 adapter, or the one at device_id if have_device is set. */
+static libusb_device_handle * open_device(libusb_context *ctx, bool have_device, uint32_t device_id) {
+    libusb_device ** list = NULL;
+    ssize_t count = libusb_get_device_list(ctx, &list);
+    if (count < 0) {
+        return NULL;
+    }
+
+    libusb_device_handle * handle = NULL;
+    for (ssize_t i = 0; i < count; i++) {
+        struct libusb_device_descriptor desc;
+        if (libusb_get_device_descriptor(list[i], &desc) != 0) {
+            continue;
+        }
+        if (mct_protocol_from_usb_id(desc.idVendor, desc.idProduct) != MCT_PROTOCOL_T5) {
+            continue;
+        }
+
+        uint32_t id = ((uint32_t)libusb_get_bus_number(list[i]) << 16) | libusb_get_device_address(list[i]);
+        if (have_device && (id != device_id)) {
+            continue;
+        }
+
+        int ret = libusb_open(list[i], &handle);
+        if (ret != 0) {
+            fprintf(stderr, "Failed to open device %u.%u: %s\n", id >> 16, id & 0xFFFF, libusb_strerror(ret));
+            handle = NULL;
+        }
+        break;
+    }
+
+    libusb_free_device_list(list, 1);
+    return handle;
+}
+
+static bool claim_device(libusb_device_handle *handle) {
+    int config = 0;
+    if ((libusb_get_configuration(handle, &config) != 0) || (config != 1)) {
+        int ret = libusb_set_configuration(handle, 1);
+        if (ret != 0) {
+            fprintf(stderr, "Failed to set the configuration: %s\n", libusb_strerror(ret));
+            return false;
+        }
+    }
+
+    libusb_set_auto_detach_kernel_driver(handle, 1);
+    int ret = libusb_claim_interface(handle, T5_INTERFACE);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to claim the interface: %s\n", libusb_strerror(ret));
+        return false;
+    }
+
+    return true;
+}
+
+/* Prints the firmware info and builds the cache key from it. The firmware info doesn't have a serial number, so the
+ * USB serial number is used if the adapter has one. Returns false if the firmware info couldn't be read. */
+static bool get_info(libusb_device_handle *handle, char key[MCT_CACHE_KEY_MAX_LEN]) {
+    uint8_t info[MCT_T5_INFO_LEN] = { 0 };
+    int ret = control_in(handle, MCT_T5_CTRL_REQ_GET_INFO, 0, 0, info, sizeof(info));
+    if (ret < 14) {
+        fprintf(stderr, "Failed to get the firmware info\n");
+        return false;
+    }
+
+    fprintf(stderr, "Firmware version %u.%u.%u (20%02u-%02u-%02u)\n", info[0], info[1], info[2], info[11], info[12],
+        info[13]);
+
+    unsigned char serial[32] = "none";
+    struct libusb_device_descriptor desc;
+    if ((libusb_get_device_descriptor(libusb_get_device(handle), &desc) == 0) && (desc.iSerialNumber != 0)) {
+        CONTROL_REQUESTS++;
+        if (libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, serial, sizeof(serial)) <= 0) {
+            snprintf((char *)serial, sizeof(serial), "none");
+        }
+    }
+    snprintf(key, MCT_CACHE_KEY_MAX_LEN, "t5-%s-%02x%02x%02x-%02x%02x%02x", serial, info[0], info[1], info[2],
+        info[11], info[12], info[13]);
+    if (!mct_cache_key_valid(key)) {
+        /* The USB serial number has characters that can't be in a file name. */
+        snprintf(key, MCT_CACHE_KEY_MAX_LEN, "t5-none-%02x%02x%02x-%02x%02x%02x", info[0], info[1], info[2], info[11],
+            info[12], info[13]);
+    }
+
+    return true;
+}
+
+/* Reads the mode table into buf, returning its length, or -1 on error. */
+static int read_video_modes(libusb_device_handle *handle, uint8_t buf[MCT_T5_VIDEO_MODES_LEN]) {
+    int ret = control_in(handle, MCT_T5_CTRL_REQ_GET_VIDEO_MODES, 0, 0, buf, MCT_T5_VIDEO_MODES_LEN);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to get the video modes: %s\n", libusb_strerror(ret));
+        return -1;
+    }
+
+    return ret;
+}
+
+/* Reads the monitor's EDID into the cache entry, returning false if it changed since it was cached. If the base block
+ * matches the cached one, the rest of the cached EDID is used as is, since the base block has the monitor's model and
+ * serial number and the number of extensions. */
+static bool read_edid(libusb_device_handle *handle, mct_cache_entry_t *cache) {
+    uint8_t block[MCT_EDID_BLOCK_LEN];
+    int ret = control_in(handle, MCT_T5_CTRL_REQ_GET_EDID_BLOCK, 0, 0, block, sizeof(block));
+    if ((ret != sizeof(block)) || !mct_edid_header_valid(block)) {
+        /* Not every monitor has an EDID, and it's only used to pick the default mode. */
+        bool changed = cache->edid_len != 0;
+        cache->edid_len = 0;
+        return !changed;
+    }
+
+    if ((cache->edid_len >= MCT_EDID_BLOCK_LEN) && (memcmp(cache->edid, block, sizeof(block)) == 0)) {
+        return true;
+    }
+
+    memcpy(cache->edid, block, sizeof(block));
+    cache->edid_len = sizeof(block);
+    uint32_t block_count = 1 + block[126];
+    if (block_count > MCT_EDID_MAX_BLOCKS) {
+        block_count = MCT_EDID_MAX_BLOCKS;
+    }
+    for (uint32_t i = 1; i < block_count; i++) {
+        ret = control_in(handle, MCT_T5_CTRL_REQ_GET_EDID_BLOCK, i, 0, &cache->edid[cache->edid_len],
+            MCT_EDID_BLOCK_LEN);
+        if (ret != MCT_EDID_BLOCK_LEN) {
+            break;
+        }
+        cache->edid_len += MCT_EDID_BLOCK_LEN;
+    }
+
+    return false;
+}
+
+/* Returns the index of the first mode with the monitor's preferred resolution and refresh rate, or -1 if there isn't
+ * one. */
+static int find_preferred_mode(const mct_edid_info_t *edid, const mct_t5_video_mode_t *modes, int count) {
+    if (!edid->has_preferred_timing) {
+        return -1;
+    }
+
+    const mct_edid_detailed_timing_t * timing = &edid->preferred_timing;
+    double refresh_rate_hz = mct_edid_detailed_timing_refresh_rate_hz(timing);
+    for (int i = 0; i < count; i++) {
+        if ((modes[i].width == timing->h_active) && (modes[i].height == timing->v_active) &&
+            (modes[i].refresh_rate_hz == (uint8_t)(refresh_rate_hz + 0.5))) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void print_video_modes(const mct_t5_video_mode_t *modes, int count, FILE *out) {
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%2d: %4u x %4u x %2u bits @ %3u Hz, %3u MHz pixel clock (mode %u)\n", i, modes[i].width,
+            modes[i].height, modes[i].bits_per_pixel, modes[i].refresh_rate_hz, modes[i].pixel_clock_mhz,
+            modes[i].mode_number);
+    }
+}
+
+static bool wait_for_monitor(libusb_device_handle *handle) {
+    for (int i = 0; (i < HPD_POLL_TRIES) && !STOP_REQUESTED; i++) {
+        uint8_t hpd[2] = { 0 };
+        int ret = control_in(handle, MCT_T5_CTRL_REQ_GET_HPD, 0x00FF, 0x0003, hpd, sizeof(hpd));
+        if (ret < 0) {
+            fprintf(stderr, "Failed to check for a monitor: %s\n", libusb_strerror(ret));
+            return false;
+        }
+        if ((ret == sizeof(hpd)) && (mct_le16(hpd) != 0)) {
+            return true;
+        }
+        sleep_ms(HPD_POLL_INTERVAL_MS);
+    }
+
+    fprintf(stderr, "No monitor connected\n");
+    return false;
+}
+
+/* The same sequence as test_t5.py, minus the custom timings: reset, set the mode, reset the output, and hide the
+ * cursor. */
+static bool set_video_mode(libusb_device_handle *handle, uint16_t index) {
+    uint8_t status = 0;
+    uint8_t cursor_disable[4];
+    mct_set_le32(cursor_disable, 1);
+
+    int ret = control_in(handle, MCT_T5_CTRL_REQ_FIRMWARE_RESET, 0x0000, 0, &status, 1);
+    if (ret >= 0) {
+        ret = control_out(handle, MCT_T5_CTRL_REQ_SET_VIDEO_MODE, index, 0, NULL, 0);
+    }
+    if (ret >= 0) {
+        ret = control_in(handle, MCT_T5_CTRL_REQ_FIRMWARE_RESET, 0x0201, 0, &status, 1);
+    }
+    if (ret >= 0) {
+        ret = control_out(handle, MCT_T5_CTRL_REQ_SET_REGISTER, 0, T5_REG_CURSOR_DISABLE, cursor_disable,
+            sizeof(cursor_disable));
+    }
+    if (ret < 0) {
+        fprintf(stderr, "Failed to set the video mode: %s\n", libusb_strerror(ret));
+        return false;
+    }
+
+    return true;
+}
+
+static bool send_keepalive(stream_t *stream) {
+    uint8_t status = 0;
+    int ret = control_in(stream->handle, MCT_T5_CTRL_REQ_KEEPALIVE, 0x0002, 0, &status, 1);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to send a keepalive: %s\n", libusb_strerror(ret));
+        return false;
+    }
+
+    stream->last_keepalive_ns = monotonic_ns();
+    return true;
+}
+
+/* Sends the rectangle of the current frame as one uncompressed 24-bit bulk packet. The rows are converted straight
+ * into the transfer buffers, and the packet is flushed at the end so the next one starts a new transfer. */
+static bool send_rect(stream_t *stream, const mct_fb_rect_t *rect) {
+    size_t row_len = (size_t)rect->width * 3;
+    mct_t5_bulk_header_t header = {
+        .frame_counter = stream->frame_counter,
+        .frame_flags = MCT_T5_DEPTH_24 << MCT_T5_BULK_FRAME_FLAG_DEPTH_SHIFT,
+        .horiz_offset = rect->x,
+        .vert_offset = rect->y,
+        .width = rect->width,
+        .height = rect->height,
+        .payload_len = row_len * rect->height,
+    };
+
+    uint8_t buf[MCT_T5_BULK_HEADER_LEN];
+    mct_t5_bulk_header_build(&header, buf);
+    if (!mct_bulk_pool_write(&stream->pool, buf, sizeof(buf))) {
+        return false;
+    }
+
+    for (uint32_t y = 0; y < rect->height; y++) {
+        const uint32_t * src = &stream->cur[(size_t)(rect->y + y) * stream->width + rect->x];
+
+        uint32_t avail = 0;
+        uint8_t * space = mct_bulk_pool_space(&stream->pool, &avail);
+        if (!space) {
+            return false;
+        }
+
+        bool ok = false;
+        if (avail >= row_len) {
+            mct_t5_rect_encode_24(src, stream->width, rect->width, 1, space);
+            ok = mct_bulk_pool_commit(&stream->pool, row_len);
+        } else {
+            /* The row is split between two transfers. */
+            mct_t5_rect_encode_24(src, stream->width, rect->width, 1, stream->row);
+            ok = mct_bulk_pool_write(&stream->pool, stream->row, row_len);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    stream->frame_counter = (stream->frame_counter + 1) & 0x0FFF;
+    stream->packets_sent++;
+    stream->dirty_pixels += (uint64_t)rect->width * rect->height;
+    return mct_bulk_pool_flush(&stream->pool);
+}
+
+/* Sends the part of the current frame that changed since the last one, or all of it for the first frame. */
+static bool send_frame(stream_t *stream) {
+    mct_fb_rect_t rect = { 0, 0, stream->width, stream->height };
+    if (stream->have_prev && !mct_fb_dirty_rect(stream->prev, stream->cur, stream->width, stream->height, &rect)) {
+        stream->frames_unchanged++;
+        return true;
+    }
+
+    if (!send_rect(stream, &rect)) {
+        return false;
+    }
+
+    uint32_t * swap = stream->prev;
+    stream->prev = stream->cur;
+    stream->cur = swap;
+    stream->have_prev = true;
+    return true;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-b kB] [-c cache_dir|-] [-d bus.address] [-l] [-m index] [-n transfers] <frames.raw|->\n", argv0);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -b kB           Size of each bulk transfer (default: %u).\n", DEFAULT_SLOT_SIZE / 1024);
+    fprintf(stderr, "  -c cache_dir    Where to cache the mode table and monitor EDID, or - to not cache them\n");
+    fprintf(stderr, "                  (default: $XDG_CACHE_HOME/mct-usb-display-adapter).\n");
+    fprintf(stderr, "  -d bus.address  Adapter to use (default: the first Trigger 5 adapter).\n");
+    fprintf(stderr, "  -l              List the video modes supported by the adapter and exit.\n");
+    fprintf(stderr, "  -m index        Video mode to set, from the list printed by -l (default: the monitor's\n");
+    fprintf(stderr, "                  preferred mode, or 0).\n");
+    fprintf(stderr, "  -n transfers    Number of bulk transfers to keep in flight (default: %u, max: %u).\n",
+        DEFAULT_SLOT_COUNT, MCT_BULK_POOL_MAX_SLOTS);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Frames are read as raw bgr0 pixels at the resolution of the video mode.\n");
+}
+
+int main(int argc, char **argv) {
+    bool have_device = false;
+    uint32_t device_id = 0;
+    bool list_modes = false;
+    int mode_index = -1;
+    char default_cache_dir[4096];
+    const char * cache_dir = (mct_cache_default_dir(default_cache_dir, sizeof(default_cache_dir)) > 0) ?
+        default_cache_dir : NULL;
+    uint32_t slot_count = DEFAULT_SLOT_COUNT;
+    uint32_t slot_size = DEFAULT_SLOT_SIZE;
+
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "b:c:d:hlm:n:")) != -1) {
+        unsigned int bus = 0;
+        unsigned int address = 0;
+        switch (opt) {
+            case 'b':
+                slot_size = strtoul(optarg, NULL, 0) * 1024;
+                if ((slot_size == 0) || (slot_size > 16 * 1024 * 1024)) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c':
+                cache_dir = (strcmp(optarg, "-") == 0) ? NULL : optarg;
+                break;
+            case 'd':
+                if (sscanf(optarg, "%u.%u", &bus, &address) != 2) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                have_device = true;
+                device_id = (bus << 16) | (address & 0xFFFF);
+                break;
+            case 'l':
+                list_modes = true;
+                break;
+            case 'm':
+                mode_index = atoi(optarg);
+                if (mode_index < 0) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'n':
+                slot_count = strtoul(optarg, NULL, 0);
+                if ((slot_count == 0) || (slot_count > MCT_BULK_POOL_MAX_SLOTS)) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!list_modes && (optind != argc - 1)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    libusb_context * ctx = NULL;
+    int ret = libusb_init(&ctx);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to initialize libusb: %s\n", libusb_strerror(ret));
+        return EXIT_FAILURE;
+    }
+
+    static stream_t stream;
+    stream.handle = open_device(ctx, have_device, device_id);
+    if (!stream.handle) {
+        fprintf(stderr, "No Trigger 5 adapter found\n");
+        libusb_exit(ctx);
+        return EXIT_FAILURE;
+    }
+
+    /* The mode table only changes with the firmware, so it's cached by the firmware version (and the USB serial
+     * number), which has to be read every time anyway. */
+    static mct_cache_entry_t cache;
+    mct_t5_video_mode_t modes[MCT_T5_MAX_VIDEO_MODES];
+    int mode_count = -1;
+    bool cache_dirty = false;
+    uint64_t bring_up_start_ns = monotonic_ns();
+    bool ok = claim_device(stream.handle);
+    if (ok) {
+        char key[MCT_CACHE_KEY_MAX_LEN];
+        ok = get_info(stream.handle, key);
+        if (!ok) {
+            cache_dir = NULL;
+        }
+
+        bool cache_hit = cache_dir && mct_cache_load(cache_dir, key, &cache) &&
+            (cache.modes_len >= MCT_T5_VIDEO_MODES_HEADER_LEN);
+        if (!cache_hit) {
+            snprintf(cache.key, sizeof(cache.key), "%s", key);
+            int len = read_video_modes(stream.handle, cache.modes);
+            ok = len >= 0;
+            cache.modes_len = ok ? len : 0;
+            cache_dirty = true;
+        }
+        mode_count = mct_t5_video_modes_parse(cache.modes, cache.modes_len, modes, MCT_T5_MAX_VIDEO_MODES);
+        if (cache_hit) {
+            fprintf(stderr, "Using the cached mode table\n");
+        }
+    }
+
+    if (ok && list_modes) {
+        print_video_modes(modes, mode_count, stdout);
+        if (cache_dir && cache_dirty && (mct_cache_save(cache_dir, &cache) != 0)) {
+            fprintf(stderr, "Failed to save the mode table to %s: %s\n", cache_dir, strerror(errno));
+        }
+        libusb_close(stream.handle);
+        libusb_exit(ctx);
+        return EXIT_SUCCESS;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    ok = ok && wait_for_monitor(stream.handle);
+    if (ok) {
+        if (!read_edid(stream.handle, &cache)) {
+            cache_dirty = true;
+        }
+
+        mct_edid_info_t edid;
+        memset(&edid, 0, sizeof(edid));
+        if (cache.edid_len > 0) {
+            mct_edid_parse(cache.edid, cache.edid_len, &edid);
+            fprintf(stderr, "Monitor: %s %s\n", edid.manufacturer, edid.product_name);
+        }
+        if (mode_index < 0) {
+            mode_index = find_preferred_mode(&edid, modes, mode_count);
+            if (mode_index < 0) {
+                mode_index = 0;
+            }
+        }
+
+        if (cache_dir && cache_dirty && (mct_cache_save(cache_dir, &cache) != 0)) {
+            fprintf(stderr, "Failed to save the mode table to %s: %s\n", cache_dir, strerror(errno));
+        }
+    }
+
+    if (ok && ((mode_index < 0) || (mode_index >= mode_count))) {
+        fprintf(stderr, "No video mode %d, the adapter has %d:\n", mode_index, mode_count);
+        print_video_modes(modes, mode_count, stderr);
+        ok = false;
+    }
+
+    FILE * file = NULL;
+    if (ok) {
+        const char * path = argv[optind];
+        file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+        if (!file) {
+            perror(path);
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        stream.width = modes[mode_index].width;
+        stream.height = modes[mode_index].height;
+        size_t pixels = (size_t)stream.width * stream.height;
+        stream.cur = malloc(pixels * sizeof(uint32_t));
+        stream.prev = malloc(pixels * sizeof(uint32_t));
+        stream.row = malloc((size_t)stream.width * 3);
+        ok = stream.cur && stream.prev && stream.row &&
+            (mct_bulk_pool_init(&stream.pool, ctx, stream.handle, T5_BULK_OUT_ENDPOINT, slot_count, slot_size) == 0);
+        if (!ok) {
+            fprintf(stderr, "Failed to allocate the frame and transfer buffers\n");
+        }
+    }
+
+    ok = ok && set_video_mode(stream.handle, mode_index) && send_keepalive(&stream);
+    if (ok) {
+        fprintf(stderr, "Streaming %ux%u @ %u Hz (bring-up took %u control requests in %.1f ms)\n", stream.width,
+            stream.height, modes[mode_index].refresh_rate_hz, CONTROL_REQUESTS,
+            (monotonic_ns() - bring_up_start_ns) / 1e6);
+    }
+
+    uint64_t start_ns = monotonic_ns();
+    size_t frame_size = (size_t)stream.width * stream.height * sizeof(uint32_t);
+    while (ok && !STOP_REQUESTED && (fread(stream.cur, 1, frame_size, file) == frame_size)) {
+        stream.frames_read++;
+        ok = send_frame(&stream);
+        if (ok && (monotonic_ns() - stream.last_keepalive_ns >= KEEPALIVE_INTERVAL_NS)) {
+            ok = send_keepalive(&stream);
+        }
+    }
+
+    if (stream.pool.slot_count > 0) {
+        if (!mct_bulk_pool_drain(&stream.pool)) {
+            fprintf(stderr, "Bulk transfer failed: %s\n", mct_bulk_pool_status_name(stream.pool.failed_status));
+            ok = false;
+        }
+
+        double elapsed_s = (monotonic_ns() - start_ns) / 1e9;
+        fprintf(stderr, "%" PRIu64 " frames read, %" PRIu64 " unchanged, %" PRIu64 " packets sent (%.1f%% of the "
+            "pixels), %" PRIu64 " bytes in %" PRIu64 " transfers, %.1f Mbps\n", stream.frames_read,
+            stream.frames_unchanged, stream.packets_sent, stream.frames_read ?
+            100.0 * stream.dirty_pixels / ((double)stream.frames_read * stream.width * stream.height) : 0.0,
+            stream.pool.bytes, stream.pool.transfers, elapsed_s > 0 ? stream.pool.bytes * 8 / elapsed_s / 1e6 : 0.0);
+    }
+
+    mct_bulk_pool_free(&stream.pool);
+    free(stream.cur);
+    free(stream.prev);
+    free(stream.row);
+    if (file && (file != stdin)) {
+        fclose(file);
+    }
+    libusb_release_interface(stream.handle, T5_INTERFACE);
+    libusb_close(stream.handle);
+    libusb_exit(ctx);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
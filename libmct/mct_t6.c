@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_t6.c - Protocol decoding for MCT's Trigger 6 protocol.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mct_le.h"
+#include "mct_t6.h"
+
+
+void mct_t6_selector_parse(const uint8_t buf[MCT_T6_SELECTOR_LEN], mct_t6_selector_t *selector) {
+    selector->session_num = mct_le32(&buf[0]);
+    selector->payload_len = mct_le32(&buf[4]);
+    selector->dest_addr = mct_le32(&buf[8]);
+    selector->frag_len = mct_le32(&buf[12]);
+    selector->frag_offset = mct_le32(&buf[16]);
+}
+
+/* The inverse of mct_t6_selector_parse(). The driver sets the word after the fragment offset on every fragment of a
+ * payload but the last, and leaves the rest of the packet zeroed. */
+void mct_t6_selector_build(const mct_t6_selector_t *selector, bool more_fragments,
+    uint8_t buf[MCT_T6_SELECTOR_PACKET_LEN]) {
+    memset(buf, 0, MCT_T6_SELECTOR_PACKET_LEN);
+    mct_set_le32(&buf[0], selector->session_num);
+    mct_set_le32(&buf[4], selector->payload_len);
+    mct_set_le32(&buf[8], selector->dest_addr);
+    mct_set_le32(&buf[12], selector->frag_len);
+    mct_set_le32(&buf[16], selector->frag_offset);
+    mct_set_le32(&buf[20], more_fragments ? 1 : 0);
+}
+
+/* Whether the selector is for a known session and its fragment fits in its payload, which is as much as can be checked
+ * without knowing where the stream is. */
+bool mct_t6_selector_plausible(const mct_t6_selector_t *selector) {
+    if ((selector->session_num != MCT_T6_SESSION_VIDEO) && (selector->session_num != MCT_T6_SESSION_AUDIO) &&
+        (selector->session_num != MCT_T6_SESSION_FIRMWARE_UPDATE)) {
+        return false;
+    }
+
+    return (selector->frag_len > 0) && ((uint64_t)selector->frag_offset + selector->frag_len <= selector->payload_len);
+}
+
+void mct_t6_interrupt_parse(const uint8_t buf[MCT_T6_INTERRUPT_LEN], mct_t6_interrupt_t *interrupt) {
+    interrupt->type = mct_le32(&buf[0x00]);
+    interrupt->counter = mct_le32(&buf[0x0C]);
+    interrupt->change_flags = mct_le32(&buf[0x10]);
+    interrupt->state_flags = mct_le32(&buf[0x20]);
+    interrupt->firmware_update_status = mct_le32(&buf[0x2C]);
+    interrupt->firmware_update_progress = mct_le32(&buf[0x30]);
+}
+
+bool mct_t6_bulk_expects_selector(const mct_t6_bulk_state_t *state) {
+    return state->frag_len_remaining == 0;
+}
+
+void mct_t6_bulk_select(mct_t6_bulk_state_t *state, const mct_t6_selector_t *selector) {
+    state->selector = *selector;
+    state->payload_len_remaining = selector->payload_len - selector->frag_offset;
+    state->frag_len_remaining = selector->frag_len;
+}
+
+/* Accounts for a bulk transfer of the given reported length that follows the select session packet, returning the
+ * offset of the transfer's data within the session payload. */
+uint32_t mct_t6_bulk_continue(mct_t6_bulk_state_t *state, uint32_t len) {
+    uint32_t payload_offset = state->selector.payload_len - state->payload_len_remaining;
+
+    state->payload_len_remaining -= len;
+    state->frag_len_remaining -= len;
+
+    return payload_offset;
+}
+
+void mct_t6_video_header_parse(const uint8_t buf[MCT_T6_VIDEO_HEADER_LEN], mct_t6_video_header_t *header) {
+    header->packet_type = mct_le32(&buf[0]);
+    header->data_len = mct_le32(&buf[4]);
+    header->seq = mct_le32(&buf[8]);
+    header->width = mct_le16(&buf[16]);
+    header->height = mct_le16(&buf[18]);
+}
+
+/* Packet types 3, 4, and 7 have all been seen carrying JPEGs, and type 3 is also used for raw framebuffer updates, so
+ * look for the JPEG SOI marker instead of trusting the type. buf points to the data after the video header. */
+bool mct_t6_video_payload_is_jpeg(const uint8_t *buf, size_t len) {
+    return (len >= 2) && (buf[0] == 0xFF) && (buf[1] == 0xD8);
+}
+
+void mct_t6_pll_config_parse(const uint8_t buf[MCT_T6_PLL_CONFIG_LEN], mct_t6_pll_config_t *pll_config) {
+    pll_config->fnum = mct_le16(&buf[0]);
+    pll_config->fden = mct_le16(&buf[2]);
+    pll_config->idiv = buf[4];
+    pll_config->x2_en = (buf[5] & 0x02) != 0;
+    pll_config->x4_en = (buf[5] & 0x01) != 0;
+}
+
+uint32_t mct_t6_pll_mul(const mct_t6_pll_config_t *pll_config) {
+    uint32_t mul = 1;
+
+    if (pll_config->x2_en) {
+        mul *= 2;
+    }
+
+    if (pll_config->x4_en) {
+        mul *= 4;
+    }
+
+    return mul;
+}
+
+/* Unknown platforms are assumed to be Super Lite, since every adapter seen so far has been. */
+uint32_t mct_t6_pll_base_clock_mhz(uint32_t hw_platform) {
+    return (hw_platform == MCT_T6_HW_PLATFORM_LITE) ? 48 : 40;
+}
+
+double mct_t6_pll_freq_khz(const mct_t6_pll_config_t *pll_config, uint32_t base_clock_mhz) {
+    return ((pll_config->fnum + pll_config->fden * pll_config->idiv) * mct_t6_pll_mul(pll_config) * base_clock_mhz) / 32.0;
+}
+
+void mct_t6_video_mode_parse(const uint8_t buf[MCT_T6_VIDEO_MODE_LEN], mct_t6_video_mode_t *mode) {
+    mode->pixel_clock_khz = mct_le32(&buf[0]);
+    mode->refresh_rate_hz = mct_le16(&buf[4]);
+    mode->line_total_pixels = mct_le16(&buf[6]);
+    mode->line_active_pixels = mct_le16(&buf[8]);
+    mode->line_active_plus_front_porch_pixels = mct_le16(&buf[10]);
+    mode->line_sync_width = mct_le16(&buf[12]);
+    mode->frame_total_lines = mct_le16(&buf[14]);
+    mode->frame_active_lines = mct_le16(&buf[16]);
+    mode->frame_active_plus_front_porch_lines = mct_le16(&buf[18]);
+    mode->frame_sync_width = mct_le16(&buf[20]);
+    mct_t6_pll_config_parse(&buf[MCT_T6_VIDEO_MODE_PLL_CONFIG_OFFSET], &mode->pll_config);
+    mode->horizontal_sync_polarity = buf[28] != 0;
+    mode->vertical_sync_polarity = buf[29] != 0;
+    mode->reduced = buf[30] != 0;
+    mode->flags = buf[31];
+}
+
+/* The "reduced" and flags bytes of the mode the driver sets don't always match its entry in the mode table (the
+ * 3840 x 2160 @ 30 Hz mode has "reduced" set in the table but not when it's set), so they're ignored. */
+bool mct_t6_video_mode_same_timing(const mct_t6_video_mode_t *a, const mct_t6_video_mode_t *b) {
+    return (a->pixel_clock_khz == b->pixel_clock_khz) &&
+        (a->refresh_rate_hz == b->refresh_rate_hz) &&
+        (a->line_total_pixels == b->line_total_pixels) &&
+        (a->line_active_pixels == b->line_active_pixels) &&
+        (a->line_active_plus_front_porch_pixels == b->line_active_plus_front_porch_pixels) &&
+        (a->line_sync_width == b->line_sync_width) &&
+        (a->frame_total_lines == b->frame_total_lines) &&
+        (a->frame_active_lines == b->frame_active_lines) &&
+        (a->frame_active_plus_front_porch_lines == b->frame_active_plus_front_porch_lines) &&
+        (a->frame_sync_width == b->frame_sync_width) &&
+        (a->pll_config.fnum == b->pll_config.fnum) &&
+        (a->pll_config.fden == b->pll_config.fden) &&
+        (a->pll_config.idiv == b->pll_config.idiv) &&
+        (a->pll_config.x2_en == b->pll_config.x2_en) &&
+        (a->pll_config.x4_en == b->pll_config.x4_en) &&
+        (a->horizontal_sync_polarity == b->horizontal_sync_polarity) &&
+        (a->vertical_sync_polarity == b->vertical_sync_polarity);
+}
+
+/* The refresh rate the PLL actually produces, as opposed to the nominal refresh_rate_hz. */
+double mct_t6_video_mode_refresh_rate_hz(const mct_t6_video_mode_t *mode, uint32_t base_clock_mhz) {
+    uint32_t clocks_per_frame = (uint32_t)mode->line_total_pixels * mode->frame_total_lines;
+    if (clocks_per_frame == 0) {
+        return 0;
+    }
+
+    return (mct_t6_pll_freq_khz(&mode->pll_config, base_clock_mhz) * 1e3) / clocks_per_frame;
+}
+
+bool mct_t6_img_magic_valid(const uint8_t *buf, size_t len) {
+    return (len >= 4) && (memcmp(buf, "IMG_", 4) == 0);
+}
+
+void mct_t6_img_header_parse(const uint8_t buf[MCT_T6_IMG_HEADER_LEN], mct_t6_img_header_t *header) {
+    header->len = mct_le32(&buf[4]);
+    header->crc = mct_le32(&buf[8]);
+    header->image_code_version = mct_le32(&buf[20]);
+    header->firmware_offset = mct_le32(&buf[24]);
+    header->firmware_len = mct_le32(&buf[28]);
+    for (size_t i = 0; i < MCT_T6_IMG_CONFIG_COUNT; i++) {
+        header->config_offsets[i] = mct_le32(&buf[MCT_T6_IMG_CONFIG_OFFSETS_OFFSET + 4 * i]);
+    }
+    memcpy(header->project_code, &buf[MCT_T6_IMG_PROJECT_CODE_OFFSET], MCT_T6_IMG_PROJECT_CODE_LEN);
+    header->project_code[MCT_T6_IMG_PROJECT_CODE_LEN] = '\0';
+}
+
+void mct_t6_img_config_header_parse(const uint8_t buf[MCT_T6_IMG_CONFIG_HEADER_LEN], mct_t6_img_config_header_t *config_header) {
+    memcpy(config_header->type, buf, 4);
+    config_header->type[4] = '\0';
+    config_header->len = mct_le32(&buf[4]);
+}
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_t6.h - Protocol decoding for MCT's Trigger 6 protocol.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_T6_H_INCLUDED
+#define MCT_T6_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MCT_T6_CONTROL_REQ_SET_VIDEO_OUTPUT_STATE 0x03
+#define MCT_T6_CONTROL_REQ_SET_CURSOR_POS 0x04
+#define MCT_T6_CONTROL_REQ_SET_CURSOR_STATE 0x05
+#define MCT_T6_CONTROL_REQ_UPLOAD_CURSOR 0x10
+#define MCT_T6_CONTROL_REQ_SET_VIDEO_MODE 0x12
+#define MCT_T6_CONTROL_REQ_GET_EDID_BLOCK 0x80
+#define MCT_T6_CONTROL_REQ_GET_CONNECTOR_STATUS 0x87
+#define MCT_T6_CONTROL_REQ_GET_VRAM_SIZE 0x88
+#define MCT_T6_CONTROL_REQ_GET_VIDEO_MODES 0x89
+#define MCT_T6_CONTROL_REQ_GET_INFO_FIELD 0xB0
+
+#define MCT_T6_INFO_FIELD_HW_PLATFORM 0
+#define MCT_T6_INFO_FIELD_IMAGE_CODE_VERSION 2
+#define MCT_T6_INFO_FIELD_SERIAL 5
+#define MCT_T6_INFO_FIELD_SERIAL_LEN 8
+
+/* The mode table is an array of MCT_T6_VIDEO_MODE_LEN-byte modes, read in chunks of up to this many bytes. */
+#define MCT_T6_VIDEO_MODES_CHUNK_LEN 512
+
+#define MCT_T6_HW_PLATFORM_LITE 0
+#define MCT_T6_HW_PLATFORM_SUPER_LITE 1
+
+#define MCT_T6_CURSOR_COUNT 10
+/* Cursor data starts with the pixel format, width, height, and stride, each a 16-bit little-endian value. */
+#define MCT_T6_CURSOR_HEADER_LEN 8
+
+/* The select session packet is 32 bytes long, but only the first 20 bytes are understood. */
+#define MCT_T6_SELECTOR_PACKET_LEN 32
+#define MCT_T6_SELECTOR_LEN 20
+
+#define MCT_T6_VIDEO_HEADER_LEN 0x30
+
+#define MCT_T6_PLL_CONFIG_LEN 6
+
+#define MCT_T6_VIDEO_MODE_LEN 32
+#define MCT_T6_VIDEO_MODE_PLL_CONFIG_OFFSET 22
+
+/* Every interrupt IN packet is 64 bytes long. The packet type seems to be a bit mask, since a packet with both the
+ * status change and current state bits set has been seen. */
+#define MCT_T6_INTERRUPT_LEN 64
+#define MCT_T6_INTERRUPT_TYPE_STATUS_CHANGE 0x04
+#define MCT_T6_INTERRUPT_TYPE_CURRENT_STATE 0x20
+#define MCT_T6_INTERRUPT_TYPE_FIRMWARE_UPDATE_STATUS 0x80
+#define MCT_T6_INTERRUPT_CHANGE_CONNECTOR_0 (1U << 24)
+#define MCT_T6_INTERRUPT_CHANGE_CONNECTOR_1 (1U << 25)
+#define MCT_T6_INTERRUPT_CHANGE_UNKNOWN_26 (1U << 26)
+#define MCT_T6_INTERRUPT_STATE_CONNECTOR_0_CONNECTED (1U << 25)
+#define MCT_T6_INTERRUPT_STATE_CONNECTOR_1_CONNECTED (1U << 26)
+
+#define MCT_T6_SESSION_VIDEO 0
+#define MCT_T6_SESSION_AUDIO 3
+#define MCT_T6_SESSION_FIRMWARE_UPDATE 5
+
+/* The layout of the firmware images sent in the firmware update session, as described in doc/mct_t6img.ksy. */
+#define MCT_T6_IMG_HEADER_LEN 100
+#define MCT_T6_IMG_CONFIG_COUNT 12
+#define MCT_T6_IMG_CONFIG_OFFSETS_OFFSET 32
+#define MCT_T6_IMG_PROJECT_CODE_OFFSET 80
+#define MCT_T6_IMG_PROJECT_CODE_LEN 16
+#define MCT_T6_IMG_CONFIG_HEADER_LEN 12
+
+typedef struct mct_t6_selector_s {
+    uint32_t session_num;
+    uint32_t payload_len;
+    uint32_t dest_addr;
+    uint32_t frag_len;
+    uint32_t frag_offset;
+} mct_t6_selector_t;
+
+/* Where the bulk stream is within the data announced by the last select session packet. A zeroed state expects a
+ * select session packet. */
+typedef struct mct_t6_bulk_state_s {
+    mct_t6_selector_t selector;
+    uint32_t payload_len_remaining;
+    uint32_t frag_len_remaining;
+} mct_t6_bulk_state_t;
+
+/* The fields of an interrupt IN packet that are at least partly understood. */
+typedef struct mct_t6_interrupt_s {
+    uint32_t type;
+    uint32_t counter;
+    uint32_t change_flags;
+    uint32_t state_flags;
+    uint32_t firmware_update_status;
+    uint32_t firmware_update_progress;
+} mct_t6_interrupt_t;
+
+/* For type 7 packets, width and height are the dimensions of the JPEG. For full frames (type 4), they're the strides of
+ * the chroma and luma planes of the framebuffer the frame is decoded into instead. */
+typedef struct mct_t6_video_header_s {
+    uint32_t packet_type;
+    uint32_t data_len;
+    uint32_t seq;
+    uint16_t width;
+    uint16_t height;
+} mct_t6_video_header_t;
+
+typedef struct mct_t6_pll_config_s {
+    uint16_t fnum;
+    uint16_t fden;
+    uint8_t idiv;
+    bool x2_en;
+    bool x4_en;
+} mct_t6_pll_config_t;
+
+/* One record of the "Get array of video modes" response, which is the same as the "Set video mode" request data. */
+typedef struct mct_t6_video_mode_s {
+    uint32_t pixel_clock_khz;
+    uint16_t refresh_rate_hz;
+    uint16_t line_total_pixels;
+    uint16_t line_active_pixels;
+    uint16_t line_active_plus_front_porch_pixels;
+    uint16_t line_sync_width;
+    uint16_t frame_total_lines;
+    uint16_t frame_active_lines;
+    uint16_t frame_active_plus_front_porch_lines;
+    uint16_t frame_sync_width;
+    mct_t6_pll_config_t pll_config;
+    bool horizontal_sync_polarity;
+    bool vertical_sync_polarity;
+    bool reduced;
+    uint8_t flags;
+} mct_t6_video_mode_t;
+
+typedef struct mct_t6_img_header_s {
+    uint32_t len;
+    uint32_t crc;
+    uint32_t image_code_version;
+    uint32_t firmware_offset;
+    uint32_t firmware_len;
+    uint32_t config_offsets[MCT_T6_IMG_CONFIG_COUNT];
+    char project_code[MCT_T6_IMG_PROJECT_CODE_LEN + 1];
+} mct_t6_img_header_t;
+
+/* The header of each config the image header points to. len includes the header. */
+typedef struct mct_t6_img_config_header_s {
+    char type[5];
+    uint32_t len;
+} mct_t6_img_config_header_t;
+
+void mct_t6_selector_parse(const uint8_t buf[MCT_T6_SELECTOR_LEN], mct_t6_selector_t *selector);
+void mct_t6_selector_build(const mct_t6_selector_t *selector, bool more_fragments,
+    uint8_t buf[MCT_T6_SELECTOR_PACKET_LEN]);
+bool mct_t6_selector_plausible(const mct_t6_selector_t *selector);
+
+void mct_t6_interrupt_parse(const uint8_t buf[MCT_T6_INTERRUPT_LEN], mct_t6_interrupt_t *interrupt);
+
+bool mct_t6_bulk_expects_selector(const mct_t6_bulk_state_t *state);
+void mct_t6_bulk_select(mct_t6_bulk_state_t *state, const mct_t6_selector_t *selector);
+uint32_t mct_t6_bulk_continue(mct_t6_bulk_state_t *state, uint32_t len);
+
+void mct_t6_video_header_parse(const uint8_t buf[MCT_T6_VIDEO_HEADER_LEN], mct_t6_video_header_t *header);
+bool mct_t6_video_payload_is_jpeg(const uint8_t *buf, size_t len);
+
+void mct_t6_pll_config_parse(const uint8_t buf[MCT_T6_PLL_CONFIG_LEN], mct_t6_pll_config_t *pll_config);
+uint32_t mct_t6_pll_mul(const mct_t6_pll_config_t *pll_config);
+uint32_t mct_t6_pll_base_clock_mhz(uint32_t hw_platform);
+double mct_t6_pll_freq_khz(const mct_t6_pll_config_t *pll_config, uint32_t base_clock_mhz);
+
+void mct_t6_video_mode_parse(const uint8_t buf[MCT_T6_VIDEO_MODE_LEN], mct_t6_video_mode_t *mode);
+bool mct_t6_video_mode_same_timing(const mct_t6_video_mode_t *a, const mct_t6_video_mode_t *b);
+double mct_t6_video_mode_refresh_rate_hz(const mct_t6_video_mode_t *mode, uint32_t base_clock_mhz);
+
+bool mct_t6_img_magic_valid(const uint8_t *buf, size_t len);
+void mct_t6_img_header_parse(const uint8_t buf[MCT_T6_IMG_HEADER_LEN], mct_t6_img_header_t *header);
+void mct_t6_img_config_header_parse(const uint8_t buf[MCT_T6_IMG_CONFIG_HEADER_LEN], mct_t6_img_config_header_t *config_header);
+
+#endif // MCT_T6_H_INCLUDED
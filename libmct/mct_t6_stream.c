@@ -0,0 +1,1083 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_t6_stream.c - Streams video (as JPEGs) and audio to an MCT Trigger 6 display adapter over libusb.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <jpeglib.h>
+#include <libusb.h>
+
+#include "mct_analysis.h"
+#include "mct_bulk_pool.h"
+#include "mct_cache.h"
+#include "mct_edid.h"
+#include "mct_framebuffer.h"
+#include "mct_le.h"
+#include "mct_t6.h"
+
+#define T6_INTERFACE 0
+#define T6_BULK_OUT_ENDPOINT 0x02
+
+#define CONTROL_IN (LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE)
+#define CONTROL_OUT (LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE)
+#define CONTROL_TIMEOUT_MS 1000
+
+/* Sent by the driver with the first word set to 1 right before it starts the audio session, and with it cleared when
+ * the audio stops. What the rest of it means isn't known, but 9600 is the length of the first audio chunk. */
+#define T6_CONTROL_REQ_SET_AUDIO_STATE 0x24
+#define T6_AUDIO_STATE_LEN 16
+
+/* The largest fragment the driver sends, so the bulk transfers are sized to match. */
+#define T6_MAX_FRAGMENT_LEN 0x19000
+
+#define T6_MAX_VIDEO_MODES (MCT_CACHE_MODES_MAX_LEN / MCT_T6_VIDEO_MODE_LEN)
+
+/* The cached info is the hardware platform and the video RAM size, in bytes. */
+#define T6_CACHE_INFO_LEN 8
+
+/* Full frames are JPEGs decoded into one of three NV12 framebuffers in turn, and the JPEGs themselves are written to a
+ * ring buffer in the rest of the video RAM. The video header fields other than the type, length, sequence number,
+ * strides, and plane addresses are set to what the driver sends. */
+#define T6_VIDEO_TYPE_JPEG 4
+#define T6_VIDEO_HEADER_WORD_0C 6
+#define T6_VIDEO_HEADER_WORD_20 0x0D
+#define T6_FRAMEBUFFER_COUNT 3
+#define T6_STRIDE_ALIGN 16
+#define T6_PLANE_LINES_ALIGN 16
+#define T6_FRAMEBUFFER_ALIGN 0x1000
+#define T6_JPEG_RING_ALIGN 0x100000
+/* Where the driver's JPEG ring buffer starts, which leaves room for three 3840 x 2160 framebuffers. */
+#define T6_JPEG_RING_START 0x03000000
+
+/* 48 kHz 16-bit stereo, sent in 10 ms chunks after a 50 ms first chunk, like the driver does. */
+#define AUDIO_BYTES_PER_SECOND (48000 * 4)
+#define AUDIO_FRAME_LEN 4
+#define AUDIO_CHUNK_LEN 1920
+#define AUDIO_FIRST_CHUNK_LEN 9600
+
+#define CONNECTOR_POLL_INTERVAL_MS 100
+#define CONNECTOR_POLL_TRIES 50
+
+#define DEFAULT_JOBS 2
+#define MAX_JOBS 16
+#define DEFAULT_QUALITY 85
+#define DEFAULT_SLOT_COUNT 8
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_READ,
+    SLOT_ENCODING,
+    SLOT_ENCODED,
+    SLOT_FAILED,
+} slot_state_t;
+
+/* A frame that's read by the main thread, encoded by one of the workers, and then sent by the main thread. */
+typedef struct frame_slot_s {
+    uint32_t * pixels;
+    unsigned char * jpeg;
+    unsigned long jpeg_capacity;
+    unsigned long jpeg_len;
+    slot_state_t state;
+} frame_slot_t;
+
+/* The slots are filled in turn, and each one is sent before it's filled again, so frames are sent in order while up
+ * to all of them are being encoded. */
+typedef struct encoder_s {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t slot_count;
+    frame_slot_t slots[MAX_JOBS + 2];
+    bool closed;
+
+    uint32_t width;
+    uint32_t height;
+    int quality;
+} encoder_t;
+
+typedef struct jpeg_error_s {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jmp;
+} jpeg_error_t;
+
+typedef struct stream_s {
+    libusb_device_handle * handle;
+    mct_bulk_pool_t pool;
+    encoder_t * encoder;
+    uint16_t output_index;
+
+    /* Where everything goes in the video RAM. */
+    uint32_t stride;
+    uint32_t chroma_offset;
+    uint32_t framebuffer_size;
+    uint32_t framebuffer_index;
+    uint32_t ring_start;
+    uint32_t ring_end;
+    uint32_t ring_pos;
+    uint32_t seq;
+
+    /* Held while queueing a select session packet and its fragment, so the audio thread's fragments can only end up
+     * between the video's fragments, never between a select session packet and its fragment. Each select session
+     * packet describes its fragment in full, so payloads of different sessions can be interleaved like that. */
+    pthread_mutex_t bulk_lock;
+    bool audio_stop;
+
+    FILE * audio;
+    uint64_t audio_bytes;
+    uint8_t audio_buf[AUDIO_FIRST_CHUNK_LEN];
+
+    uint64_t frames_read;
+    uint64_t frames_unchanged;
+    uint64_t frames_sent;
+    uint64_t jpeg_bytes;
+} stream_t;
+
+static volatile sig_atomic_t STOP_REQUESTED;
+static uint32_t CONTROL_REQUESTS;
+
+
+static void handle_signal(int signum) {
+    (void)signum;
+    STOP_REQUESTED = 1;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR) && !STOP_REQUESTED) {
+        continue;
+    }
+}
+
+static uint64_t align_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static int control_in(libusb_device_handle *handle, uint8_t request, uint16_t value, uint16_t index, uint8_t *buf,
+    uint16_t len) {
+    CONTROL_REQUESTS++;
+    return libusb_control_transfer(handle, CONTROL_IN, request, value, index, buf, len, CONTROL_TIMEOUT_MS);
+}
+
+static int control_out(libusb_device_handle *handle, uint8_t request, uint16_t value, uint16_t index, uint8_t *buf,
+    uint16_t len) {
+    CONTROL_REQUESTS++;
+    return libusb_control_transfer(handle, CONTROL_OUT, request, value, index, buf, len, CONTROL_TIMEOUT_MS);
+}
+
+static void jpeg_error_exit(j_common_ptr cinfo) {
+    longjmp(((jpeg_error_t *)cinfo->err)->jmp, 1);
+}
+
+/* Encodes the slot's frame the way the driver's JPEGs are: baseline, 4:2:0, with component IDs starting at 0 and a
+ * restart marker after every MCU. */
+static bool encode_jpeg(const encoder_t *encoder, frame_slot_t *slot) {
+    struct jpeg_compress_struct cinfo;
+    jpeg_error_t err;
+    unsigned char * buf = slot->jpeg;
+    unsigned long len = slot->jpeg_capacity;
+
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpeg_error_exit;
+    if (setjmp(err.jmp)) {
+        jpeg_destroy_compress(&cinfo);
+        if (buf != slot->jpeg) {
+            free(buf);
+        }
+        return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &buf, &len);
+    cinfo.image_width = encoder->width;
+    cinfo.image_height = encoder->height;
+    cinfo.input_components = 4;
+    cinfo.in_color_space = JCS_EXT_BGRX;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, encoder->quality, TRUE);
+    for (int i = 0; i < cinfo.num_components; i++) {
+        cinfo.comp_info[i].component_id = i;
+    }
+    cinfo.restart_interval = 1;
+
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = (JSAMPROW)&slot->pixels[(size_t)cinfo.next_scanline * encoder->width];
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    /* libjpeg allocates a new buffer if the JPEG doesn't fit, which then replaces the slot's. */
+    if (buf != slot->jpeg) {
+        free(slot->jpeg);
+        slot->jpeg = buf;
+        slot->jpeg_capacity = len;
+    }
+    slot->jpeg_len = len;
+    return true;
+}
+
+static frame_slot_t * next_slot_to_encode(encoder_t *encoder) {
+    for (uint32_t i = 0; i < encoder->slot_count; i++) {
+        if (encoder->slots[i].state == SLOT_READ) {
+            return &encoder->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void * encoder_thread(void *arg) {
+    encoder_t * encoder = arg;
+
+    pthread_mutex_lock(&encoder->lock);
+    for (;;) {
+        frame_slot_t * slot = next_slot_to_encode(encoder);
+        if (!slot) {
+            if (encoder->closed) {
+                break;
+            }
+            pthread_cond_wait(&encoder->cond, &encoder->lock);
+            continue;
+        }
+
+        slot->state = SLOT_ENCODING;
+        pthread_mutex_unlock(&encoder->lock);
+        bool ok = encode_jpeg(encoder, slot);
+        pthread_mutex_lock(&encoder->lock);
+
+        slot->state = ok ? SLOT_ENCODED : SLOT_FAILED;
+        pthread_cond_broadcast(&encoder->cond);
+    }
+    pthread_mutex_unlock(&encoder->lock);
+
+    return NULL;
+}
+
+/* Opens the first Trigger 6 adapter, or the one at device_id if have_device is set. */
+static libusb_device_handle * open_device(libusb_context *ctx, bool have_device, uint32_t device_id) {
+    libusb_device ** list = NULL;
+    ssize_t count = libusb_get_device_list(ctx, &list);
+    if (count < 0) {
+        return NULL;
+    }
+
+    libusb_device_handle * handle = NULL;
+    for (ssize_t i = 0; i < count; i++) {
+        struct libusb_device_descriptor desc;
+        if (libusb_get_device_descriptor(list[i], &desc) != 0) {
+            continue;
+        }
+        if (mct_protocol_from_usb_id(desc.idVendor, desc.idProduct) != MCT_PROTOCOL_T6) {
+            continue;
+        }
+
+        uint32_t id = ((uint32_t)libusb_get_bus_number(list[i]) << 16) | libusb_get_device_address(list[i]);
+        if (have_device && (id != device_id)) {
+            continue;
+        }
+
+        int ret = libusb_open(list[i], &handle);
+        if (ret != 0) {
+            fprintf(stderr, "Failed to open device %u.%u: %s\n", id >> 16, id & 0xFFFF, libusb_strerror(ret));
+            handle = NULL;
+        }
+        break;
+    }
+
+    libusb_free_device_list(list, 1);
+    return handle;
+}
+
+static bool claim_device(libusb_device_handle *handle) {
+    int config = 0;
+    if ((libusb_get_configuration(handle, &config) != 0) || (config != 1)) {
+        int ret = libusb_set_configuration(handle, 1);
+        if (ret != 0) {
+            fprintf(stderr, "Failed to set the configuration: %s\n", libusb_strerror(ret));
+            return false;
+        }
+    }
+
+    libusb_set_auto_detach_kernel_driver(handle, 1);
+    int ret = libusb_claim_interface(handle, T6_INTERFACE);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to claim the interface: %s\n", libusb_strerror(ret));
+        return false;
+    }
+
+    return true;
+}
+
+/* Returns the 32-bit info field, or -1 on error. */
+static int64_t get_info_field(libusb_device_handle *handle, uint16_t field) {
+    uint8_t buf[4] = { 0 };
+    int ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_INFO_FIELD, 0, field, buf, sizeof(buf));
+    if (ret != sizeof(buf)) {
+        return -1;
+    }
+    return mct_le32(buf);
+}
+
+/* Returns the video RAM size in bytes, or 0 on error. */
+static uint32_t get_vram_size(libusb_device_handle *handle) {
+    uint8_t size_mb = 0;
+    int ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_VRAM_SIZE, 0, 0, &size_mb, 1);
+    if (ret != 1) {
+        return 0;
+    }
+    return (uint32_t)size_mb << 20;
+}
+
+/* Returns the serial number as a hex string, which is empty on error. */
+static void get_serial(libusb_device_handle *handle, char serial[2 * MCT_T6_INFO_FIELD_SERIAL_LEN + 1]) {
+    uint8_t buf[MCT_T6_INFO_FIELD_SERIAL_LEN] = { 0 };
+    serial[0] = '\0';
+    int ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_INFO_FIELD, 0, MCT_T6_INFO_FIELD_SERIAL, buf, sizeof(buf));
+    if (ret != sizeof(buf)) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        snprintf(&serial[2 * i], 3, "%02x", buf[i]);
+    }
+}
+
+/* Reads the output's mode table into buf, returning its length, or -1 on error. */
+static int read_video_modes(libusb_device_handle *handle, uint16_t output_index,
+    uint8_t buf[T6_MAX_VIDEO_MODES * MCT_T6_VIDEO_MODE_LEN]) {
+    int len = 0;
+    while (len < T6_MAX_VIDEO_MODES * MCT_T6_VIDEO_MODE_LEN) {
+        int ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_VIDEO_MODES, output_index, len, &buf[len],
+            MCT_T6_VIDEO_MODES_CHUNK_LEN);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to get the video modes: %s\n", libusb_strerror(ret));
+            return -1;
+        }
+
+        len += ret;
+        if (ret < MCT_T6_VIDEO_MODES_CHUNK_LEN) {
+            break;
+        }
+    }
+
+    return len;
+}
+
+/* Returns the number of modes in the table. The table ends at its end or at the first mode without a pixel clock. */
+static int parse_video_modes(const uint8_t *buf, uint32_t len, mct_t6_video_mode_t modes[T6_MAX_VIDEO_MODES]) {
+    int count = 0;
+    for (; count < (int)(len / MCT_T6_VIDEO_MODE_LEN); count++) {
+        mct_t6_video_mode_parse(&buf[count * MCT_T6_VIDEO_MODE_LEN], &modes[count]);
+        if ((modes[count].pixel_clock_khz == 0) || (modes[count].line_active_pixels == 0) ||
+            (modes[count].frame_active_lines == 0)) {
+            break;
+        }
+    }
+
+    return count;
+}
+
+/* Reads the monitor's EDID into the cache entry, returning false if it changed since it was cached. If the base block
+ * matches the cached one, the rest of the cached EDID is used as is, since the base block has the monitor's model and
+ * serial number and the number of extensions. */
+static bool read_edid(libusb_device_handle *handle, uint16_t output_index, mct_cache_entry_t *cache) {
+    uint8_t block[MCT_EDID_BLOCK_LEN];
+    int ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_EDID_BLOCK, 0, output_index, block, sizeof(block));
+    if ((ret != sizeof(block)) || !mct_edid_header_valid(block)) {
+        /* Not every monitor has an EDID, and it's only used to pick the default mode. */
+        bool changed = cache->edid_len != 0;
+        cache->edid_len = 0;
+        return !changed;
+    }
+
+    if ((cache->edid_len >= MCT_EDID_BLOCK_LEN) && (memcmp(cache->edid, block, sizeof(block)) == 0)) {
+        return true;
+    }
+
+    memcpy(cache->edid, block, sizeof(block));
+    cache->edid_len = sizeof(block);
+    uint32_t block_count = 1 + block[126];
+    if (block_count > MCT_EDID_MAX_BLOCKS) {
+        block_count = MCT_EDID_MAX_BLOCKS;
+    }
+    for (uint32_t i = 1; i < block_count; i++) {
+        ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_EDID_BLOCK, i * MCT_EDID_BLOCK_LEN, output_index,
+            &cache->edid[cache->edid_len], MCT_EDID_BLOCK_LEN);
+        if (ret != MCT_EDID_BLOCK_LEN) {
+            break;
+        }
+        cache->edid_len += MCT_EDID_BLOCK_LEN;
+    }
+
+    return false;
+}
+
+/* Returns the index of the first mode with the monitor's preferred timing, or -1 if there isn't one. */
+static int find_preferred_mode(const mct_edid_info_t *edid, const mct_t6_video_mode_t *modes, int count) {
+    if (!edid->has_preferred_timing) {
+        return -1;
+    }
+
+    const mct_edid_detailed_timing_t * timing = &edid->preferred_timing;
+    double refresh_rate_hz = mct_edid_detailed_timing_refresh_rate_hz(timing);
+    for (int i = 0; i < count; i++) {
+        if ((modes[i].line_active_pixels == timing->h_active) && (modes[i].frame_active_lines == timing->v_active) &&
+            (modes[i].refresh_rate_hz == (uint16_t)(refresh_rate_hz + 0.5))) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void print_video_modes(const mct_t6_video_mode_t *modes, int count, uint32_t base_clock_mhz, FILE *out) {
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%2d: %4u x %4u @ %3u Hz (%.5g Hz), %.2f MHz pixel clock\n", i, modes[i].line_active_pixels,
+            modes[i].frame_active_lines, modes[i].refresh_rate_hz,
+            mct_t6_video_mode_refresh_rate_hz(&modes[i], base_clock_mhz), modes[i].pixel_clock_khz / 1e3);
+    }
+}
+
+static bool wait_for_monitor(libusb_device_handle *handle, uint16_t output_index) {
+    for (int i = 0; (i < CONNECTOR_POLL_TRIES) && !STOP_REQUESTED; i++) {
+        uint8_t status = 0;
+        int ret = control_in(handle, MCT_T6_CONTROL_REQ_GET_CONNECTOR_STATUS, output_index, 0, &status, 1);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to check for a monitor: %s\n", libusb_strerror(ret));
+            return false;
+        }
+        if ((ret == 1) && (status != 0)) {
+            return true;
+        }
+        sleep_ms(CONNECTOR_POLL_INTERVAL_MS);
+    }
+
+    fprintf(stderr, "No monitor connected to output %u\n", output_index);
+    return false;
+}
+
+static bool set_video_mode(libusb_device_handle *handle, uint16_t output_index, uint8_t mode[MCT_T6_VIDEO_MODE_LEN]) {
+    int ret = control_out(handle, MCT_T6_CONTROL_REQ_SET_VIDEO_MODE, output_index, 0, mode, MCT_T6_VIDEO_MODE_LEN);
+    if (ret >= 0) {
+        ret = control_out(handle, MCT_T6_CONTROL_REQ_SET_VIDEO_OUTPUT_STATE, output_index, 1, NULL, 0);
+    }
+    if (ret < 0) {
+        fprintf(stderr, "Failed to set the video mode: %s\n", libusb_strerror(ret));
+        return false;
+    }
+
+    return true;
+}
+
+static bool set_audio_state(libusb_device_handle *handle, bool enabled) {
+    uint8_t buf[T6_AUDIO_STATE_LEN] = { 0 };
+    mct_set_le32(&buf[0], enabled ? 1 : 0);
+    mct_set_le32(&buf[8], AUDIO_FIRST_CHUNK_LEN);
+    mct_set_le32(&buf[12], 0x02000000);
+
+    int ret = control_out(handle, T6_CONTROL_REQ_SET_AUDIO_STATE, 0, 0, buf, sizeof(buf));
+    if (ret < 0) {
+        fprintf(stderr, "Failed to set the audio state: %s\n", libusb_strerror(ret));
+        return false;
+    }
+    return true;
+}
+
+/* Lays out the framebuffers and the JPEG ring buffer in the video RAM. Returns false if they don't fit. */
+static bool plan_vram(stream_t *stream, uint32_t width, uint32_t height, uint32_t vram_size) {
+    uint64_t plane_lines = align_up(height, T6_PLANE_LINES_ALIGN);
+    stream->stride = align_up(width, T6_STRIDE_ALIGN);
+    stream->chroma_offset = stream->stride * plane_lines;
+
+    uint64_t framebuffer_size = align_up(stream->chroma_offset + stream->chroma_offset / 2, T6_FRAMEBUFFER_ALIGN);
+    uint64_t ring_start = align_up(framebuffer_size * T6_FRAMEBUFFER_COUNT, T6_JPEG_RING_ALIGN);
+    if (ring_start < T6_JPEG_RING_START) {
+        ring_start = T6_JPEG_RING_START;
+    }
+    if (ring_start >= vram_size) {
+        return false;
+    }
+
+    stream->framebuffer_size = framebuffer_size;
+    stream->ring_start = ring_start;
+    stream->ring_end = vram_size;
+    stream->ring_pos = ring_start;
+    return true;
+}
+
+/* Sends a session payload as select session packets, each followed by its fragment (the rest of header and then the
+ * rest of data) in its own transfer. Each select session packet is submitted together with its fragment, and the bulk
+ * lock is only held for that pair, so the audio doesn't have to wait for all of a large frame to be queued. */
+static bool send_payload(stream_t *stream, uint32_t session_num, uint32_t dest_addr, const uint8_t *header,
+    uint32_t header_len, const uint8_t *data, uint32_t data_len) {
+    uint32_t payload_len = header_len + data_len;
+    uint32_t frag_offset = 0;
+    while (frag_offset < payload_len) {
+        mct_t6_selector_t selector = {
+            .session_num = session_num,
+            .payload_len = payload_len,
+            .dest_addr = dest_addr,
+            .frag_len = payload_len - frag_offset,
+            .frag_offset = frag_offset,
+        };
+        if (selector.frag_len > T6_MAX_FRAGMENT_LEN) {
+            selector.frag_len = T6_MAX_FRAGMENT_LEN;
+        }
+
+        uint8_t buf[MCT_T6_SELECTOR_PACKET_LEN];
+        bool more_fragments = frag_offset + selector.frag_len < payload_len;
+        mct_t6_selector_build(&selector, more_fragments, buf);
+
+        /* The slots are as large as the largest fragment, so the fragment is always a single transfer. */
+        pthread_mutex_lock(&stream->bulk_lock);
+        bool ok = mct_bulk_pool_write(&stream->pool, buf, sizeof(buf)) && mct_bulk_pool_end_transfer(&stream->pool);
+
+        uint32_t frag_end = frag_offset + selector.frag_len;
+        if (ok && (frag_offset < header_len)) {
+            uint32_t len = ((frag_end < header_len) ? frag_end : header_len) - frag_offset;
+            ok = mct_bulk_pool_write(&stream->pool, &header[frag_offset], len);
+        }
+        if (ok && (frag_end > header_len)) {
+            uint32_t start = (frag_offset > header_len) ? frag_offset - header_len : 0;
+            ok = mct_bulk_pool_write(&stream->pool, &data[start], frag_end - header_len - start);
+        }
+        ok = ok && mct_bulk_pool_flush(&stream->pool);
+        pthread_mutex_unlock(&stream->bulk_lock);
+        if (!ok) {
+            return false;
+        }
+
+        frag_offset = frag_end;
+    }
+
+    return true;
+}
+
+/* Sends the audio as it becomes due, keeping the adapter a first chunk ahead of real time, until it ends or the video
+ * does. */
+static void * audio_thread(void *arg) {
+    stream_t * stream = arg;
+    uint64_t start_ns = monotonic_ns();
+
+    for (;;) {
+        uint64_t elapsed_ns = monotonic_ns() - start_ns;
+        uint64_t due = AUDIO_FIRST_CHUNK_LEN + elapsed_ns * AUDIO_BYTES_PER_SECOND / 1000000000ULL;
+        if (stream->audio_bytes + AUDIO_CHUNK_LEN > due) {
+            uint64_t next_ns = (stream->audio_bytes + AUDIO_CHUNK_LEN - AUDIO_FIRST_CHUNK_LEN) * 1000000000ULL /
+                AUDIO_BYTES_PER_SECOND;
+            struct timespec ts = {
+                .tv_sec = (next_ns - elapsed_ns) / 1000000000ULL,
+                .tv_nsec = (next_ns - elapsed_ns) % 1000000000ULL,
+            };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+
+        uint64_t len = due - stream->audio_bytes;
+        if (len > sizeof(stream->audio_buf)) {
+            len = sizeof(stream->audio_buf);
+        }
+        len -= len % AUDIO_CHUNK_LEN;
+
+        size_t read_len = fread(stream->audio_buf, 1, len, stream->audio);
+        read_len -= read_len % AUDIO_FRAME_LEN;
+
+        pthread_mutex_lock(&stream->bulk_lock);
+        bool ok = !stream->audio_stop && !STOP_REQUESTED;
+        pthread_mutex_unlock(&stream->bulk_lock);
+        if (ok && (read_len > 0)) {
+            ok = send_payload(stream, MCT_T6_SESSION_AUDIO, 0, NULL, 0, stream->audio_buf, read_len);
+        }
+        if (!ok) {
+            break;
+        }
+
+        stream->audio_bytes += read_len;
+        if (read_len < len) {
+            /* The audio ended, so the video carries on without it. */
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static bool send_video(stream_t *stream, const frame_slot_t *slot) {
+    uint32_t payload_len = MCT_T6_VIDEO_HEADER_LEN + slot->jpeg_len;
+    if (payload_len > stream->ring_end - stream->ring_start) {
+        fprintf(stderr, "A %lu-byte JPEG doesn't fit in the video RAM\n", slot->jpeg_len);
+        return false;
+    }
+    if (stream->ring_pos + payload_len > stream->ring_end) {
+        stream->ring_pos = stream->ring_start;
+    }
+
+    uint32_t luma_addr = stream->framebuffer_index * stream->framebuffer_size;
+    stream->framebuffer_index = (stream->framebuffer_index + 1) % T6_FRAMEBUFFER_COUNT;
+    stream->seq++;
+
+    uint8_t header[MCT_T6_VIDEO_HEADER_LEN] = { 0 };
+    mct_set_le32(&header[0x00], T6_VIDEO_TYPE_JPEG);
+    mct_set_le32(&header[0x04], slot->jpeg_len);
+    mct_set_le32(&header[0x08], stream->seq);
+    mct_set_le32(&header[0x0C], T6_VIDEO_HEADER_WORD_0C);
+    mct_set_le16(&header[0x10], stream->stride);
+    mct_set_le16(&header[0x12], stream->stride);
+    mct_set_le32(&header[0x14], luma_addr);
+    mct_set_le32(&header[0x18], luma_addr + stream->chroma_offset);
+    mct_set_le32(&header[0x20], T6_VIDEO_HEADER_WORD_20);
+
+    uint32_t dest_addr = stream->ring_pos;
+    stream->ring_pos += payload_len;
+    if (!send_payload(stream, MCT_T6_SESSION_VIDEO, dest_addr, header, sizeof(header), slot->jpeg, slot->jpeg_len)) {
+        return false;
+    }
+
+    stream->frames_sent++;
+    stream->jpeg_bytes += slot->jpeg_len;
+    return true;
+}
+
+/* Waits for the slot to be encoded, sends it, and frees it. */
+static bool send_slot(stream_t *stream, frame_slot_t *slot) {
+    encoder_t * encoder = stream->encoder;
+
+    pthread_mutex_lock(&encoder->lock);
+    while ((slot->state == SLOT_READ) || (slot->state == SLOT_ENCODING)) {
+        pthread_cond_wait(&encoder->cond, &encoder->lock);
+    }
+    slot_state_t state = slot->state;
+    pthread_mutex_unlock(&encoder->lock);
+
+    bool ok = true;
+    if (state == SLOT_ENCODED) {
+        ok = send_video(stream, slot);
+    } else if (state == SLOT_FAILED) {
+        fprintf(stderr, "Failed to encode a frame\n");
+        ok = false;
+    }
+
+    /* Only the main thread moves a slot out of the encoded state, so this doesn't race with the workers. */
+    slot->state = SLOT_FREE;
+    return ok;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-a audio.raw|-] [-c cache_dir|-] [-d bus.address] [-j jobs] [-l] [-m index] [-n transfers] [-o output] [-q quality] <frames.raw|->\n", argv0);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -a audio.raw    Also play 48 kHz 16-bit stereo PCM audio (default: no audio).\n");
+    fprintf(stderr, "  -c cache_dir    Where to cache the adapter info and monitor EDID, or - to not cache them\n");
+    fprintf(stderr, "                  (default: $XDG_CACHE_HOME/mct-usb-display-adapter).\n");
+    fprintf(stderr, "  -d bus.address  Adapter to use (default: the first Trigger 6 adapter).\n");
+    fprintf(stderr, "  -j jobs         Number of frames to encode at once (default: %u, max: %u).\n", DEFAULT_JOBS,
+        MAX_JOBS);
+    fprintf(stderr, "  -l              List the video modes supported by the output and exit.\n");
+    fprintf(stderr, "  -m index        Video mode to set, from the list printed by -l (default: the monitor's\n");
+    fprintf(stderr, "                  preferred mode, or 0).\n");
+    fprintf(stderr, "  -n transfers    Number of bulk transfers to keep in flight (default: %u, max: %u).\n",
+        DEFAULT_SLOT_COUNT, MCT_BULK_POOL_MAX_SLOTS);
+    fprintf(stderr, "  -o output       Video output to use, 0 or 1 (default: 0).\n");
+    fprintf(stderr, "  -q quality      JPEG quality, 1-100 (default: %u).\n", DEFAULT_QUALITY);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Frames are read as raw bgr0 pixels at the resolution of the video mode.\n");
+}
+
+int main(int argc, char **argv) {
+    bool have_device = false;
+    uint32_t device_id = 0;
+    bool list_modes = false;
+    int mode_index = -1;
+    uint32_t jobs = DEFAULT_JOBS;
+    uint32_t slot_count = DEFAULT_SLOT_COUNT;
+    const char * audio_path = NULL;
+    char default_cache_dir[4096];
+    const char * cache_dir = (mct_cache_default_dir(default_cache_dir, sizeof(default_cache_dir)) > 0) ?
+        default_cache_dir : NULL;
+
+    static stream_t stream;
+    static encoder_t encoder;
+    encoder.quality = DEFAULT_QUALITY;
+
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "a:c:d:hj:lm:n:o:q:")) != -1) {
+        unsigned int bus = 0;
+        unsigned int address = 0;
+        switch (opt) {
+            case 'a':
+                audio_path = optarg;
+                break;
+            case 'c':
+                cache_dir = (strcmp(optarg, "-") == 0) ? NULL : optarg;
+                break;
+            case 'd':
+                if (sscanf(optarg, "%u.%u", &bus, &address) != 2) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                have_device = true;
+                device_id = (bus << 16) | (address & 0xFFFF);
+                break;
+            case 'j':
+                jobs = strtoul(optarg, NULL, 0);
+                if ((jobs == 0) || (jobs > MAX_JOBS)) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'l':
+                list_modes = true;
+                break;
+            case 'm':
+                mode_index = atoi(optarg);
+                if (mode_index < 0) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'n':
+                slot_count = strtoul(optarg, NULL, 0);
+                if ((slot_count == 0) || (slot_count > MCT_BULK_POOL_MAX_SLOTS)) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'o':
+                stream.output_index = atoi(optarg);
+                if (stream.output_index > 1) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'q':
+                encoder.quality = atoi(optarg);
+                if ((encoder.quality < 1) || (encoder.quality > 100)) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!list_modes && (optind != argc - 1)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    libusb_context * ctx = NULL;
+    int ret = libusb_init(&ctx);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to initialize libusb: %s\n", libusb_strerror(ret));
+        return EXIT_FAILURE;
+    }
+
+    stream.handle = open_device(ctx, have_device, device_id);
+    if (!stream.handle) {
+        fprintf(stderr, "No Trigger 6 adapter found\n");
+        libusb_exit(ctx);
+        return EXIT_FAILURE;
+    }
+
+    /* The mode table and the other adapter info only change with the firmware, so they're cached by serial number and
+     * image code version, which are the only adapter info that has to be read every time. */
+    static mct_cache_entry_t cache;
+    static mct_t6_video_mode_t modes[T6_MAX_VIDEO_MODES];
+    int mode_count = -1;
+    uint32_t hw_platform = 0;
+    uint32_t vram_size = 0;
+    bool cache_hit = false;
+    bool cache_dirty = false;
+    uint64_t bring_up_start_ns = monotonic_ns();
+    bool ok = claim_device(stream.handle);
+    if (ok) {
+        char serial[2 * MCT_T6_INFO_FIELD_SERIAL_LEN + 1];
+        get_serial(stream.handle, serial);
+        int64_t image_code_version = get_info_field(stream.handle, MCT_T6_INFO_FIELD_IMAGE_CODE_VERSION);
+        if ((serial[0] == '\0') || (image_code_version < 0)) {
+            cache_dir = NULL;
+        }
+        snprintf(cache.key, sizeof(cache.key), "t6-%s-%08" PRIx64 "-%u", serial, image_code_version,
+            stream.output_index);
+        cache_hit = cache_dir && mct_cache_load(cache_dir, cache.key, &cache) &&
+            (cache.info_len == T6_CACHE_INFO_LEN) && (mct_le32(&cache.info[4]) > 0) &&
+            (cache.modes_len >= MCT_T6_VIDEO_MODE_LEN);
+
+        if (!cache_hit) {
+            int64_t field = get_info_field(stream.handle, MCT_T6_INFO_FIELD_HW_PLATFORM);
+            vram_size = get_vram_size(stream.handle);
+            int len = read_video_modes(stream.handle, stream.output_index, cache.modes);
+            ok = (field >= 0) && (vram_size > 0) && (len >= 0);
+            if (ok) {
+                hw_platform = field;
+                mct_set_le32(&cache.info[0], hw_platform);
+                mct_set_le32(&cache.info[4], vram_size);
+                cache.info_len = T6_CACHE_INFO_LEN;
+                cache.modes_len = len;
+                cache_dirty = true;
+            }
+        }
+        hw_platform = mct_le32(&cache.info[0]);
+        vram_size = mct_le32(&cache.info[4]);
+        mode_count = parse_video_modes(cache.modes, cache.modes_len, modes);
+
+        if (ok) {
+            fprintf(stderr, "Hardware platform %u, image code version 0x%08" PRIx64 ", %u MB of video RAM%s\n",
+                hw_platform, image_code_version, vram_size >> 20, cache_hit ? " (cached)" : "");
+        }
+    }
+
+    uint32_t base_clock_mhz = mct_t6_pll_base_clock_mhz(hw_platform);
+    if (ok && list_modes) {
+        print_video_modes(modes, mode_count, base_clock_mhz, stdout);
+        if (cache_dir && cache_dirty && (mct_cache_save(cache_dir, &cache) != 0)) {
+            fprintf(stderr, "Failed to save the adapter info to %s: %s\n", cache_dir, strerror(errno));
+        }
+        libusb_release_interface(stream.handle, T6_INTERFACE);
+        libusb_close(stream.handle);
+        libusb_exit(ctx);
+        return EXIT_SUCCESS;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    ok = ok && wait_for_monitor(stream.handle, stream.output_index);
+    if (ok) {
+        if (!read_edid(stream.handle, stream.output_index, &cache)) {
+            cache_dirty = true;
+        }
+
+        mct_edid_info_t edid;
+        memset(&edid, 0, sizeof(edid));
+        if (cache.edid_len > 0) {
+            mct_edid_parse(cache.edid, cache.edid_len, &edid);
+            fprintf(stderr, "Monitor: %s %s\n", edid.manufacturer, edid.product_name);
+        }
+        if (mode_index < 0) {
+            mode_index = find_preferred_mode(&edid, modes, mode_count);
+            if (mode_index < 0) {
+                mode_index = 0;
+            }
+        }
+
+        if (cache_dir && cache_dirty && (mct_cache_save(cache_dir, &cache) != 0)) {
+            fprintf(stderr, "Failed to save the adapter info to %s: %s\n", cache_dir, strerror(errno));
+        }
+    }
+
+    if (ok && ((mode_index < 0) || (mode_index >= mode_count))) {
+        fprintf(stderr, "No video mode %d, output %u has %d:\n", mode_index, stream.output_index, mode_count);
+        print_video_modes(modes, mode_count, base_clock_mhz, stderr);
+        ok = false;
+    }
+
+    uint32_t width = ok ? modes[mode_index].line_active_pixels : 0;
+    uint32_t height = ok ? modes[mode_index].frame_active_lines : 0;
+    if (ok && !plan_vram(&stream, width, height, vram_size)) {
+        fprintf(stderr, "%ux%u framebuffers don't fit in the video RAM\n", width, height);
+        ok = false;
+    }
+
+    FILE * file = NULL;
+    if (ok) {
+        const char * path = argv[optind];
+        file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+        if (!file) {
+            perror(path);
+            ok = false;
+        }
+    }
+    if (ok && audio_path) {
+        stream.audio = (strcmp(audio_path, "-") == 0) ? stdin : fopen(audio_path, "rb");
+        if (!stream.audio) {
+            perror(audio_path);
+            ok = false;
+        }
+    }
+    FILE * audio_file = stream.audio;
+
+    encoder.width = width;
+    encoder.height = height;
+    encoder.slot_count = jobs + 2;
+    size_t frame_size = (size_t)width * height * sizeof(uint32_t);
+    for (uint32_t i = 0; ok && (i < encoder.slot_count); i++) {
+        frame_slot_t * slot = &encoder.slots[i];
+        slot->pixels = malloc(frame_size);
+        /* Enough for any JPEG of the frame, so libjpeg never has to grow it. */
+        slot->jpeg_capacity = frame_size + 65536;
+        slot->jpeg = malloc(slot->jpeg_capacity);
+        ok = slot->pixels && slot->jpeg;
+    }
+    if (ok && (mct_bulk_pool_init(&stream.pool, ctx, stream.handle, T6_BULK_OUT_ENDPOINT, slot_count,
+        T6_MAX_FRAGMENT_LEN) != 0)) {
+        ok = false;
+    }
+    if (!ok && (width > 0) && file) {
+        fprintf(stderr, "Failed to allocate the frame and transfer buffers\n");
+    }
+
+    pthread_mutex_init(&encoder.lock, NULL);
+    pthread_cond_init(&encoder.cond, NULL);
+    stream.encoder = &encoder;
+    pthread_t workers[MAX_JOBS];
+    uint32_t worker_count = 0;
+    for (; ok && (worker_count < jobs); worker_count++) {
+        if (pthread_create(&workers[worker_count], NULL, encoder_thread, &encoder) != 0) {
+            perror("pthread_create");
+            ok = false;
+            break;
+        }
+    }
+
+    ok = ok && set_video_mode(stream.handle, stream.output_index, &cache.modes[mode_index * MCT_T6_VIDEO_MODE_LEN]);
+    if (ok) {
+        fprintf(stderr, "Streaming %ux%u @ %u Hz to output %u (bring-up took %u control requests in %.1f ms)\n", width,
+            height, modes[mode_index].refresh_rate_hz, stream.output_index, CONTROL_REQUESTS,
+            (monotonic_ns() - bring_up_start_ns) / 1e6);
+    }
+
+    pthread_mutex_init(&stream.bulk_lock, NULL);
+    pthread_t audio_worker;
+    bool audio_started = false;
+    if (ok && stream.audio) {
+        ok = set_audio_state(stream.handle, true);
+        audio_started = ok;
+        if (ok && (pthread_create(&audio_worker, NULL, audio_thread, &stream) != 0)) {
+            perror("pthread_create");
+            ok = false;
+            audio_started = false;
+        }
+    }
+
+    /* Each slot is sent right before it's filled with a new frame, and unchanged frames are dropped before they're
+     * encoded by reading the next frame into the same slot. */
+    uint64_t start_ns = monotonic_ns();
+    uint32_t next_slot = 0;
+    const uint32_t * prev_pixels = NULL;
+    while (ok && !STOP_REQUESTED) {
+        frame_slot_t * slot = &encoder.slots[next_slot];
+        if (slot->state != SLOT_FREE) {
+            ok = send_slot(&stream, slot);
+            if (!ok) {
+                break;
+            }
+        }
+
+        if (fread(slot->pixels, 1, frame_size, file) != frame_size) {
+            break;
+        }
+        stream.frames_read++;
+
+        mct_fb_rect_t rect;
+        if (prev_pixels && !mct_fb_dirty_rect(prev_pixels, slot->pixels, width, height, &rect)) {
+            stream.frames_unchanged++;
+            continue;
+        }
+
+        pthread_mutex_lock(&encoder.lock);
+        slot->state = SLOT_READ;
+        pthread_cond_broadcast(&encoder.cond);
+        pthread_mutex_unlock(&encoder.lock);
+
+        prev_pixels = slot->pixels;
+        next_slot = (next_slot + 1) % encoder.slot_count;
+    }
+
+    /* Send the frames that are still being encoded, in order. */
+    for (uint32_t i = 0; ok && (i < encoder.slot_count); i++) {
+        frame_slot_t * slot = &encoder.slots[(next_slot + i) % encoder.slot_count];
+        if (slot->state != SLOT_FREE) {
+            ok = send_slot(&stream, slot);
+        }
+    }
+
+    pthread_mutex_lock(&encoder.lock);
+    encoder.closed = true;
+    pthread_cond_broadcast(&encoder.cond);
+    pthread_mutex_unlock(&encoder.lock);
+    for (uint32_t i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    if (audio_started) {
+        pthread_mutex_lock(&stream.bulk_lock);
+        stream.audio_stop = true;
+        pthread_mutex_unlock(&stream.bulk_lock);
+        pthread_join(audio_worker, NULL);
+    }
+
+    if (stream.pool.slot_count > 0) {
+        if (!mct_bulk_pool_drain(&stream.pool)) {
+            fprintf(stderr, "Bulk transfer failed: %s\n", mct_bulk_pool_status_name(stream.pool.failed_status));
+            ok = false;
+        }
+
+        double elapsed_s = (monotonic_ns() - start_ns) / 1e9;
+        fprintf(stderr, "%" PRIu64 " frames read, %" PRIu64 " unchanged, %" PRIu64 " sent (%.1f kB per JPEG), %"
+            PRIu64 " audio bytes, %" PRIu64 " bytes in %" PRIu64 " transfers, %.1f Mbps\n", stream.frames_read,
+            stream.frames_unchanged, stream.frames_sent,
+            stream.frames_sent ? stream.jpeg_bytes / 1e3 / stream.frames_sent : 0.0, stream.audio_bytes,
+            stream.pool.bytes, stream.pool.transfers, elapsed_s > 0 ? stream.pool.bytes * 8 / elapsed_s / 1e6 : 0.0);
+    }
+
+    if (audio_started) {
+        set_audio_state(stream.handle, false);
+    }
+    if (width > 0) {
+        control_out(stream.handle, MCT_T6_CONTROL_REQ_SET_VIDEO_OUTPUT_STATE, stream.output_index, 0, NULL, 0);
+    }
+
+    mct_bulk_pool_free(&stream.pool);
+    for (uint32_t i = 0; i < encoder.slot_count; i++) {
+        free(encoder.slots[i].pixels);
+        free(encoder.slots[i].jpeg);
+    }
+    pthread_mutex_destroy(&encoder.lock);
+    pthread_mutex_destroy(&stream.bulk_lock);
+    pthread_cond_destroy(&encoder.cond);
+    if (file && (file != stdin)) {
+        fclose(file);
+    }
+    if (audio_file && (audio_file != stdin)) {
+        fclose(audio_file);
+    }
+    libusb_release_interface(stream.handle, T6_INTERFACE);
+    libusb_close(stream.handle);
+    libusb_exit(ctx);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
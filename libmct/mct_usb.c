@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_usb.c - USB capture pseudo-header decoding for libmct.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mct_le.h"
+#include "mct_usb.h"
+
+
+#define USBMON_HEADER_LEN 48
+#define USBMON_MMAPPED_HEADER_LEN 64
+
+#define USBPCAP_HEADER_LEN 27
+#define USBPCAP_CONTROL_HEADER_LEN 28
+#define USBPCAP_INFO_PDO_TO_FDO 0x01
+#define USBPCAP_CONTROL_STAGE_SETUP 0
+
+/* The usbmon header is in host byte order, which is little-endian on every machine we care about. */
+static bool decode_usbmon(const uint8_t *buf, uint32_t caplen, uint32_t header_len, mct_usb_urb_t *urb) {
+    if (caplen < header_len) {
+        return false;
+    }
+
+    urb->urb_id = mct_le64(&buf[0]);
+    urb->is_submit = buf[8] == 'S';
+    urb->transfer_type = buf[9];
+    urb->endpoint = buf[10] & 0x7F;
+    urb->direction_in = (buf[10] & 0x80) != 0;
+    urb->device_address = buf[11];
+    urb->bus_id = mct_le16(&buf[12]);
+    urb->has_setup = buf[14] == 0;
+    memcpy(urb->setup, &buf[40], sizeof(urb->setup));
+    urb->data = &buf[header_len];
+    urb->data_len = caplen - header_len;
+    urb->reported_len = mct_le32(&buf[32]);
+
+    if (urb->reported_len < urb->data_len) {
+        urb->reported_len = urb->data_len;
+    }
+
+    return true;
+}
+
+static bool decode_usbpcap(const uint8_t *buf, uint32_t caplen, uint32_t origlen, mct_usb_urb_t *urb) {
+    if (caplen < USBPCAP_HEADER_LEN) {
+        return false;
+    }
+
+    uint16_t header_len = mct_le16(&buf[0]);
+    if ((header_len < USBPCAP_HEADER_LEN) || (header_len > caplen)) {
+        return false;
+    }
+
+    urb->urb_id = mct_le64(&buf[2]);
+    urb->is_submit = (buf[16] & USBPCAP_INFO_PDO_TO_FDO) == 0;
+    urb->bus_id = mct_le16(&buf[17]);
+    urb->device_address = mct_le16(&buf[19]);
+    urb->endpoint = buf[21] & 0x7F;
+    urb->direction_in = (buf[21] & 0x80) != 0;
+    urb->transfer_type = buf[22];
+    urb->has_setup = false;
+    urb->data = &buf[header_len];
+    urb->data_len = caplen - header_len;
+    urb->reported_len = (origlen > header_len) ? origlen - header_len : 0;
+
+    if ((urb->transfer_type == MCT_USB_TRANSFER_CONTROL) && (header_len >= USBPCAP_CONTROL_HEADER_LEN) &&
+        (buf[27] == USBPCAP_CONTROL_STAGE_SETUP) && (urb->data_len >= sizeof(urb->setup))) {
+        /* The setup packet is sent as the data of the setup stage. */
+        urb->has_setup = true;
+        memcpy(urb->setup, urb->data, sizeof(urb->setup));
+        urb->data += sizeof(urb->setup);
+        urb->data_len -= sizeof(urb->setup);
+        urb->reported_len -= sizeof(urb->setup);
+    }
+
+    if (urb->reported_len < urb->data_len) {
+        urb->reported_len = urb->data_len;
+    }
+
+    return true;
+}
+
+/* Decodes the capture pseudo-header of a USB packet, returning false for other link types or truncated headers. */
+bool mct_usb_urb_decode(uint16_t linktype, const uint8_t *buf, uint32_t caplen, uint32_t origlen, mct_usb_urb_t *urb) {
+    memset(urb, 0, sizeof(*urb));
+
+    switch (linktype) {
+        case MCT_LINKTYPE_USB_LINUX:
+            return decode_usbmon(buf, caplen, USBMON_HEADER_LEN, urb);
+        case MCT_LINKTYPE_USB_LINUX_MMAPPED:
+            return decode_usbmon(buf, caplen, USBMON_MMAPPED_HEADER_LEN, urb);
+        case MCT_LINKTYPE_USBPCAP:
+            return decode_usbpcap(buf, caplen, origlen, urb);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_usb.h - USB capture pseudo-header decoding for libmct.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_USB_H_INCLUDED
+#define MCT_USB_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MCT_LINKTYPE_USB_LINUX 189
+#define MCT_LINKTYPE_USB_LINUX_MMAPPED 220
+#define MCT_LINKTYPE_USBPCAP 249
+
+/* Both usbmon and USBPcap use the same transfer type numbering. */
+#define MCT_USB_TRANSFER_ISOCHRONOUS 0
+#define MCT_USB_TRANSFER_INTERRUPT 1
+#define MCT_USB_TRANSFER_CONTROL 2
+#define MCT_USB_TRANSFER_BULK 3
+
+typedef struct mct_usb_urb_s {
+    uint64_t urb_id;
+    uint16_t bus_id;
+    uint16_t device_address;
+    uint8_t endpoint;
+    bool direction_in;
+    uint8_t transfer_type;
+    /* True for the host-to-device half of the URB (usbmon 'S', or USBPcap's FDO -> PDO). */
+    bool is_submit;
+    bool has_setup;
+    uint8_t setup[8];
+    const uint8_t * data;
+    uint32_t data_len;
+    /* The length of the data before it was truncated by the capture. */
+    uint32_t reported_len;
+} mct_usb_urb_t;
+
+bool mct_usb_urb_decode(uint16_t linktype, const uint8_t *buf, uint32_t caplen, uint32_t origlen, mct_usb_urb_t *urb);
+
+static inline uint32_t mct_usb_device_id(const mct_usb_urb_t *urb) {
+    return ((uint32_t)urb->bus_id << 16) | urb->device_address;
+}
+
+#endif // MCT_USB_H_INCLUDED
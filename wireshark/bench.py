@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: 0BSD
+
+# Copyright (C) 2023 by Forest Crossman <cyrozap@gmail.com>
+#
+# Permission to use, copy, modify, and/or distribute this software for
+# any purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+# WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+# AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+# DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+# PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+# TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+# PERFORMANCE OF THIS SOFTWARE.
+
+
+import argparse
+import contextlib
+import filecmp
+import gzip
+import itertools
+import json
+import os
+import re
+import resource
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+
+NO_REASSEMBLY_PREFS = ["-o", "trigger5.truncated_capture:TRUE", "-o", "trigger6.truncated_capture:TRUE"]
+
+MODES = (
+    ("first pass", []),
+    ("two-pass", ["-2"]),
+    ("no reassembly", NO_REASSEMBLY_PREFS),
+    ("filter", ["-Y", "trigger5 || trigger6"]),
+)
+
+# Everything the plugin adds to the packet details, with two passes so the fields that link to later packets are there
+# too.
+COMPARE_ARGS = ["-2", "-T", "json", "-J", "trigger5 trigger6 mct_edid"]
+
+
+def open_capture(path):
+    if path.endswith(".gz"):
+        return gzip.open(path, "rb")
+    return open(path, "rb")
+
+def count_packets(path):
+    """Returns the number of packets and the uncompressed size of a pcapng file."""
+    packets = 0
+    size = 0
+    endian = "<"
+    with open_capture(path) as f:
+        while True:
+            header = f.read(8)
+            if len(header) < 8:
+                break
+            block_type = struct.unpack_from("<I", header, 0)[0]
+            if block_type == 0x0A0D0D0A:
+                magic = f.read(4)
+                endian = "<" if magic == b"\x4d\x3c\x2b\x1a" else ">"
+                block_len = struct.unpack_from(endian + "I", header, 4)[0]
+                f.seek(block_len - 12, os.SEEK_CUR)
+            else:
+                block_len = struct.unpack_from(endian + "I", header, 4)[0]
+                f.seek(block_len - 8, os.SEEK_CUR)
+                if block_type in (3, 6):
+                    packets += 1
+            size += block_len
+    return packets, size
+
+def tshark_plugins_version(tshark):
+    """Returns the "X.Y" plugin directory version of tshark, e.g. "4.0"."""
+    output = subprocess.run([tshark, "--version"], check=True, stdout=subprocess.PIPE).stdout.decode(errors="replace")
+    match = re.search(r"(\d+)\.(\d+)\.\d+", output)
+    if not match:
+        raise RuntimeError("Couldn't find the version of {}".format(tshark))
+    return "{}.{}".format(match.group(1), match.group(2))
+
+@contextlib.contextmanager
+def tshark_env(tshark, plugin):
+    """An environment for tshark with only the given plugin in its plugin directory and an empty home and
+    configuration directory, so neither an installed version of the plugin nor personal plugins and preferences are
+    loaded instead."""
+    with tempfile.TemporaryDirectory() as path:
+        epan_dir = os.path.join(path, "plugins", tshark_plugins_version(tshark), "epan")
+        os.makedirs(epan_dir)
+        os.symlink(os.path.abspath(plugin), os.path.join(epan_dir, os.path.basename(plugin)))
+        os.makedirs(os.path.join(path, "home"))
+        os.makedirs(os.path.join(path, "config"))
+
+        env = dict(os.environ)
+        env["WIRESHARK_PLUGIN_DIR"] = os.path.join(path, "plugins")
+        env["HOME"] = os.path.join(path, "home")
+        env["XDG_CONFIG_HOME"] = os.path.join(path, "config")
+
+        # A plugin that fails to load is only a warning, which would make every mode look very fast.
+        protocols = subprocess.run([tshark, "-G", "protocols"], check=True, stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE, env=env).stdout.decode(errors="replace")
+        if not any(line.split("\t")[2:3] == ["trigger6"] for line in protocols.splitlines()):
+            raise RuntimeError("{} didn't load {}".format(tshark, plugin))
+
+        yield env
+
+def cpu_seconds(rusage):
+    return rusage.ru_utime + rusage.ru_stime
+
+def run_tshark(tshark, env, path, args, stdout=subprocess.DEVNULL):
+    """Runs tshark over the capture, returning its CPU time (user and system), wall-clock time, and peak RSS in kB.
+
+    The CPU time is what's compared against the budget, since it doesn't depend on what else the machine is doing
+    nearly as much as the wall-clock time does."""
+    cmd = [tshark, "-n", "-r", path] + args
+    cpu_start = cpu_seconds(resource.getrusage(resource.RUSAGE_CHILDREN))
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdout=stdout, stderr=subprocess.PIPE, env=env)
+    stderr = proc.stderr.read()
+    _, status, rusage = os.wait4(proc.pid, 0)
+    elapsed = time.monotonic() - start
+    cpu = cpu_seconds(resource.getrusage(resource.RUSAGE_CHILDREN)) - cpu_start
+
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise RuntimeError("{} failed: {}".format(" ".join(cmd), stderr.decode(errors="replace").strip()))
+
+    # ru_maxrss is in kB on Linux. It's taken from this child alone, since RUSAGE_CHILDREN only has the largest of all
+    # of them.
+    return {"cpu_seconds": cpu, "wall_seconds": elapsed, "peak_rss_kb": rusage.ru_maxrss}
+
+def first_difference(path_a, path_b):
+    """Returns the number of the first line that differs between the two files, which may be gzipped."""
+    with open_capture(path_a) as a, open_capture(path_b) as b:
+        for line_num, (line_a, line_b) in enumerate(itertools.zip_longest(a, b), start=1):
+            if line_a != line_b:
+                return line_num
+    return None
+
+def compare_output(tshark, envs, path):
+    """Dissects the capture with both plugins, returning None if the packet details match, or the first line that
+    doesn't."""
+    with tempfile.TemporaryDirectory() as out_dir:
+        outputs = []
+        for name, env in zip(("new", "reference"), envs):
+            out_path = os.path.join(out_dir, name + ".json")
+            with open(out_path, "wb") as out:
+                run_tshark(tshark, env, path, COMPARE_ARGS, stdout=out)
+            outputs.append(out_path)
+
+        if filecmp.cmp(outputs[0], outputs[1], shallow=False):
+            return None
+        return first_difference(outputs[0], outputs[1])
+
+def check_budget(result, baseline, time_budget, memory_budget):
+    """Returns the ways the result is worse than the baseline by more than the budgets, which are in percent."""
+    regressions = []
+    if "cpu_seconds" not in baseline:
+        return ["the baseline has no CPU time, record it again"]
+    if result["cpu_seconds"] > baseline["cpu_seconds"] * (1 + time_budget / 100):
+        regressions.append("CPU time {:+.1f}%".format((result["cpu_seconds"] / baseline["cpu_seconds"] - 1) * 100))
+    if result["peak_rss_kb"] > baseline["peak_rss_kb"] * (1 + memory_budget / 100):
+        regressions.append("peak RSS {:+.1f}%".format((result["peak_rss_kb"] / baseline["peak_rss_kb"] - 1) * 100))
+    return regressions
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure how fast tshark dissects captures with the plugin.")
+    parser.add_argument("-p", "--plugin", type=str, default="mct_trigger.so", help="The plugin to load. Default: %(default)s")
+    parser.add_argument("-t", "--tshark", type=str, default="tshark", help="The tshark binary to run. Default: %(default)s")
+    parser.add_argument("-r", "--runs", type=int, default=5, help="Number of runs per mode, the fastest of which is reported. Default: %(default)s")
+    parser.add_argument("-b", "--baseline", type=str, help="Fail if the results are worse than the ones in this file by more than the budgets.")
+    parser.add_argument("-w", "--write-baseline", type=str, help="Save the results to this file, to use as a baseline later.")
+    parser.add_argument("--time-budget", type=float, default=10, help="How much more CPU time than the baseline each mode can use, in percent. Default: %(default)s")
+    parser.add_argument("--memory-budget", type=float, default=10, help="How much more memory than the baseline each mode can use, in percent. Default: %(default)s")
+    parser.add_argument("-c", "--compare", type=str, help="Fail if the packet details of any capture differ from those of this plugin (e.g., a build from before a change).")
+    parser.add_argument("captures", type=str, nargs="+", help="The capture files to dissect.")
+    args = parser.parse_args()
+    if args.runs < 1:
+        parser.error("at least one run is needed")
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    results = {}
+    failures = []
+    with contextlib.ExitStack() as stack:
+        new_env = stack.enter_context(tshark_env(args.tshark, args.plugin))
+        reference_env = stack.enter_context(tshark_env(args.tshark, args.compare)) if args.compare else None
+
+        print("{:<40} {:<14} {:>10} {:>12} {:>10} {:>10} {:>12}".format("Capture", "Mode", "Packets", "Packets/s", "MB/s", "Wall (s)", "Peak RSS (MB)"))
+        for path in args.captures:
+            capture = os.path.basename(path)
+            packets, size = count_packets(path)
+            for name, mode_args in MODES:
+                result = min((run_tshark(args.tshark, new_env, path, mode_args) for _ in range(args.runs)),
+                    key=lambda run: run["cpu_seconds"])
+                results.setdefault(capture, {})[name] = result
+
+                regressions = []
+                if name in baseline.get(capture, {}):
+                    regressions = check_budget(result, baseline[capture][name], args.time_budget, args.memory_budget)
+                    failures.extend("{} ({}): {}".format(capture, name, regression) for regression in regressions)
+
+                cpu = max(result["cpu_seconds"], 1e-6)
+                print("{:<40} {:<14} {:>10} {:>12.0f} {:>10.1f} {:>10.2f} {:>12.1f}{}".format(
+                    capture[:40], name, packets, packets / cpu, size / cpu / 1e6, result["wall_seconds"],
+                    result["peak_rss_kb"] / 1024,
+                    "  over budget: " + ", ".join(regressions) if regressions else ""))
+                sys.stdout.flush()
+
+            if reference_env:
+                line_num = compare_output(args.tshark, (new_env, reference_env), path)
+                if line_num is not None:
+                    failures.append("{}: packet details differ from the reference plugin's, starting at line {} of the JSON output".format(capture, line_num))
+
+    if args.write_baseline:
+        with open(args.write_baseline, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+
+    if args.baseline and not any(capture in baseline for capture in results):
+        failures.append("none of the captures are in the baseline")
+
+    for failure in failures:
+        print("FAIL: " + failure, file=sys.stderr)
+    if failures:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: 0BSD
+
+# Copyright (C) 2023 by Forest Crossman <cyrozap@gmail.com>
+#
+# Permission to use, copy, modify, and/or distribute this software for
+# any purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+# WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+# AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+# DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+# PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+# TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+# PERFORMANCE OF THIS SOFTWARE.
+
+
+import argparse
+import gzip
+import random
+import struct
+import sys
+
+
+LINKTYPE_USB_LINUX_MMAPPED = 220
+
+MCT_USB_VID = 0x0711
+T5_USB_PID = 0x5800
+T6_USB_PID = 0x5600
+
+BUS_ID = 1
+DEVICE_ADDRESS = 2
+
+URB_SUBMIT = ord("S")
+URB_COMPLETE = ord("C")
+URB_CONTROL = 2
+URB_BULK = 3
+
+# -EINPROGRESS, as reported by usbmon for every submission.
+STATUS_IN_PROGRESS = -115
+
+# The 64-byte usbmon mmapped header, with the setup packet in place of the isochronous counters.
+USBMON_HEADER = struct.Struct("<QBBBBHBBqiiII8siiII")
+
+EPB_HEADER = struct.Struct("<IIIIIII")
+
+T5_BULK_ENDPOINT = 0x01
+T5_BULK_HEADER = struct.Struct("<BBHHHHHIBBBB")
+T5_FRAME_FLAG_COMPRESSED = 0x1
+
+T6_BULK_ENDPOINT = 0x02
+T6_SELECTOR = struct.Struct("<IIIIIIII")
+T6_VIDEO_HEADER = struct.Struct("<IIIIHH28x")
+T6_SESSION_VIDEO = 0
+T6_SESSION_AUDIO = 3
+T6_DEST_ADDR_JPEG = 0x03000000
+T6_DEST_ADDR_AUDIO = 0x00000000
+
+# 10 ms of 48 kHz stereo 16-bit PCM.
+T6_AUDIO_CHUNK_LEN = 1920
+
+T5_CTRL_REQ_GET_VIDEO_MODES = 0xA4
+T5_CTRL_REQ_GET_EDID_BLOCK = 0xA8
+T5_CTRL_REQ_SET_VIDEO_MODE = 0xC3
+T5_VIDEO_MODES_LEN = 420
+T5_VIDEO_MODE = struct.Struct("<BBBBHH")
+
+T6_CONTROL_REQ_UPLOAD_CURSOR = 0x10
+T6_CONTROL_REQ_SET_VIDEO_MODE = 0x12
+T6_CONTROL_REQ_GET_EDID_BLOCK = 0x80
+T6_CONTROL_REQ_GET_VIDEO_MODES = 0x89
+T6_VIDEO_MODE = struct.Struct("<IHHHHHHHHH6sBBBB")
+T6_CURSOR_HEADER = struct.Struct("<HHHH")
+T6_CURSOR_SIZE = 64
+# The driver uploads cursors in chunks of at most this many bytes.
+T6_CURSOR_CHUNK_LEN = 4096
+
+
+def t5_bulk_header_checksum(data):
+    return (-sum(data)) & 0xFF
+
+def make_filler(size, seed):
+    """Returns pseudorandom bytes to use as payload data.
+
+    0xfb is replaced so that no fragment can be mistaken for the start of a T5 bulk header, which keeps the expected
+    frame counts of a generated capture exact.
+    """
+    rng = random.Random(seed)
+    table = bytes(range(256)).replace(b"\xfb", b"\xfa")
+    return rng.randbytes(size).translate(table)
+
+
+class PcapngWriter:
+    def __init__(self, f, snaplen):
+        self.f = f
+        self.snaplen = snaplen
+        self.urb_id = 0xffff000000000000
+        self.ts_us = 0
+        self.packets = 0
+
+        # Section Header Block with an unspecified section length.
+        self.f.write(struct.pack("<IIIHHqI", 0x0A0D0D0A, 28, 0x1A2B3C4D, 1, 0, -1, 28))
+        # Interface Description Block with the default microsecond timestamp resolution.
+        self.f.write(struct.pack("<IIHHII", 1, 20, LINKTYPE_USB_LINUX_MMAPPED, 0, snaplen, 20))
+
+    def write_packet(self, ts_us, header, data):
+        origlen = len(header) + len(data)
+        caplen = min(origlen, self.snaplen)
+        padding = -caplen & 3
+        block_len = EPB_HEADER.size + caplen + padding + 4
+
+        self.f.write(EPB_HEADER.pack(6, block_len, 0, ts_us >> 32, ts_us & 0xFFFFFFFF, caplen, origlen))
+        if caplen == origlen:
+            self.f.write(header)
+            self.f.write(data)
+        else:
+            self.f.write((header + data)[:caplen])
+        self.f.write(b"\0" * padding + struct.pack("<I", block_len))
+        self.packets += 1
+
+    def write_urb(self, ts_us, is_submit, transfer_type, endpoint, status, urb_len, setup, data):
+        header = USBMON_HEADER.pack(
+            self.urb_id,
+            URB_SUBMIT if is_submit else URB_COMPLETE,
+            transfer_type,
+            endpoint,
+            DEVICE_ADDRESS,
+            BUS_ID,
+            0 if setup else ord("-"),
+            0 if data else (ord("<") if is_submit else ord(">")),
+            ts_us // 1000000,
+            ts_us % 1000000,
+            status,
+            urb_len,
+            len(data),
+            setup or bytes(8),
+            0,
+            0,
+            0x200 if (endpoint & 0x80) else 0,
+            0,
+        )
+        self.write_packet(ts_us, header, data)
+
+    def advance(self, ts_us):
+        """Moves the clock forward to ts_us, unless the previous transfers already took longer than that."""
+        self.ts_us = max(self.ts_us, ts_us)
+
+    def control_in(self, setup, data):
+        self.urb_id += 0x40
+        w_length = struct.unpack_from("<H", setup, 6)[0]
+        self.write_urb(self.ts_us, True, URB_CONTROL, 0x80, STATUS_IN_PROGRESS, w_length, setup, b"")
+        self.write_urb(self.ts_us + 100, False, URB_CONTROL, 0x80, 0, len(data), None, data)
+        self.ts_us += 200
+
+    def control_out(self, setup, data):
+        self.urb_id += 0x40
+        self.write_urb(self.ts_us, True, URB_CONTROL, 0x00, STATUS_IN_PROGRESS, len(data), setup, data)
+        self.write_urb(self.ts_us + 100, False, URB_CONTROL, 0x00, 0, len(data), None, b"")
+        self.ts_us += 200
+
+    def bulk_out(self, endpoint, data):
+        self.urb_id += 0x40
+        self.write_urb(self.ts_us, True, URB_BULK, endpoint, STATUS_IN_PROGRESS, len(data), None, data)
+        self.write_urb(self.ts_us + 1, False, URB_BULK, endpoint, 0, len(data), None, b"")
+        self.ts_us += 2
+
+
+def write_descriptors(writer, pid, bulk_endpoint):
+    """Enumerates the adapter, so the USB dissector can match the protocol dissectors by VID:PID."""
+    device_descriptor = struct.pack("<BBHBBBBHHHBBBB", 18, 1, 0x0200, 0, 0, 0, 64, MCT_USB_VID, pid, 0x0100, 1, 2, 3, 1)
+    writer.control_in(struct.pack("<BBHHH", 0x80, 6, 0x0100, 0, len(device_descriptor)), device_descriptor)
+
+    config_descriptor = b"".join((
+        struct.pack("<BBHBBBBB", 9, 2, 9 + 9 + 7, 1, 1, 0, 0x80, 250),
+        struct.pack("<BBBBBBBBB", 9, 4, 0, 0, 1, 0xff, 0, 0, 0),
+        struct.pack("<BBBBHB", 7, 5, bulk_endpoint, 2, 512, 0),
+    ))
+    writer.control_in(struct.pack("<BBHHH", 0x80, 6, 0x0200, 0, len(config_descriptor)), config_descriptor)
+
+def make_edid():
+    """A minimal EDID base block for a 1920x1080 monitor, with only the fields the dissectors look at filled in."""
+    edid = bytearray(128)
+    edid[0:8] = b"\x00\xff\xff\xff\xff\xff\xff\x00"
+    # Manufacturer "MCT", product code 1, EDID 1.4.
+    edid[8:12] = struct.pack(">HH", (ord("M") - 64) << 10 | (ord("C") - 64) << 5 | (ord("T") - 64), 0x0100)
+    edid[18:20] = b"\x01\x04"
+    # Preferred timing: 1920x1080 @ 60 Hz (148.5 MHz, 2200x1125).
+    edid[54:72] = bytes.fromhex("023a801871382d40582c4500c48e2100001e")
+    edid[127] = -sum(edid[:127]) & 0xFF
+    return bytes(edid)
+
+def write_t5_control(writer):
+    """Reads the mode table and the EDID and sets the first mode, like the driver does when a monitor is connected."""
+    modes = [T5_VIDEO_MODE.pack(60, 148, 32, 0, 1080, 1920), T5_VIDEO_MODE.pack(60, 74, 32, 1, 720, 1280)]
+    modes_data = struct.pack(">H2x", len(modes)) + b"".join(modes)
+    modes_data += bytes(T5_VIDEO_MODES_LEN - len(modes_data))
+    writer.control_in(struct.pack("<BBHHH", 0xC0, T5_CTRL_REQ_GET_VIDEO_MODES, 0, 0, T5_VIDEO_MODES_LEN), modes_data)
+    writer.control_in(struct.pack("<BBHHH", 0xC0, T5_CTRL_REQ_GET_EDID_BLOCK, 0, 0, 128), make_edid())
+    writer.control_out(struct.pack("<BBHHH", 0x40, T5_CTRL_REQ_SET_VIDEO_MODE, 0, 0, 0), b"")
+
+def write_t6_control(writer):
+    """Reads the EDID and mode table of output 0, sets its first mode, and uploads a cursor in several chunks."""
+    writer.control_in(struct.pack("<BBHHH", 0xC0, T6_CONTROL_REQ_GET_EDID_BLOCK, 0, 0, 128), make_edid())
+
+    mode = T6_VIDEO_MODE.pack(148500, 60, 2200, 1920, 2008, 44, 1125, 1080, 1084, 5, bytes(6), 1, 1, 0, 0)
+    writer.control_in(struct.pack("<BBHHH", 0xC0, T6_CONTROL_REQ_GET_VIDEO_MODES, 0, 0, 512), mode)
+    writer.control_out(struct.pack("<BBHHH", 0x40, T6_CONTROL_REQ_SET_VIDEO_MODE, 0, 0, len(mode)), mode)
+
+    pitch = T6_CURSOR_SIZE * 4
+    cursor = T6_CURSOR_HEADER.pack(1, T6_CURSOR_SIZE, T6_CURSOR_SIZE, pitch) + make_filler(T6_CURSOR_SIZE * pitch, 1)
+    for offset, chunk in fragments(cursor, T6_CURSOR_CHUNK_LEN):
+        writer.control_out(struct.pack("<BBHHH", 0x40, T6_CONTROL_REQ_UPLOAD_CURSOR, 0, offset, len(chunk)), chunk)
+
+def fragments(payload, fragment_size):
+    for offset in range(0, len(payload), fragment_size):
+        yield offset, payload[offset:offset+fragment_size]
+
+def write_t5(writer, args, filler):
+    write_descriptors(writer, T5_USB_PID, T5_BULK_ENDPOINT)
+    if args.control:
+        write_t5_control(writer)
+
+    compressed = not args.uncompressed
+    payload_len = args.payload_size
+    if payload_len is None:
+        # Uncompressed frames are 24 bits per pixel.
+        payload_len = args.width * args.height * 3
+        if compressed:
+            payload_len //= args.compression_ratio
+    payload = memoryview(filler)[:payload_len]
+
+    frame_flags = T5_FRAME_FLAG_COMPRESSED if compressed else 0
+    for frame in range(args.frames):
+        writer.advance(1000 + frame * 1000000 // args.fps)
+        header = bytearray(T5_BULK_HEADER.pack(0xfb, T5_BULK_HEADER.size, (frame_flags << 12) | (frame & 0x0FFF),
+            0, 0, args.width, args.height, payload_len, 0x01, 0, 0, 0))
+        header[-1] = t5_bulk_header_checksum(header[:-1])
+        packet = bytes(header) + payload
+
+        for _, fragment in fragments(packet, args.fragment_size):
+            writer.bulk_out(T5_BULK_ENDPOINT, fragment)
+
+def write_t6_session(writer, session_num, dest_addr, payload, fragment_size):
+    """Sends a session payload as select session packets, each followed by the fragment it announces."""
+    for offset, fragment in fragments(payload, fragment_size):
+        writer.bulk_out(T6_BULK_ENDPOINT, T6_SELECTOR.pack(session_num, len(payload), dest_addr, len(fragment), offset,
+            0, 0, 0))
+        writer.bulk_out(T6_BULK_ENDPOINT, fragment)
+
+def write_t6(writer, args, filler):
+    write_descriptors(writer, T6_USB_PID, T6_BULK_ENDPOINT)
+    if args.control:
+        write_t6_control(writer)
+
+    jpeg_len = args.payload_size
+    if jpeg_len is None:
+        jpeg_len = args.width * args.height * 3 // args.compression_ratio
+    jpeg_len = max(jpeg_len, 4)
+    # Only the SOI and EOI markers are real; nothing checks what's between them.
+    jpeg = b"\xff\xd8" + memoryview(filler)[:jpeg_len-4] + b"\xff\xd9"
+
+    audio = memoryview(filler)[:T6_AUDIO_CHUNK_LEN]
+    audio_us = 0
+    for frame in range(args.frames):
+        writer.advance(1000 + frame * 1000000 // args.fps)
+        video = T6_VIDEO_HEADER.pack(7, len(jpeg), frame + 1, 6, args.width, args.height) + jpeg
+        write_t6_session(writer, T6_SESSION_VIDEO, T6_DEST_ADDR_JPEG, video, args.fragment_size)
+
+        if args.audio:
+            next_frame_us = (frame + 1) * 1000000 // args.fps
+            while audio_us < next_frame_us:
+                write_t6_session(writer, T6_SESSION_AUDIO, T6_DEST_ADDR_AUDIO, audio,
+                    args.fragment_size)
+                audio_us += 10000
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a synthetic Trigger 5 or Trigger 6 usbmon capture.")
+    parser.add_argument("protocol", choices=("t5", "t6"), help="The protocol of the generated adapter.")
+    parser.add_argument("-o", "--output", type=str, required=True, help="The pcapng file to write, or \"-\" for stdout. Names ending in \".gz\" are gzip'd.")
+    parser.add_argument("-n", "--frames", type=int, default=100, help="Number of video frames. Default: %(default)s")
+    parser.add_argument("-W", "--width", type=int, default=1920, help="Frame width in pixels. Default: %(default)s")
+    parser.add_argument("-H", "--height", type=int, default=1080, help="Frame height in pixels. Default: %(default)s")
+    parser.add_argument("-f", "--fragment-size", type=int, default=16384, help="Maximum bytes per bulk transfer. Default: %(default)s")
+    parser.add_argument("-p", "--payload-size", type=int, help="Bytes of image data per frame. Default: derived from the resolution and compression ratio")
+    parser.add_argument("-c", "--compression-ratio", type=int, default=10, help="Size of a 24-bit frame divided by the size of a compressed one. Default: %(default)s")
+    parser.add_argument("-u", "--uncompressed", action="store_true", help="Send uncompressed T5 frames.")
+    parser.add_argument("-a", "--audio", action="store_true", help="Also send 10 ms T6 audio chunks in between the video frames.")
+    parser.add_argument("-C", "--control", action="store_true", help="Also read the EDID and mode table and set a video mode before the video, and upload a T6 cursor.")
+    parser.add_argument("-r", "--fps", type=int, default=60, help="Frames per second, for the timestamps. Default: %(default)s")
+    parser.add_argument("-s", "--snaplen", type=int, default=262144, help="Truncate each packet to this many bytes, like dumpcap -s. Default: %(default)s")
+    parser.add_argument("--seed", type=int, default=0, help="Seed for the payload data. Default: %(default)s")
+    args = parser.parse_args()
+
+    if args.fragment_size < 1 or args.compression_ratio < 1 or args.fps < 1 or args.snaplen < USBMON_HEADER.size:
+        parser.error("the fragment size, compression ratio, and FPS must be positive, and the snaplen must fit the usbmon header")
+    if args.protocol == "t5" and args.payload_size is not None and args.payload_size > 0x0FFFFFFF:
+        parser.error("T5 payloads are limited to 28 bits of length")
+
+    filler_len = max(args.payload_size or 0, args.width * args.height * 3, T6_AUDIO_CHUNK_LEN)
+    filler = make_filler(filler_len, args.seed)
+
+    if args.output == "-":
+        f = sys.stdout.buffer
+    elif args.output.endswith(".gz"):
+        # The lowest compression level, since the captures are mostly random bytes anyway.
+        f = gzip.open(args.output, "wb", compresslevel=1)
+    else:
+        f = open(args.output, "wb", buffering=1024*1024)
+
+    writer = PcapngWriter(f, args.snaplen)
+    if args.protocol == "t5":
+        write_t5(writer, args, filler)
+    else:
+        write_t6(writer, args, filler)
+
+    if f is not sys.stdout.buffer:
+        f.close()
+
+    print("Wrote {} packets ({} URBs)".format(writer.packets, writer.packets // 2), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
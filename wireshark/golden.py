@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: 0BSD
+
+# Copyright (C) 2023 by Forest Crossman <cyrozap@gmail.com>
+#
+# Permission to use, copy, modify, and/or distribute this software for
+# any purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+# WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+# AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+# DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+# PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+# TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+# PERFORMANCE OF THIS SOFTWARE.
+
+
+import argparse
+import gzip
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import bench
+
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+GEN_CAPTURE = os.path.join(SCRIPT_DIR, "gen_capture.py")
+GOLDEN_DIR = os.path.join(SCRIPT_DIR, "golden")
+CAPTURES_DIR = os.path.join(SCRIPT_DIR, "..", "captures")
+
+# The gen_capture.py arguments of each generated case. The resolutions and fragment sizes are picked so that every frame
+# is split into several fragments.
+GENERATED_CASES = (
+    ("t5-control", ["t5", "-C", "-n", "1", "-W", "64", "-H", "64"]),
+    ("t5-bulk", ["t5", "-n", "4", "-W", "320", "-H", "240", "-f", "4096"]),
+    ("t6-control", ["t6", "-C", "-n", "1", "-W", "64", "-H", "64"]),
+    ("t6-bulk", ["t6", "-a", "-n", "4", "-W", "320", "-H", "240", "-f", "4096"]),
+)
+
+
+def cases():
+    """Returns the name, gen_capture.py arguments (or None), capture path (or None), and golden file path of each case.
+
+    Every bundled capture is a case too. Their packet details run to hundreds of megabytes, so their golden files are
+    gzipped."""
+    result = [(name, gen_args, None, os.path.join(GOLDEN_DIR, name + ".json")) for name, gen_args in GENERATED_CASES]
+    for file_name in sorted(os.listdir(CAPTURES_DIR)):
+        if file_name.endswith(".pcapng.gz"):
+            name = file_name[:-len(".pcapng.gz")]
+            result.append((name, None, os.path.join(CAPTURES_DIR, file_name),
+                os.path.join(GOLDEN_DIR, "captures", name + ".json.gz")))
+    return result
+
+def dissect(tshark, env, name, gen_args, capture_path, out_dir):
+    """Generates the case's capture if it has none and returns the path of its packet details."""
+    if not capture_path:
+        capture_path = os.path.join(out_dir, name + ".pcapng")
+        subprocess.run([sys.executable, GEN_CAPTURE] + gen_args + ["-o", capture_path], check=True,
+            stderr=subprocess.DEVNULL)
+
+    out_path = os.path.join(out_dir, name + ".json")
+    with open(out_path, "wb") as out:
+        bench.run_tshark(tshark, env, capture_path, bench.COMPARE_ARGS, stdout=out)
+    return out_path
+
+def update(out_path, golden_path):
+    os.makedirs(os.path.dirname(golden_path), exist_ok=True)
+    if golden_path.endswith(".gz"):
+        # No timestamp in the gzip header, so an unchanged golden file stays byte-for-byte the same.
+        with open(out_path, "rb") as src, open(golden_path, "wb") as raw, gzip.GzipFile(fileobj=raw, mode="wb", mtime=0) as dst:
+            shutil.copyfileobj(src, dst)
+    else:
+        shutil.copyfile(out_path, golden_path)
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare the plugin's packet details for the generated and bundled captures against the golden files.")
+    parser.add_argument("-p", "--plugin", type=str, default="mct_trigger.so", help="The plugin to load. Default: %(default)s")
+    parser.add_argument("-t", "--tshark", type=str, default="tshark", help="The tshark binary to run. Default: %(default)s")
+    parser.add_argument("-u", "--update", action="store_true", help="Overwrite the golden files with this plugin's output instead.")
+    args = parser.parse_args()
+
+    failures = []
+    skipped = []
+    with bench.tshark_env(args.tshark, args.plugin) as env:
+        for name, gen_args, capture_path, golden_path in cases():
+            # One case at a time, since the packet details of a bundled capture are large.
+            with tempfile.TemporaryDirectory() as out_dir:
+                if not args.update and not os.path.exists(golden_path):
+                    # Cases without a golden file yet, e.g. a newly added capture, don't fail the others.
+                    skipped.append(name)
+                    print("{}: skipped, no {}".format(name, os.path.relpath(golden_path)))
+                    continue
+
+                out_path = dissect(args.tshark, env, name, gen_args, capture_path, out_dir)
+                if args.update:
+                    update(out_path, golden_path)
+                    print("{}: updated".format(name))
+                    continue
+
+                line_num = bench.first_difference(out_path, golden_path)
+                if line_num is not None:
+                    failures.append("{}: packet details differ from {}, starting at line {}".format(
+                        name, os.path.relpath(golden_path), line_num))
+                else:
+                    print("{}: ok".format(name))
+
+    if skipped:
+        print("{} case(s) skipped, run \"make golden\" with a known-good build to create their golden files".format(
+            len(skipped)), file=sys.stderr)
+    for failure in failures:
+        print("FAIL: " + failure, file=sys.stderr)
+    if failures:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
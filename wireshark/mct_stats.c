@@ -0,0 +1,754 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_stats.c - Stream statistics for MCT's Trigger 5 and Trigger 6 protocols.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+
+#include <epan/epan.h>
+#include <epan/packet.h>
+#include <epan/stats_tree.h>
+#include <epan/tap.h>
+
+#include "mct_stats.h"
+
+
+typedef struct device_state_s {
+    gchar * name;
+    int node_id;
+    bool have_last_frame;
+    nstime_t last_frame_ts;
+    int64_t window_secs;
+    uint32_t window_frames;
+    uint64_t window_bytes;
+} device_state_t;
+
+/* Latencies are binned by their top five significant bits (in microseconds), so every bin is within about 3% of the
+ * latencies in it, no matter how large they are. */
+#define LATENCY_SUB_BINS 16
+#define LATENCY_BINS ((31 - 4 + 1) * LATENCY_SUB_BINS)
+
+typedef struct latency_state_s {
+    gchar * name;
+    int node_id;
+    int percentiles_node_id;
+    uint32_t frames;
+    uint32_t bins[LATENCY_BINS];
+} latency_state_t;
+
+/* The sessions of a device are keyed by their name within the device's state. Bytes are kept here rather than in
+ * the (int) node counters so they can't overflow on long captures. */
+typedef struct session_device_state_s {
+    gchar * name;
+    int node_id;
+    int bytes_node_id;
+    uint64_t bytes;
+    GHashTable * session_bytes;
+} session_device_state_t;
+
+typedef struct audio_state_s {
+    gchar * name;
+    int node_id;
+    bool have_last_chunk;
+    nstime_t last_chunk_ts;
+    double last_chunk_duration;
+    double jitter;
+    int64_t window_secs;
+    bool window_valid;
+    uint32_t window_samples;
+} audio_state_t;
+
+typedef struct mode_state_s {
+    gchar * name;
+    int node_id;
+    gchar * mode_name;
+    nstime_t mode_set_ts;
+    /* How much of the time since mode_set_ts has already been added to the mode's node. */
+    int mode_accounted_ms;
+} mode_state_t;
+
+static const char * const NODE_DEVICES = "MCT video devices";
+static const char * const NODE_FRAMES = "Frames";
+static const char * const NODE_FRAMES_COMPRESSED = "Compressed";
+static const char * const NODE_FRAMES_UNCOMPRESSED = "Uncompressed";
+static const char * const NODE_BYTES_PER_FRAME = "Bytes per frame";
+static const char * const NODE_FRAMES_PER_SECOND = "Frames per active second";
+static const char * const NODE_BANDWIDTH = "Bulk bandwidth per active second (kB/s)";
+static const char * const NODE_FRAME_GAP = "Inter-frame gap (ms)";
+
+static const char * const NODE_LATENCY_DEVICES = "MCT video devices";
+static const char * const NODE_LATENCY = "Frame latency (us)";
+static const char * const NODE_LATENCY_PERCENTILES = "Frame latency percentiles (us)";
+static const char * const NODE_LATENCY_P50 = "p50";
+static const char * const NODE_LATENCY_P99 = "p99";
+static const char * const NODE_LATENCY_P999 = "p99.9";
+static const char * const NODE_LATENCY_RANGE = "Frame latency (ms)";
+
+static const char * const NODE_AUDIO_DEVICES = "MCT audio devices";
+static const char * const NODE_AUDIO_CHUNK_INTERVAL = "Chunk interval (us)";
+static const char * const NODE_AUDIO_JITTER = "Interarrival jitter (us)";
+static const char * const NODE_AUDIO_SAMPLE_RATE = "Effective sample rate per active second (Hz)";
+static const char * const NODE_AUDIO_RATE_ERROR = "Sample rate error vs. nominal (ppm)";
+static const char * const NODE_AUDIO_TRUNCATED = "Truncated chunks";
+
+static const char * const NODE_CURSOR_DEVICES = "MCT cursor uploads";
+static const char * const NODE_CURSOR_UNIQUE = "Unique";
+static const char * const NODE_CURSOR_DUPLICATE = "Duplicate";
+static const char * const NODE_CURSOR_BYTES = "Upload bytes";
+static const char * const NODE_CURSOR_REDUNDANT_BYTES = "Redundant upload bytes";
+
+static const char * const NODE_SESSION_DEVICES = "MCT bulk sessions";
+static const char * const NODE_SESSION_BYTES = "Bulk kB";
+static const char * const NODE_SESSION_SELECTORS = "Selectors";
+static const char * const NODE_SESSION_FRAGMENTS = "Fragments";
+static const char * const NODE_SESSION_FRAGMENT_LEN = "Fragment length (bytes)";
+static const char * const NODE_SESSION_DEST_ADDRS = "Destination addresses";
+
+static const char * const NODE_INTERRUPT_DEVICES = "MCT interrupt devices";
+static const char * const NODE_INTERRUPT_EVENTS = "Events";
+static const char * const NODE_INTERRUPT_VIDEO_DELAY = "Time to next video frame (us)";
+static const char * const NODE_INTERRUPT_BULK_GAP = "Bulk gap across event (us)";
+static const char * const NODE_INTERRUPT_BULK_STALLS = "Bulk stalls";
+
+static const char * const NODE_MODE_OUTPUTS = "MCT video outputs";
+static const char * const NODE_MODE_SWITCHES = "Mode switches";
+static const char * const NODE_MODE_TIME = "Time in mode (ms)";
+
+static int MCT_TAP = -1;
+static int MCT_AUDIO_TAP = -1;
+static int MCT_CURSOR_TAP = -1;
+static int MCT_MODE_TAP = -1;
+static int MCT_SESSION_TAP = -1;
+static int MCT_INTERRUPT_TAP = -1;
+
+static int DEVICES_NODE = -1;
+static int LATENCY_DEVICES_NODE = -1;
+static int AUDIO_DEVICES_NODE = -1;
+static int CURSOR_DEVICES_NODE = -1;
+static int MODE_OUTPUTS_NODE = -1;
+static int SESSION_DEVICES_NODE = -1;
+static int INTERRUPT_DEVICES_NODE = -1;
+
+/* Per-device state for the (only) instance of each stats tree, keyed by device ID. */
+static GHashTable * DEVICE_STATES = NULL;
+static GHashTable * LATENCY_STATES = NULL;
+static GHashTable * AUDIO_STATES = NULL;
+/* Keyed by output name, since that's made of both the device ID and the output index. */
+static GHashTable * MODE_STATES = NULL;
+/* The mode statistics tree, and the timestamp of the capture's last packet that each output's current mode is counted
+ * up to when the tree is drawn. */
+static stats_tree * MODE_STATS_TREE = NULL;
+static nstime_t MODE_LAST_TS;
+static bool MODE_HAVE_LAST_TS = false;
+static GHashTable * SESSION_DEVICE_STATES = NULL;
+
+void mct_stats_register_tap(void) {
+    MCT_TAP = register_tap("mct");
+    MCT_AUDIO_TAP = register_tap("mct.audio");
+    MCT_CURSOR_TAP = register_tap("mct.cursor");
+    MCT_MODE_TAP = register_tap("mct.modes");
+    MCT_SESSION_TAP = register_tap("mct.sessions");
+    MCT_INTERRUPT_TAP = register_tap("mct.interrupts");
+}
+
+/* The latency of a frame is the time from the submission of its first bulk URB to the completion of its last one.
+ * Bulk OUT completions don't carry any data, so the USB dissector only links the last URB's submission to its
+ * completion once it has seen the completion, i.e., on the second pass. */
+bool mct_stats_frame_latency(packet_info *pinfo, const usb_conv_info_t *usb_conv_info, guint32 first_frame_num, nstime_t *latency) {
+    if (!usb_conv_info || !usb_conv_info->usb_trans_info || !usb_conv_info->usb_trans_info->response_in) {
+        return false;
+    }
+
+    const nstime_t * submit_ts = (first_frame_num == pinfo->num) ? &pinfo->abs_ts : epan_get_frame_ts(pinfo->epan, first_frame_num);
+    const nstime_t * complete_ts = epan_get_frame_ts(pinfo->epan, usb_conv_info->usb_trans_info->response_in);
+    if (!submit_ts || !complete_ts) {
+        return false;
+    }
+
+    nstime_delta(latency, complete_ts, submit_ts);
+    return true;
+}
+
+bool mct_stats_tap_wanted(void) {
+    return have_tap_listener(MCT_TAP);
+}
+
+void mct_stats_tap_queue(packet_info *pinfo, const mct_tap_info_t *tap_info) {
+    tap_queue_packet(MCT_TAP, pinfo, tap_info);
+}
+
+bool mct_stats_audio_tap_wanted(void) {
+    return have_tap_listener(MCT_AUDIO_TAP);
+}
+
+void mct_stats_audio_tap_queue(packet_info *pinfo, const mct_audio_tap_info_t *tap_info) {
+    tap_queue_packet(MCT_AUDIO_TAP, pinfo, tap_info);
+}
+
+bool mct_stats_cursor_tap_wanted(void) {
+    return have_tap_listener(MCT_CURSOR_TAP);
+}
+
+void mct_stats_cursor_tap_queue(packet_info *pinfo, const mct_cursor_tap_info_t *tap_info) {
+    tap_queue_packet(MCT_CURSOR_TAP, pinfo, tap_info);
+}
+
+bool mct_stats_mode_tap_wanted(void) {
+    return have_tap_listener(MCT_MODE_TAP);
+}
+
+void mct_stats_mode_tap_queue(packet_info *pinfo, const mct_mode_tap_info_t *tap_info) {
+    tap_queue_packet(MCT_MODE_TAP, pinfo, tap_info);
+}
+
+bool mct_stats_session_tap_wanted(void) {
+    return have_tap_listener(MCT_SESSION_TAP);
+}
+
+void mct_stats_session_tap_queue(packet_info *pinfo, const mct_session_tap_info_t *tap_info) {
+    tap_queue_packet(MCT_SESSION_TAP, pinfo, tap_info);
+}
+
+bool mct_stats_interrupt_tap_wanted(void) {
+    return have_tap_listener(MCT_INTERRUPT_TAP);
+}
+
+void mct_stats_interrupt_tap_queue(packet_info *pinfo, const mct_interrupt_tap_info_t *tap_info) {
+    tap_queue_packet(MCT_INTERRUPT_TAP, pinfo, tap_info);
+}
+
+static void flush_window(stats_tree *st, device_state_t *state) {
+    if ((state->window_frames == 0) && (state->window_bytes == 0)) {
+        return;
+    }
+
+    avg_stat_node_add_value_int(st, NODE_FRAMES_PER_SECOND, state->node_id, false, state->window_frames);
+    avg_stat_node_add_value_int(st, NODE_BANDWIDTH, state->node_id, false, (int)(state->window_bytes / 1000));
+
+    state->window_frames = 0;
+    state->window_bytes = 0;
+}
+
+static void device_state_free(gpointer data) {
+    device_state_t * state = (device_state_t *)data;
+    g_free(state->name);
+    g_free(state);
+}
+
+static void mct_stats_tree_init(stats_tree *st) {
+    DEVICES_NODE = stats_tree_create_node(st, NODE_DEVICES, 0, STAT_DT_INT, true);
+    DEVICE_STATES = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, device_state_free);
+}
+
+static void mct_stats_tree_cleanup(stats_tree *st) {
+    if (DEVICE_STATES) {
+        g_hash_table_destroy(DEVICE_STATES);
+        DEVICE_STATES = NULL;
+    }
+}
+
+static tap_packet_status mct_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_tap_info_t * tap_info = (const mct_tap_info_t *)p;
+
+    device_state_t * state = (device_state_t *)g_hash_table_lookup(DEVICE_STATES, GUINT_TO_POINTER(tap_info->device_id));
+    if (!state) {
+        state = g_new0(device_state_t, 1);
+
+        state->name = g_strdup_printf("%s, bus %u device %u", tap_info->proto_name,
+            tap_info->device_id >> 16, tap_info->device_id & 0xFFFF);
+        state->node_id = stats_tree_create_node(st, state->name, DEVICES_NODE, STAT_DT_INT, true);
+
+        stats_tree_create_range_node(st, NODE_FRAME_GAP, state->node_id,
+            "0-4", "5-9", "10-16", "17-33", "34-66", "67-99", "100-999", "1000-", NULL);
+
+        state->window_secs = pinfo->abs_ts.secs;
+
+        g_hash_table_insert(DEVICE_STATES, GUINT_TO_POINTER(tap_info->device_id), state);
+    }
+
+    tick_stat_node(st, NODE_DEVICES, 0, true);
+    tick_stat_node(st, state->name, DEVICES_NODE, true);
+
+    /* One-second windows are only closed by a later transfer, so the final (partial) window of each device is never
+     * counted. */
+    if (pinfo->abs_ts.secs != state->window_secs) {
+        flush_window(st, state);
+        state->window_secs = pinfo->abs_ts.secs;
+    }
+
+    state->window_bytes += tap_info->bulk_bytes;
+
+    if (tap_info->frame_start) {
+        state->window_frames++;
+
+        int frames_node = tick_stat_node(st, NODE_FRAMES, state->node_id, true);
+        tick_stat_node(st, tap_info->compressed ? NODE_FRAMES_COMPRESSED : NODE_FRAMES_UNCOMPRESSED, frames_node, false);
+
+        avg_stat_node_add_value_int(st, NODE_BYTES_PER_FRAME, state->node_id, false, tap_info->frame_bytes);
+
+        if (state->have_last_frame) {
+            nstime_t gap;
+            nstime_delta(&gap, &pinfo->abs_ts, &state->last_frame_ts);
+            stats_tree_tick_range(st, NODE_FRAME_GAP, state->node_id, (int)(nstime_to_sec(&gap) * 1000));
+        }
+        state->last_frame_ts = pinfo->abs_ts;
+        state->have_last_frame = true;
+    }
+
+    return TAP_PACKET_REDRAW;
+}
+
+static unsigned latency_bin(int latency_us) {
+    if (latency_us < LATENCY_SUB_BINS) {
+        return latency_us;
+    }
+
+    unsigned shift = g_bit_storage(latency_us) - 5;
+    return (shift + 1) * LATENCY_SUB_BINS + ((latency_us >> shift) - LATENCY_SUB_BINS);
+}
+
+/* Returns the middle of the bin. */
+static int latency_bin_value(unsigned bin) {
+    if (bin < LATENCY_SUB_BINS) {
+        return bin;
+    }
+
+    unsigned shift = bin / LATENCY_SUB_BINS - 1;
+    int low = (LATENCY_SUB_BINS + bin % LATENCY_SUB_BINS) << shift;
+    return low + ((1 << shift) >> 1);
+}
+
+static int latency_percentile(const latency_state_t *state, double percentile) {
+    uint64_t rank = (uint64_t)((state->frames * percentile) / 100.0 + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t count = 0;
+    for (unsigned bin = 0; bin < LATENCY_BINS; bin++) {
+        count += state->bins[bin];
+        if (count >= rank) {
+            return latency_bin_value(bin);
+        }
+    }
+
+    return INT_MAX;
+}
+
+static void latency_state_free(gpointer data) {
+    latency_state_t * state = (latency_state_t *)data;
+    g_free(state->name);
+    g_free(state);
+}
+
+static void mct_latency_stats_tree_init(stats_tree *st) {
+    LATENCY_DEVICES_NODE = stats_tree_create_node(st, NODE_LATENCY_DEVICES, 0, STAT_DT_INT, true);
+    LATENCY_STATES = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, latency_state_free);
+}
+
+static void mct_latency_stats_tree_cleanup(stats_tree *st) {
+    if (LATENCY_STATES) {
+        g_hash_table_destroy(LATENCY_STATES);
+        LATENCY_STATES = NULL;
+    }
+}
+
+static tap_packet_status mct_latency_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_tap_info_t * tap_info = (const mct_tap_info_t *)p;
+
+    if (!tap_info->have_latency) {
+        return TAP_PACKET_DONT_REDRAW;
+    }
+
+    latency_state_t * state = (latency_state_t *)g_hash_table_lookup(LATENCY_STATES, GUINT_TO_POINTER(tap_info->device_id));
+    if (!state) {
+        state = g_new0(latency_state_t, 1);
+
+        state->name = g_strdup_printf("%s, bus %u device %u", tap_info->proto_name,
+            tap_info->device_id >> 16, tap_info->device_id & 0xFFFF);
+        state->node_id = stats_tree_create_node(st, state->name, LATENCY_DEVICES_NODE, STAT_DT_INT, true);
+        state->percentiles_node_id = stats_tree_create_node(st, NODE_LATENCY_PERCENTILES, state->node_id, STAT_DT_INT, true);
+
+        stats_tree_create_range_node(st, NODE_LATENCY_RANGE, state->node_id,
+            "0-4", "5-9", "10-16", "17-33", "34-66", "67-99", "100-999", "1000-", NULL);
+
+        g_hash_table_insert(LATENCY_STATES, GUINT_TO_POINTER(tap_info->device_id), state);
+    }
+
+    tick_stat_node(st, NODE_LATENCY_DEVICES, 0, true);
+    tick_stat_node(st, state->name, LATENCY_DEVICES_NODE, true);
+
+    /* Negative latencies would mean the capture's timestamps went backwards, so treat those as zero. */
+    double latency_secs = nstime_to_sec(&tap_info->latency);
+    int latency_us = (latency_secs <= 0) ? 0 : (latency_secs * 1e6 >= INT_MAX) ? INT_MAX : (int)(latency_secs * 1e6);
+
+    avg_stat_node_add_value_int(st, NODE_LATENCY, state->node_id, false, latency_us);
+    stats_tree_tick_range(st, NODE_LATENCY_RANGE, state->node_id, latency_us / 1000);
+
+    state->frames++;
+    state->bins[latency_bin(latency_us)]++;
+
+    /* The percentiles are approximations from the bins, so they can be off by a few percent. */
+    set_int_stat_node(st, NODE_LATENCY_P50, state->percentiles_node_id, false, latency_percentile(state, 50.0));
+    set_int_stat_node(st, NODE_LATENCY_P99, state->percentiles_node_id, false, latency_percentile(state, 99.0));
+    set_int_stat_node(st, NODE_LATENCY_P999, state->percentiles_node_id, false, latency_percentile(state, 99.9));
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void audio_state_free(gpointer data) {
+    audio_state_t * state = (audio_state_t *)data;
+    g_free(state->name);
+    g_free(state);
+}
+
+static void mct_audio_stats_tree_init(stats_tree *st) {
+    AUDIO_DEVICES_NODE = stats_tree_create_node(st, NODE_AUDIO_DEVICES, 0, STAT_DT_INT, true);
+    AUDIO_STATES = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, audio_state_free);
+}
+
+static void mct_audio_stats_tree_cleanup(stats_tree *st) {
+    if (AUDIO_STATES) {
+        g_hash_table_destroy(AUDIO_STATES);
+        AUDIO_STATES = NULL;
+    }
+}
+
+static tap_packet_status mct_audio_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_audio_tap_info_t * tap_info = (const mct_audio_tap_info_t *)p;
+
+    if (tap_info->nominal_sample_rate == 0) {
+        return TAP_PACKET_DONT_REDRAW;
+    }
+
+    audio_state_t * state = (audio_state_t *)g_hash_table_lookup(AUDIO_STATES, GUINT_TO_POINTER(tap_info->device_id));
+    if (!state) {
+        state = g_new0(audio_state_t, 1);
+
+        state->name = g_strdup_printf("Trigger 6, bus %u device %u", tap_info->device_id >> 16, tap_info->device_id & 0xFFFF);
+        state->node_id = stats_tree_create_node(st, state->name, AUDIO_DEVICES_NODE, STAT_DT_INT, true);
+        stats_tree_create_node(st, NODE_AUDIO_TRUNCATED, state->node_id, STAT_DT_INT, false);
+
+        state->window_secs = pinfo->abs_ts.secs;
+
+        g_hash_table_insert(AUDIO_STATES, GUINT_TO_POINTER(tap_info->device_id), state);
+    }
+
+    tick_stat_node(st, NODE_AUDIO_DEVICES, 0, true);
+    tick_stat_node(st, state->name, AUDIO_DEVICES_NODE, true);
+    if (tap_info->truncated) {
+        tick_stat_node(st, NODE_AUDIO_TRUNCATED, state->node_id, false);
+    }
+
+    if (state->have_last_chunk) {
+        /* Every chunk should arrive one chunk duration (at the nominal rate) after the previous one, so the jitter is
+         * the smoothed deviation from that, as in RFC 3550. */
+        nstime_t interval;
+        nstime_delta(&interval, &pinfo->abs_ts, &state->last_chunk_ts);
+        double interval_secs = nstime_to_sec(&interval);
+        double deviation = interval_secs - state->last_chunk_duration;
+        state->jitter += ((deviation < 0 ? -deviation : deviation) - state->jitter) / 16.0;
+
+        avg_stat_node_add_value_int(st, NODE_AUDIO_CHUNK_INTERVAL, state->node_id, false, (int)(interval_secs * 1e6));
+        avg_stat_node_add_value_int(st, NODE_AUDIO_JITTER, state->node_id, false, (int)(state->jitter * 1e6));
+    }
+
+    /* One-second windows are only closed by a later chunk, so the final (partial) window is never counted. Windows
+     * that don't directly follow another one are partial too, since the stream was started partway through them. */
+    if (pinfo->abs_ts.secs != state->window_secs) {
+        bool consecutive = pinfo->abs_ts.secs == state->window_secs + 1;
+        if (consecutive && state->window_valid) {
+            int error_ppm = (int)(((double)state->window_samples - tap_info->nominal_sample_rate) * 1e6 / tap_info->nominal_sample_rate);
+            avg_stat_node_add_value_int(st, NODE_AUDIO_SAMPLE_RATE, state->node_id, false, state->window_samples);
+            avg_stat_node_add_value_int(st, NODE_AUDIO_RATE_ERROR, state->node_id, false, error_ppm);
+        }
+        state->window_valid = consecutive;
+        state->window_secs = pinfo->abs_ts.secs;
+        state->window_samples = 0;
+    }
+
+    state->window_samples += tap_info->samples;
+
+    state->last_chunk_ts = pinfo->abs_ts;
+    state->last_chunk_duration = (double)tap_info->samples / tap_info->nominal_sample_rate;
+    state->have_last_chunk = true;
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void mct_cursor_stats_tree_init(stats_tree *st) {
+    CURSOR_DEVICES_NODE = stats_tree_create_node(st, NODE_CURSOR_DEVICES, 0, STAT_DT_INT, true);
+}
+
+static tap_packet_status mct_cursor_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_cursor_tap_info_t * tap_info = (const mct_cursor_tap_info_t *)p;
+
+    tick_stat_node(st, NODE_CURSOR_DEVICES, 0, true);
+
+    gchar * device_name = g_strdup_printf("Trigger 6, bus %u device %u", tap_info->device_id >> 16, tap_info->device_id & 0xFFFF);
+    int device_node = tick_stat_node(st, device_name, CURSOR_DEVICES_NODE, true);
+    g_free(device_name);
+
+    tick_stat_node(st, tap_info->duplicate ? NODE_CURSOR_DUPLICATE : NODE_CURSOR_UNIQUE, device_node, false);
+    increase_stat_node(st, NODE_CURSOR_BYTES, device_node, false, tap_info->upload_bytes);
+    if (tap_info->duplicate) {
+        increase_stat_node(st, NODE_CURSOR_REDUNDANT_BYTES, device_node, false, tap_info->upload_bytes);
+    }
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void mode_state_free(gpointer data) {
+    mode_state_t * state = (mode_state_t *)data;
+    g_free(state->name);
+    g_free(state->mode_name);
+    g_free(state);
+}
+
+/* Adds the time since the output's current mode was set that hasn't been counted yet. It's called both when the mode
+ * changes and whenever the tree is drawn, so only what's new since the last call is added. */
+static void mode_state_account(stats_tree *st, mode_state_t *state, const nstime_t *ts) {
+    if (!state->mode_name) {
+        return;
+    }
+
+    nstime_t time_in_mode;
+    nstime_delta(&time_in_mode, ts, &state->mode_set_ts);
+    int time_in_mode_ms = (int)(nstime_to_sec(&time_in_mode) * 1000);
+    if (time_in_mode_ms > state->mode_accounted_ms) {
+        int time_node = increase_stat_node(st, NODE_MODE_TIME, state->node_id, false,
+            time_in_mode_ms - state->mode_accounted_ms);
+        increase_stat_node(st, state->mode_name, time_node, false, time_in_mode_ms - state->mode_accounted_ms);
+        state->mode_accounted_ms = time_in_mode_ms;
+    }
+}
+
+static tap_packet_status mode_last_ts_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags) {
+    MODE_LAST_TS = pinfo->abs_ts;
+    MODE_HAVE_LAST_TS = true;
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+/* Counts each output's current mode up to the last packet read so far, so the last mode of each output is included
+ * without any per-packet work in the tree itself. */
+static void mode_last_ts_draw(void *tapdata) {
+    if (!MODE_STATS_TREE || !MODE_STATES || !MODE_HAVE_LAST_TS) {
+        return;
+    }
+
+    GHashTableIter iter;
+    gpointer value = NULL;
+    g_hash_table_iter_init(&iter, MODE_STATES);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        mode_state_account(MODE_STATS_TREE, (mode_state_t *)value, &MODE_LAST_TS);
+    }
+}
+
+static void mct_mode_stats_tree_init(stats_tree *st) {
+    MODE_OUTPUTS_NODE = stats_tree_create_node(st, NODE_MODE_OUTPUTS, 0, STAT_DT_INT, true);
+    MODE_STATES = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, mode_state_free);
+    MODE_HAVE_LAST_TS = false;
+
+    /* stats_tree has no end-of-capture callback, so a plain listener on the frame tap closes out the open modes. It's
+     * registered after the tree's own listener, and listeners are drawn newest first, so its draw runs before the
+     * tree is printed. */
+    if (!MODE_STATS_TREE) {
+        GString * error = register_tap_listener("frame", &MODE_LAST_TS, NULL, TL_REQUIRES_NOTHING, NULL,
+            mode_last_ts_packet, mode_last_ts_draw, NULL);
+        if (error) {
+            g_string_free(error, true);
+        }
+    }
+    MODE_STATS_TREE = st;
+}
+
+static void mct_mode_stats_tree_cleanup(stats_tree *st) {
+    if (MODE_STATS_TREE) {
+        remove_tap_listener(&MODE_LAST_TS);
+        MODE_STATS_TREE = NULL;
+    }
+
+    if (MODE_STATES) {
+        g_hash_table_destroy(MODE_STATES);
+        MODE_STATES = NULL;
+    }
+}
+
+static tap_packet_status mct_mode_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_mode_tap_info_t * tap_info = (const mct_mode_tap_info_t *)p;
+
+    gchar * name = g_strdup_printf("Trigger 6, bus %u device %u, output %u", tap_info->device_id >> 16,
+        tap_info->device_id & 0xFFFF, tap_info->output_index);
+    mode_state_t * state = (mode_state_t *)g_hash_table_lookup(MODE_STATES, name);
+    if (!state) {
+        state = g_new0(mode_state_t, 1);
+
+        state->name = name;
+        state->node_id = stats_tree_create_node(st, state->name, MODE_OUTPUTS_NODE, STAT_DT_INT, true);
+
+        g_hash_table_insert(MODE_STATES, state->name, state);
+    } else {
+        g_free(name);
+    }
+
+    tick_stat_node(st, NODE_MODE_OUTPUTS, 0, true);
+    tick_stat_node(st, state->name, MODE_OUTPUTS_NODE, true);
+
+    const mct_t6_video_mode_t * mode = tap_info->mode;
+    gchar * mode_name = (tap_info->mode_index >= 0) ?
+        g_strdup_printf("%u x %u @ %u Hz (mode %d)", mode->line_active_pixels, mode->frame_active_lines, mode->refresh_rate_hz, tap_info->mode_index) :
+        g_strdup_printf("%u x %u @ %u Hz (not in mode table)", mode->line_active_pixels, mode->frame_active_lines, mode->refresh_rate_hz);
+
+    mode_state_account(st, state, &pinfo->abs_ts);
+
+    /* The timeline: one node per switch, named after when it happened so they can be told apart. */
+    int switches_node = tick_stat_node(st, NODE_MODE_SWITCHES, state->node_id, true);
+    gchar * switch_name = g_strdup_printf("Frame %u at %.3f s: %s", pinfo->num, nstime_to_sec(&pinfo->rel_ts), mode_name);
+    tick_stat_node(st, switch_name, switches_node, false);
+    g_free(switch_name);
+
+    g_free(state->mode_name);
+    state->mode_name = mode_name;
+    state->mode_set_ts = pinfo->abs_ts;
+    state->mode_accounted_ms = 0;
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void session_device_state_free(gpointer data) {
+    session_device_state_t * state = (session_device_state_t *)data;
+    g_free(state->name);
+    g_hash_table_destroy(state->session_bytes);
+    g_free(state);
+}
+
+static void mct_session_stats_tree_init(stats_tree *st) {
+    SESSION_DEVICES_NODE = stats_tree_create_node(st, NODE_SESSION_DEVICES, 0, STAT_DT_INT, true);
+    SESSION_DEVICE_STATES = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, session_device_state_free);
+}
+
+static void mct_session_stats_tree_cleanup(stats_tree *st) {
+    if (SESSION_DEVICE_STATES) {
+        g_hash_table_destroy(SESSION_DEVICE_STATES);
+        SESSION_DEVICE_STATES = NULL;
+    }
+}
+
+static tap_packet_status mct_session_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_session_tap_info_t * tap_info = (const mct_session_tap_info_t *)p;
+
+    session_device_state_t * state = (session_device_state_t *)g_hash_table_lookup(SESSION_DEVICE_STATES, GUINT_TO_POINTER(tap_info->device_id));
+    if (!state) {
+        state = g_new0(session_device_state_t, 1);
+
+        state->name = g_strdup_printf("Trigger 6, bus %u device %u", tap_info->device_id >> 16, tap_info->device_id & 0xFFFF);
+        state->node_id = stats_tree_create_node(st, state->name, SESSION_DEVICES_NODE, STAT_DT_INT, true);
+        state->bytes_node_id = stats_tree_create_node(st, NODE_SESSION_BYTES, state->node_id, STAT_DT_INT, true);
+        state->session_bytes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+        g_hash_table_insert(SESSION_DEVICE_STATES, GUINT_TO_POINTER(tap_info->device_id), state);
+    }
+
+    tick_stat_node(st, NODE_SESSION_DEVICES, 0, true);
+    tick_stat_node(st, state->name, SESSION_DEVICES_NODE, true);
+
+    uint64_t * session_bytes = (uint64_t *)g_hash_table_lookup(state->session_bytes, tap_info->session_name);
+    if (!session_bytes) {
+        session_bytes = g_new0(uint64_t, 1);
+        g_hash_table_insert(state->session_bytes, g_strdup(tap_info->session_name), session_bytes);
+    }
+
+    /* Each session's share of the device's bulk bytes is its percentage of the "Bulk kB" node. */
+    state->bytes += tap_info->bytes;
+    *session_bytes += tap_info->bytes;
+    set_int_stat_node(st, NODE_SESSION_BYTES, state->node_id, false, (int)MIN(state->bytes / 1000, INT_MAX));
+    set_int_stat_node(st, tap_info->session_name, state->bytes_node_id, false, (int)MIN(*session_bytes / 1000, INT_MAX));
+
+    int session_node = tick_stat_node(st, tap_info->session_name, state->node_id, true);
+    if (tap_info->selector) {
+        tick_stat_node(st, NODE_SESSION_SELECTORS, session_node, false);
+
+        gchar * dest_addr_name = g_strdup_printf("0x%08x", tap_info->dest_addr);
+        int dest_addrs_node = tick_stat_node(st, NODE_SESSION_DEST_ADDRS, session_node, true);
+        tick_stat_node(st, dest_addr_name, dest_addrs_node, false);
+        g_free(dest_addr_name);
+    } else {
+        tick_stat_node(st, NODE_SESSION_FRAGMENTS, session_node, false);
+        avg_stat_node_add_value_int(st, NODE_SESSION_FRAGMENT_LEN, session_node, false, tap_info->bytes);
+    }
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void mct_interrupt_stats_tree_init(stats_tree *st) {
+    INTERRUPT_DEVICES_NODE = stats_tree_create_node(st, NODE_INTERRUPT_DEVICES, 0, STAT_DT_INT, true);
+}
+
+static tap_packet_status mct_interrupt_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt, const void *p, tap_flags_t flags) {
+    const mct_interrupt_tap_info_t * tap_info = (const mct_interrupt_tap_info_t *)p;
+
+    gchar * device_name = g_strdup_printf("Trigger 6, bus %u device %u", tap_info->device_id >> 16, tap_info->device_id & 0xFFFF);
+    /* Only the events themselves are counted, but the device's node is needed for the bulk gaps and delays too. */
+    int device_node = increase_stat_node(st, device_name, INTERRUPT_DEVICES_NODE, true, 0);
+
+    if (tap_info->event) {
+        tick_stat_node(st, NODE_INTERRUPT_DEVICES, 0, true);
+        tick_stat_node(st, device_name, INTERRUPT_DEVICES_NODE, true);
+        int events_node = tick_stat_node(st, NODE_INTERRUPT_EVENTS, device_node, true);
+        tick_stat_node(st, tap_info->event_name, events_node, false);
+    }
+
+    if (tap_info->have_video_delay) {
+        int delay_us = (int)(nstime_to_sec(&tap_info->video_delay) * 1e6);
+        int delay_node = avg_stat_node_add_value_int(st, NODE_INTERRUPT_VIDEO_DELAY, device_node, true, delay_us);
+        avg_stat_node_add_value_int(st, tap_info->event_name, delay_node, false, delay_us);
+    }
+
+    if (tap_info->have_bulk_gap) {
+        int gap_us = (int)(nstime_to_sec(&tap_info->bulk_gap) * 1e6);
+        int gap_node = avg_stat_node_add_value_int(st, NODE_INTERRUPT_BULK_GAP, device_node, true, gap_us);
+        avg_stat_node_add_value_int(st, tap_info->event_name, gap_node, false, gap_us);
+
+        if (tap_info->bulk_stall) {
+            int stalls_node = tick_stat_node(st, NODE_INTERRUPT_BULK_STALLS, device_node, true);
+            tick_stat_node(st, tap_info->event_name, stalls_node, false);
+        }
+    }
+
+    g_free(device_name);
+
+    return TAP_PACKET_REDRAW;
+}
+
+void register_tap_listener_mct_stats(void) {
+    stats_tree_register_plugin("mct", "mct", "MCT Trigger/Video Streams", 0,
+        mct_stats_tree_packet, mct_stats_tree_init, mct_stats_tree_cleanup);
+    stats_tree_register_plugin("mct", "mct.latency", "MCT Trigger/Frame Latency", 0,
+        mct_latency_stats_tree_packet, mct_latency_stats_tree_init, mct_latency_stats_tree_cleanup);
+    stats_tree_register_plugin("mct.audio", "mct.audio", "MCT Trigger/Audio Streams", 0,
+        mct_audio_stats_tree_packet, mct_audio_stats_tree_init, mct_audio_stats_tree_cleanup);
+    stats_tree_register_plugin("mct.cursor", "mct.cursor", "MCT Trigger/Cursor Uploads", 0,
+        mct_cursor_stats_tree_packet, mct_cursor_stats_tree_init, NULL);
+    stats_tree_register_plugin("mct.modes", "mct.modes", "MCT Trigger/Video Mode Changes", 0,
+        mct_mode_stats_tree_packet, mct_mode_stats_tree_init, mct_mode_stats_tree_cleanup);
+    stats_tree_register_plugin("mct.sessions", "mct.sessions", "MCT Trigger/Bulk Sessions", 0,
+        mct_session_stats_tree_packet, mct_session_stats_tree_init, mct_session_stats_tree_cleanup);
+    stats_tree_register_plugin("mct.interrupts", "mct.interrupts", "MCT Trigger/Interrupt Events", 0,
+        mct_interrupt_stats_tree_packet, mct_interrupt_stats_tree_init, NULL);
+}
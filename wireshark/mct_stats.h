@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  mct_stats.h - Stream statistics for MCT's Trigger 5 and Trigger 6 protocols.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCT_STATS_H_INCLUDED
+#define MCT_STATS_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <epan/packet.h>
+#include <epan/dissectors/packet-usb.h>
+
+#include "mct_t6.h"
+
+/* Queued once for every video bulk transfer. */
+typedef struct mct_tap_info_s {
+    const char * proto_name;
+    uint32_t device_id;
+    uint32_t bulk_bytes;
+    bool frame_start;
+    bool compressed;
+    uint32_t frame_bytes;
+    /* Only set for the last transfer of a frame, and only once that transfer's completion has been seen. */
+    bool have_latency;
+    nstime_t latency;
+} mct_tap_info_t;
+
+/* Queued once for every reassembled audio payload. */
+typedef struct mct_audio_tap_info_s {
+    uint32_t device_id;
+    uint32_t nominal_sample_rate;
+    uint32_t samples;
+    /* The payload's captured length is less than its reported length, so its data is (partly) missing. */
+    bool truncated;
+} mct_audio_tap_info_t;
+
+/* Queued once for every reassembled cursor upload. */
+typedef struct mct_cursor_tap_info_s {
+    uint32_t device_id;
+    uint32_t upload_bytes;
+    bool duplicate;
+} mct_cursor_tap_info_t;
+
+/* Queued once for every set video mode request. mode_index is -1 if the mode isn't in the output's mode table. */
+typedef struct mct_mode_tap_info_s {
+    uint32_t device_id;
+    uint32_t output_index;
+    int32_t mode_index;
+    const mct_t6_video_mode_t * mode;
+} mct_mode_tap_info_t;
+
+bool mct_stats_frame_latency(packet_info *pinfo, const usb_conv_info_t *usb_conv_info, guint32 first_frame_num, nstime_t *latency);
+
+/* Queued once for every T6 bulk transfer, selector or fragment. */
+typedef struct mct_session_tap_info_s {
+    uint32_t device_id;
+    const char * session_name;
+    bool selector;
+    uint32_t dest_addr;
+    uint32_t bytes;
+} mct_session_tap_info_t;
+
+/* Queued once for every interrupt event, once for the bulk gap across the events before every bulk transfer that
+ * follows any, and once for every event that a video frame was the first to follow. */
+typedef struct mct_interrupt_tap_info_s {
+    uint32_t device_id;
+    const char * event_name;
+    bool event;
+    bool have_bulk_gap;
+    nstime_t bulk_gap;
+    bool bulk_stall;
+    bool have_video_delay;
+    nstime_t video_delay;
+} mct_interrupt_tap_info_t;
+
+void mct_stats_register_tap(void);
+bool mct_stats_tap_wanted(void);
+void mct_stats_tap_queue(packet_info *pinfo, const mct_tap_info_t *tap_info);
+bool mct_stats_audio_tap_wanted(void);
+void mct_stats_audio_tap_queue(packet_info *pinfo, const mct_audio_tap_info_t *tap_info);
+bool mct_stats_cursor_tap_wanted(void);
+void mct_stats_cursor_tap_queue(packet_info *pinfo, const mct_cursor_tap_info_t *tap_info);
+bool mct_stats_mode_tap_wanted(void);
+void mct_stats_mode_tap_queue(packet_info *pinfo, const mct_mode_tap_info_t *tap_info);
+bool mct_stats_session_tap_wanted(void);
+void mct_stats_session_tap_queue(packet_info *pinfo, const mct_session_tap_info_t *tap_info);
+bool mct_stats_interrupt_tap_wanted(void);
+void mct_stats_interrupt_tap_queue(packet_info *pinfo, const mct_interrupt_tap_info_t *tap_info);
+
+void register_tap_listener_mct_stats(void);
+
+#endif // MCT_STATS_H_INCLUDED
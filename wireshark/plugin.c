@@ -21,7 +21,10 @@
 #include <stdint.h>
 
 #include <epan/proto.h>
+#include <epan/tap.h>
 
+#include "mct_stats.h"
+#include "proto_edid.h"
 #include "proto_t5.h"
 #include "proto_t6.h"
 
@@ -32,6 +35,8 @@ uint32_t const plugin_want_minor = PLUGIN_WANT_MINOR;
 
 
 static void proto_register_all(void) {
+    mct_stats_register_tap();
+    proto_register_mct_edid();
     proto_register_trigger5();
     proto_register_trigger6();
 }
@@ -46,6 +51,11 @@ static const proto_plugin plugin = {
     .register_handoff = proto_reg_handoff_all,
 };
 
+static const tap_plugin tap = {
+    .register_tap_listener = register_tap_listener_mct_stats,
+};
+
 void plugin_register(void) {
     proto_register_plugin(&plugin);
+    tap_register_plugin(&tap);
 }
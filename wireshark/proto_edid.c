@@ -0,0 +1,443 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  proto_edid.c - Dissector for the monitor EDIDs read through MCT's display adapters.
+ *  Copyright (C) 2023-2024  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include <epan/expert.h>
+#include <epan/packet.h>
+#include <epan/proto.h>
+
+#include "mct_edid.h"
+#include "proto_edid.h"
+
+
+static const value_string EXTENSION_TAGS[] = {
+    { MCT_EDID_EXTENSION_TAG_CTA, "CTA-861" },
+    { MCT_EDID_EXTENSION_TAG_VTB, "Video Timing Block" },
+    { MCT_EDID_EXTENSION_TAG_DI, "Display Information" },
+    { MCT_EDID_EXTENSION_TAG_LS, "Localized String" },
+    { MCT_EDID_EXTENSION_TAG_DPVL, "Digital Packet Video Link" },
+    { MCT_EDID_EXTENSION_TAG_DISPLAYID, "DisplayID" },
+    { MCT_EDID_EXTENSION_TAG_BLOCK_MAP, "Block Map" },
+    { MCT_EDID_EXTENSION_TAG_MANUFACTURER, "Manufacturer Specific" },
+    { 0, NULL },
+};
+
+static const value_string DESCRIPTOR_TAGS[] = {
+    { 0xFF, "Display Product Serial Number" },
+    { 0xFE, "Alphanumeric Data String" },
+    { MCT_EDID_DESCRIPTOR_TAG_RANGE_LIMITS, "Display Range Limits" },
+    { MCT_EDID_DESCRIPTOR_TAG_PRODUCT_NAME, "Display Product Name" },
+    { 0xFB, "Color Point Data" },
+    { 0xFA, "Standard Timing Identifications" },
+    { 0xF9, "Display Color Management Data" },
+    { 0xF8, "CVT 3 Byte Timing Codes" },
+    { 0xF7, "Established Timings III" },
+    { 0x10, "Dummy" },
+    { 0, NULL },
+};
+
+static int PROTO_EDID = -1;
+
+static int HF_EDID_HEADER = -1;
+static int HF_EDID_MANUFACTURER = -1;
+static int HF_EDID_PRODUCT_CODE = -1;
+static int HF_EDID_SERIAL_NUMBER = -1;
+static int HF_EDID_VERSION = -1;
+static int HF_EDID_REVISION = -1;
+static int HF_EDID_DESCRIPTOR = -1;
+static int HF_EDID_DESCRIPTOR_TAG = -1;
+static int HF_EDID_PRODUCT_NAME = -1;
+static int HF_EDID_RANGE_LIMITS_MAX_PIXEL_CLOCK_MHZ = -1;
+static int HF_EDID_EXTENSION_COUNT = -1;
+static int HF_EDID_CHECKSUM = -1;
+static int HF_EDID_CHECKSUM_VALID = -1;
+static int HF_EDID_EXTENSION = -1;
+static int HF_EDID_EXTENSION_TAG = -1;
+static int HF_EDID_EXTENSION_REVISION = -1;
+
+static int HF_EDID_TIMING = -1;
+static int HF_EDID_TIMING_PIXEL_CLOCK_KHZ = -1;
+static int HF_EDID_TIMING_H_ACTIVE = -1;
+static int HF_EDID_TIMING_H_BLANK = -1;
+static int HF_EDID_TIMING_V_ACTIVE = -1;
+static int HF_EDID_TIMING_V_BLANK = -1;
+static int HF_EDID_TIMING_H_FRONT_PORCH = -1;
+static int HF_EDID_TIMING_H_SYNC_WIDTH = -1;
+static int HF_EDID_TIMING_V_FRONT_PORCH = -1;
+static int HF_EDID_TIMING_V_SYNC_WIDTH = -1;
+static int HF_EDID_TIMING_INTERLACED = -1;
+
+static int HF_EDID_ADAPTER = -1;
+static int HF_EDID_ADAPTER_TABLE_FRAME = -1;
+static int HF_EDID_ADAPTER_MAX_PIXEL_CLOCK_KHZ = -1;
+static int HF_EDID_ADAPTER_PREFERRED_SUPPORTED = -1;
+static int HF_EDID_ADAPTER_PREFERRED_MODE_INDEX = -1;
+
+static hf_register_info HF_EDID[] = {
+    { &HF_EDID_HEADER,
+        { "Header", "mct_edid.header",
+        FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_MANUFACTURER,
+        { "Manufacturer", "mct_edid.manufacturer",
+        FT_STRING, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_PRODUCT_CODE,
+        { "Product code", "mct_edid.product_code",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_SERIAL_NUMBER,
+        { "Serial number", "mct_edid.serial_number",
+        FT_UINT32, BASE_DEC_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_VERSION,
+        { "Version", "mct_edid.version",
+        FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_REVISION,
+        { "Revision", "mct_edid.revision",
+        FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_DESCRIPTOR,
+        { "Display descriptor", "mct_edid.descriptor",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_DESCRIPTOR_TAG,
+        { "Tag", "mct_edid.descriptor.tag",
+        FT_UINT8, BASE_HEX, VALS(DESCRIPTOR_TAGS), 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_PRODUCT_NAME,
+        { "Product name", "mct_edid.product_name",
+        FT_STRING, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_RANGE_LIMITS_MAX_PIXEL_CLOCK_MHZ,
+        { "Maximum pixel clock (MHz)", "mct_edid.range_limits.max_pixel_clock_mhz",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_EXTENSION_COUNT,
+        { "Extension block count", "mct_edid.extension_count",
+        FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_CHECKSUM,
+        { "Checksum", "mct_edid.checksum",
+        FT_UINT8, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_CHECKSUM_VALID,
+        { "Checksum valid", "mct_edid.checksum_valid",
+        FT_BOOLEAN, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_EXTENSION,
+        { "Extension block", "mct_edid.extension",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_EXTENSION_TAG,
+        { "Tag", "mct_edid.extension.tag",
+        FT_UINT8, BASE_HEX, VALS(EXTENSION_TAGS), 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_EXTENSION_REVISION,
+        { "Revision", "mct_edid.extension.revision",
+        FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING,
+        { "Detailed timing", "mct_edid.timing",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_PIXEL_CLOCK_KHZ,
+        { "Pixel clock (kHz)", "mct_edid.timing.pixel_clock_khz",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_H_ACTIVE,
+        { "Horizontal active pixels", "mct_edid.timing.h_active",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_H_BLANK,
+        { "Horizontal blanking pixels", "mct_edid.timing.h_blank",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_V_ACTIVE,
+        { "Vertical active lines", "mct_edid.timing.v_active",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_V_BLANK,
+        { "Vertical blanking lines", "mct_edid.timing.v_blank",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_H_FRONT_PORCH,
+        { "Horizontal front porch pixels", "mct_edid.timing.h_front_porch",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_H_SYNC_WIDTH,
+        { "Horizontal sync width", "mct_edid.timing.h_sync_width",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_V_FRONT_PORCH,
+        { "Vertical front porch lines", "mct_edid.timing.v_front_porch",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_V_SYNC_WIDTH,
+        { "Vertical sync width", "mct_edid.timing.v_sync_width",
+        FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_TIMING_INTERLACED,
+        { "Interlaced", "mct_edid.timing.interlaced",
+        FT_BOOLEAN, 8, NULL, 0x80, NULL, HFILL }
+    },
+    { &HF_EDID_ADAPTER,
+        { "Adapter support", "mct_edid.adapter",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_EDID_ADAPTER_TABLE_FRAME,
+        { "Mode table", "mct_edid.adapter.table_frame",
+        FT_FRAMENUM, BASE_NONE, FRAMENUM_TYPE(FT_FRAMENUM_RESPONSE), 0x0, "Frame the adapter's mode table was read in", HFILL }
+    },
+    { &HF_EDID_ADAPTER_MAX_PIXEL_CLOCK_KHZ,
+        { "Highest mode pixel clock (kHz)", "mct_edid.adapter.max_pixel_clock_khz",
+        FT_UINT32, BASE_DEC, NULL, 0x0, "Highest pixel clock of all the modes in the adapter's mode table", HFILL }
+    },
+    { &HF_EDID_ADAPTER_PREFERRED_SUPPORTED,
+        { "Preferred timing supported", "mct_edid.adapter.preferred_supported",
+        FT_BOOLEAN, BASE_NONE, NULL, 0x0, "Whether the adapter's mode table has a mode with the resolution and refresh rate of the monitor's preferred timing", HFILL }
+    },
+    { &HF_EDID_ADAPTER_PREFERRED_MODE_INDEX,
+        { "Preferred timing mode index", "mct_edid.adapter.preferred_mode_index",
+        FT_UINT32, BASE_DEC, NULL, 0x0, "Index of the preferred timing's mode in the adapter's mode table", HFILL }
+    },
+};
+
+static expert_field EI_EDID_CHECKSUM_BAD = EI_INIT;
+static expert_field EI_EDID_PREFERRED_TIMING_UNSUPPORTED = EI_INIT;
+static expert_field EI_EDID_PIXEL_CLOCK_UNSUPPORTED = EI_INIT;
+
+static ei_register_info EI_EDID[] = {
+    { &EI_EDID_CHECKSUM_BAD,
+        { "mct_edid.checksum_bad", PI_CHECKSUM, PI_WARN, "Bad EDID block checksum", EXPFILL }
+    },
+    { &EI_EDID_PREFERRED_TIMING_UNSUPPORTED,
+        { "mct_edid.adapter.preferred_unsupported", PI_PROTOCOL, PI_WARN,
+        "The adapter's mode table has no mode matching the monitor's preferred timing", EXPFILL }
+    },
+    { &EI_EDID_PIXEL_CLOCK_UNSUPPORTED,
+        { "mct_edid.adapter.pixel_clock_unsupported", PI_PROTOCOL, PI_WARN,
+        "The monitor has timings with a higher pixel clock than any mode the adapter supports", EXPFILL }
+    },
+};
+
+static int ETT_EDID = -1;
+static int ETT_EDID_DESCRIPTOR = -1;
+static int ETT_EDID_TIMING = -1;
+static int ETT_EDID_EXTENSION = -1;
+static int ETT_EDID_ADAPTER = -1;
+
+static int * const ETT[] = {
+    &ETT_EDID,
+    &ETT_EDID_DESCRIPTOR,
+    &ETT_EDID_TIMING,
+    &ETT_EDID_EXTENSION,
+    &ETT_EDID_ADAPTER,
+};
+
+
+static void dissect_block_checksum(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, int block_offset) {
+    proto_tree_add_item(tree, HF_EDID_CHECKSUM, tvb, block_offset + MCT_EDID_BLOCK_LEN - 1, 1, ENC_LITTLE_ENDIAN);
+
+    gboolean checksum_valid = mct_edid_block_checksum_valid(tvb_get_ptr(tvb, block_offset, MCT_EDID_BLOCK_LEN));
+    proto_item * valid_item = proto_tree_add_boolean(tree, HF_EDID_CHECKSUM_VALID, tvb, block_offset + MCT_EDID_BLOCK_LEN - 1, 1, checksum_valid);
+    proto_item_set_generated(valid_item);
+    if (!checksum_valid) {
+        expert_add_info(pinfo, valid_item, &EI_EDID_CHECKSUM_BAD);
+    }
+}
+
+static void dissect_detailed_timing(proto_tree *tree, tvbuff_t *tvb, int offset, const mct_edid_detailed_timing_t *timing) {
+    proto_item * timing_item = proto_tree_add_item(tree, HF_EDID_TIMING, tvb, offset, MCT_EDID_DETAILED_TIMING_LEN, ENC_NA);
+    proto_tree * timing_tree = proto_item_add_subtree(timing_item, ETT_EDID_TIMING);
+
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_PIXEL_CLOCK_KHZ, tvb, offset, 2, timing->pixel_clock_khz);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_H_ACTIVE, tvb, offset + 2, 3, timing->h_active);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_H_BLANK, tvb, offset + 2, 3, timing->h_blank);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_V_ACTIVE, tvb, offset + 5, 3, timing->v_active);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_V_BLANK, tvb, offset + 5, 3, timing->v_blank);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_H_FRONT_PORCH, tvb, offset + 8, 4, timing->h_front_porch);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_H_SYNC_WIDTH, tvb, offset + 8, 4, timing->h_sync_width);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_V_FRONT_PORCH, tvb, offset + 8, 4, timing->v_front_porch);
+    proto_tree_add_uint(timing_tree, HF_EDID_TIMING_V_SYNC_WIDTH, tvb, offset + 8, 4, timing->v_sync_width);
+    proto_tree_add_item(timing_tree, HF_EDID_TIMING_INTERLACED, tvb, offset + 17, 1, ENC_LITTLE_ENDIAN);
+
+    proto_item_append_text(timing_item, ": %d x %d%s @ %.5g Hz, %.5g MHz", timing->h_active, timing->v_active,
+        timing->interlaced ? "i" : "", mct_edid_detailed_timing_refresh_rate_hz(timing), timing->pixel_clock_khz/1e3);
+}
+
+static void dissect_descriptor(proto_tree *tree, tvbuff_t *tvb, int offset, const mct_edid_info_t *info) {
+    mct_edid_detailed_timing_t timing;
+    if (mct_edid_detailed_timing_parse(tvb_get_ptr(tvb, offset, MCT_EDID_DETAILED_TIMING_LEN), &timing)) {
+        dissect_detailed_timing(tree, tvb, offset, &timing);
+        return;
+    }
+
+    uint8_t tag = tvb_get_guint8(tvb, offset + 3);
+    proto_item * descriptor_item = proto_tree_add_item(tree, HF_EDID_DESCRIPTOR, tvb, offset, MCT_EDID_DETAILED_TIMING_LEN, ENC_NA);
+    proto_tree * descriptor_tree = proto_item_add_subtree(descriptor_item, ETT_EDID_DESCRIPTOR);
+    proto_tree_add_item(descriptor_tree, HF_EDID_DESCRIPTOR_TAG, tvb, offset + 3, 1, ENC_LITTLE_ENDIAN);
+    proto_item_append_text(descriptor_item, ": %s", val_to_str_const(tag, DESCRIPTOR_TAGS, "Unknown"));
+
+    if (tag == MCT_EDID_DESCRIPTOR_TAG_PRODUCT_NAME) {
+        proto_tree_add_string(descriptor_tree, HF_EDID_PRODUCT_NAME, tvb, offset + 5, 13, info->product_name);
+    } else if (tag == MCT_EDID_DESCRIPTOR_TAG_RANGE_LIMITS) {
+        proto_tree_add_uint(descriptor_tree, HF_EDID_RANGE_LIMITS_MAX_PIXEL_CLOCK_MHZ, tvb, offset + 9, 1, tvb_get_guint8(tvb, offset + 9) * 10);
+    }
+}
+
+static void dissect_extension(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, int block_offset) {
+    uint8_t tag = tvb_get_guint8(tvb, block_offset);
+    proto_item * extension_item = proto_tree_add_item(tree, HF_EDID_EXTENSION, tvb, block_offset, MCT_EDID_BLOCK_LEN, ENC_NA);
+    proto_tree * extension_tree = proto_item_add_subtree(extension_item, ETT_EDID_EXTENSION);
+    proto_item_append_text(extension_item, " %d: %s", block_offset / MCT_EDID_BLOCK_LEN, val_to_str_const(tag, EXTENSION_TAGS, "Unknown"));
+
+    proto_tree_add_item(extension_tree, HF_EDID_EXTENSION_TAG, tvb, block_offset, 1, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(extension_tree, HF_EDID_EXTENSION_REVISION, tvb, block_offset + 1, 1, ENC_LITTLE_ENDIAN);
+
+    if (tag == MCT_EDID_EXTENSION_TAG_CTA) {
+        /* Byte 2 is the offset of the first detailed timing, or 0 if there aren't any. */
+        for (int offset = tvb_get_guint8(tvb, block_offset + 2); (offset >= 4) && (offset + MCT_EDID_DETAILED_TIMING_LEN < MCT_EDID_BLOCK_LEN);
+            offset += MCT_EDID_DETAILED_TIMING_LEN) {
+            mct_edid_detailed_timing_t timing;
+            if (!mct_edid_detailed_timing_parse(tvb_get_ptr(tvb, block_offset + offset, MCT_EDID_DETAILED_TIMING_LEN), &timing)) {
+                break;
+            }
+            dissect_detailed_timing(extension_tree, tvb, block_offset + offset, &timing);
+        }
+    }
+
+    dissect_block_checksum(extension_tree, pinfo, tvb, block_offset);
+}
+
+/* Only the resolution and refresh rate are compared, since the adapter's modes don't always use the exact timings
+ * of the EDID. */
+static void dissect_adapter_support(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, const mct_edid_info_t *info,
+    const edid_adapter_modes_t *adapter_modes) {
+    proto_item * adapter_item = proto_tree_add_item(tree, HF_EDID_ADAPTER, tvb, 0, 0, ENC_NA);
+    proto_item_set_generated(adapter_item);
+    proto_tree * adapter_tree = proto_item_add_subtree(adapter_item, ETT_EDID_ADAPTER);
+
+    proto_item_set_generated(proto_tree_add_uint(adapter_tree, HF_EDID_ADAPTER_TABLE_FRAME, tvb, 0, 0, adapter_modes->table_frame_num));
+
+    uint32_t max_pixel_clock_khz = 0;
+    gint32 preferred_mode_index = -1;
+    double preferred_refresh_rate_hz = info->has_preferred_timing ? mct_edid_detailed_timing_refresh_rate_hz(&info->preferred_timing) : 0;
+    for (guint i = 0; i < adapter_modes->count; i++) {
+        const edid_adapter_mode_t * mode = &adapter_modes->modes[i];
+        if (mode->pixel_clock_khz > max_pixel_clock_khz) {
+            max_pixel_clock_khz = mode->pixel_clock_khz;
+        }
+        if (info->has_preferred_timing && (preferred_mode_index < 0) &&
+            (mode->width == info->preferred_timing.h_active) && (mode->height == info->preferred_timing.v_active) &&
+            (fabs(mode->refresh_rate_hz - preferred_refresh_rate_hz) < 1)) {
+            preferred_mode_index = i;
+        }
+    }
+
+    proto_item * max_pixel_clock_item = proto_tree_add_uint(adapter_tree, HF_EDID_ADAPTER_MAX_PIXEL_CLOCK_KHZ, tvb, 0, 0, max_pixel_clock_khz);
+    proto_item_set_generated(max_pixel_clock_item);
+    if (info->max_timing_pixel_clock_khz > max_pixel_clock_khz) {
+        expert_add_info_format(pinfo, max_pixel_clock_item, &EI_EDID_PIXEL_CLOCK_UNSUPPORTED,
+            "The monitor has a %.5g MHz timing, but the adapter's fastest mode is %.5g MHz",
+            info->max_timing_pixel_clock_khz/1e3, max_pixel_clock_khz/1e3);
+    }
+
+    if (!info->has_preferred_timing) {
+        return;
+    }
+
+    proto_item * supported_item = proto_tree_add_boolean(adapter_tree, HF_EDID_ADAPTER_PREFERRED_SUPPORTED, tvb, 0, 0, preferred_mode_index >= 0);
+    proto_item_set_generated(supported_item);
+    if (preferred_mode_index >= 0) {
+        proto_item_set_generated(proto_tree_add_uint(adapter_tree, HF_EDID_ADAPTER_PREFERRED_MODE_INDEX, tvb, 0, 0, preferred_mode_index));
+        proto_item_append_text(adapter_item, ": Preferred timing is mode %d", preferred_mode_index);
+    } else {
+        expert_add_info(pinfo, supported_item, &EI_EDID_PREFERRED_TIMING_UNSUPPORTED);
+        proto_item_append_text(adapter_item, ": Preferred timing not supported");
+    }
+}
+
+/* Dissects a complete EDID, i.e., the base block followed by all of its extension blocks. data is an optional
+ * edid_adapter_modes_t. */
+static int dissect_edid(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data) {
+    const edid_adapter_modes_t * adapter_modes = (const edid_adapter_modes_t *)data;
+
+    if (tvb_captured_length(tvb) < MCT_EDID_BLOCK_LEN) {
+        return 0;
+    }
+
+    guint block_count = tvb_captured_length(tvb) / MCT_EDID_BLOCK_LEN;
+    mct_edid_info_t info;
+    mct_edid_parse(tvb_get_ptr(tvb, 0, block_count * MCT_EDID_BLOCK_LEN), block_count * MCT_EDID_BLOCK_LEN, &info);
+
+    proto_item * edid_item = proto_tree_add_item(tree, PROTO_EDID, tvb, 0, block_count * MCT_EDID_BLOCK_LEN, ENC_NA);
+    proto_tree * edid_tree = proto_item_add_subtree(edid_item, ETT_EDID);
+    proto_item_append_text(edid_item, ": %s %04x", info.manufacturer, info.product_code);
+    if (info.product_name[0]) {
+        proto_item_append_text(edid_item, " \"%s\"", info.product_name);
+    }
+    if (info.has_preferred_timing) {
+        proto_item_append_text(edid_item, ", %d x %d @ %.5g Hz", info.preferred_timing.h_active, info.preferred_timing.v_active,
+            mct_edid_detailed_timing_refresh_rate_hz(&info.preferred_timing));
+    }
+
+    proto_tree_add_item(edid_tree, HF_EDID_HEADER, tvb, 0, 8, ENC_NA);
+    proto_tree_add_string(edid_tree, HF_EDID_MANUFACTURER, tvb, 8, 2, info.manufacturer);
+    proto_tree_add_item(edid_tree, HF_EDID_PRODUCT_CODE, tvb, 10, 2, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(edid_tree, HF_EDID_SERIAL_NUMBER, tvb, 12, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(edid_tree, HF_EDID_VERSION, tvb, 18, 1, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(edid_tree, HF_EDID_REVISION, tvb, 19, 1, ENC_LITTLE_ENDIAN);
+    for (int offset = 54; offset < 126; offset += MCT_EDID_DETAILED_TIMING_LEN) {
+        dissect_descriptor(edid_tree, tvb, offset, &info);
+    }
+    proto_tree_add_item(edid_tree, HF_EDID_EXTENSION_COUNT, tvb, 126, 1, ENC_LITTLE_ENDIAN);
+    dissect_block_checksum(edid_tree, pinfo, tvb, 0);
+
+    for (guint i = 1; i < block_count; i++) {
+        dissect_extension(edid_tree, pinfo, tvb, i * MCT_EDID_BLOCK_LEN);
+    }
+
+    if (adapter_modes) {
+        dissect_adapter_support(edid_tree, pinfo, tvb, &info, adapter_modes);
+    }
+
+    return block_count * MCT_EDID_BLOCK_LEN;
+}
+
+void proto_register_mct_edid(void) {
+    proto_register_subtree_array(ETT, array_length(ETT));
+
+    PROTO_EDID = proto_register_protocol(
+        "Extended Display Identification Data (MCT)",
+        "MCT EDID",
+        "mct_edid"
+    );
+
+    proto_register_field_array(PROTO_EDID, HF_EDID, array_length(HF_EDID));
+
+    expert_module_t * expert_edid = expert_register_protocol(PROTO_EDID);
+    expert_register_field_array(expert_edid, EI_EDID, array_length(EI_EDID));
+
+    register_dissector("mct_edid", dissect_edid, PROTO_EDID);
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ *  proto_edid.h - Dissector for the monitor EDIDs read through MCT's display adapters.
+ *  Copyright (C) 2023  Forest Crossman <cyrozap@gmail.com>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROTO_EDID_H_INCLUDED
+#define PROTO_EDID_H_INCLUDED
+
+#include <stdint.h>
+
+#include <epan/packet.h>
+
+/* One of the modes the adapter reported for the output the EDID was read from. */
+typedef struct edid_adapter_mode_s {
+    uint32_t width;
+    uint32_t height;
+    uint32_t refresh_rate_hz;
+    uint32_t pixel_clock_khz;
+} edid_adapter_mode_t;
+
+/* Passed as the data of the "mct_edid" dissector, so the EDID can be compared against the adapter's mode table.
+ * table_frame_num is the frame the table was read in. */
+typedef struct edid_adapter_modes_s {
+    const edid_adapter_mode_t * modes;
+    guint count;
+    guint32 table_frame_num;
+} edid_adapter_modes_t;
+
+void proto_register_mct_edid(void);
+
+#endif // PROTO_EDID_H_INCLUDED
@@ -18,14 +18,21 @@
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <inttypes.h>
 #include <stdint.h>
 
 #include <epan/dissectors/packet-usb.h>
 #include <epan/expert.h>
 #include <epan/packet.h>
+#include <epan/prefs.h>
 #include <epan/proto.h>
+#include <epan/range.h>
 #include <epan/reassemble.h>
 
+#include "mct_edid.h"
+#include "mct_stats.h"
+#include "mct_t5.h"
+#include "proto_edid.h"
 #include "proto_t5.h"
 
 
@@ -36,29 +43,50 @@ static const int CTRL_WLEN_OFFSET = 5;
 static const int CTRL_SETUP_DATA_OFFSET = 7;
 
 typedef struct header_info_s {
-    uint16_t frame_counter;
-    uint16_t frame_flags;
-    uint16_t horiz_offset;
-    uint16_t vert_offset;
-    uint16_t width;
-    uint16_t height;
-    uint32_t payload_len;
-    uint32_t payload_flags;
+    uint32_t frame_num;
+    mct_t5_bulk_header_t header;
 } header_info_t;
 
 typedef struct fragment_info_s {
-    uint32_t header_fragment_frame_num;
+    uint32_t frame_num;
+    uint32_t header_index;
+    uint32_t skipped_len;
+    bool resynced;
     uint32_t fragment_offset;
     uint32_t fragment_len;
     uint32_t packet_len_remaining;
 } fragment_info_t;
 
+/* Both arrays are only ever appended to on the first pass, which visits frames in order, so they're always sorted by
+ * frame number. Fragments refer to their packet's header by index so each header is only stored once. The stream state
+ * is likewise only advanced on the first pass. */
 typedef struct bulk_conv_info_s {
-    fragment_info_t * last_fragment_info;
-    wmem_map_t * header_info_by_frame_num;
-    wmem_map_t * fragment_info_by_frame_num;
+    wmem_array_t * header_infos;
+    wmem_array_t * fragment_infos;
+    mct_t5_bulk_state_t state;
 } bulk_conv_info_t;
 
+/* The modes (edid_adapter_mode_t) of a "Get array of video modes" response. */
+typedef struct video_mode_table_s {
+    guint32 frame_num;
+    wmem_array_t * modes;
+} video_mode_table_t;
+
+/* The last mode table read and the EDID being read, both only updated on the first pass. */
+typedef struct control_conv_info_s {
+    video_mode_table_t * video_mode_table;
+    mct_edid_assembly_t edid_assembly;
+} control_conv_info_t;
+
+/* An EDID completed by a "Get EDID block" response, along with the mode table at the time. */
+typedef struct edid_info_s {
+    guint8 * data;
+    guint len;
+    video_mode_table_t * table;
+} edid_info_t;
+
+#define PROTO_DATA_EDID_INFO 0
+
 static const uint32_t MCT_USB_VID = 0x0711;
 
 static const range_t MCT_USB_PID_RANGE = {
@@ -98,6 +126,7 @@ static const value_string CONTROL_REQS[] = {
 static const true_false_string tfs_sync_polarity = { "Negative", "Positive" };
 
 static dissector_handle_t T5_HANDLE = NULL;
+static dissector_handle_t EDID_HANDLE = NULL;
 
 static reassembly_table T5_REASSEMBLY_TABLE = { 0 };
 
@@ -421,6 +450,8 @@ static int HF_T5_BULK_MAGIC = -1;
 static int HF_T5_BULK_HEADER_LEN = -1;
 static int HF_T5_BULK_FRAME_INFO = -1;
 static int HF_T5_BULK_FRAME_FLAGS = -1;
+static int HF_T5_BULK_FRAME_COMPRESSED = -1;
+static int HF_T5_BULK_FRAME_BIT_DEPTH = -1;
 static int HF_T5_BULK_FRAME_COUNTER = -1;
 static int HF_T5_BULK_H_OFFSET = -1;
 static int HF_T5_BULK_V_OFFSET = -1;
@@ -433,6 +464,14 @@ static int HF_T5_BULK_OTHER_FLAGS = -1;
 static int HF_T5_BULK_HEADER_CHECKSUM = -1;
 static int HF_T5_BULK_PAYLOAD_FRAGMENT = -1;
 static int HF_T5_BULK_REASSEMBLED_PAYLOAD = -1;
+static int HF_T5_BULK_FRAME_LATENCY = -1;
+
+static const value_string FRAME_BIT_DEPTHS[] = {
+    { MCT_T5_DEPTH_24, "24-bit" },
+    { MCT_T5_DEPTH_32, "32-bit" },
+    { MCT_T5_DEPTH_16, "16-bit" },
+    { 0, NULL },
+};
 
 static hf_register_info HF_T5_BULK[] = {
     { &HF_T5_BULK_MAGIC,
@@ -451,6 +490,14 @@ static hf_register_info HF_T5_BULK[] = {
         { "Frame flags", "trigger5.bulk.frame_info.flags",
         FT_UINT16, BASE_HEX, NULL, 0xF000, NULL, HFILL }
     },
+    { &HF_T5_BULK_FRAME_COMPRESSED,
+        { "Compressed", "trigger5.bulk.frame_info.compressed",
+        FT_BOOLEAN, 16, NULL, MCT_T5_BULK_FRAME_FLAG_COMPRESSED << 12, NULL, HFILL }
+    },
+    { &HF_T5_BULK_FRAME_BIT_DEPTH,
+        { "Bit depth", "trigger5.bulk.frame_info.bit_depth",
+        FT_UINT16, BASE_DEC, VALS(FRAME_BIT_DEPTHS), MCT_T5_BULK_FRAME_FLAG_DEPTH_MASK << 12, NULL, HFILL }
+    },
     { &HF_T5_BULK_FRAME_COUNTER,
         { "Frame counter", "trigger5.bulk.frame_info.counter",
         FT_UINT16, BASE_DEC_HEX, NULL, 0x0FFF, NULL, HFILL }
@@ -499,6 +546,11 @@ static hf_register_info HF_T5_BULK[] = {
         { "Reassembled payload", "trigger5.bulk.reassembled_payload",
         FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
     },
+    { &HF_T5_BULK_FRAME_LATENCY,
+        { "Frame latency", "trigger5.bulk.frame_latency",
+        FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0,
+        "Time from the submission of the packet's first bulk URB to the completion of its last one", HFILL }
+    },
 };
 
 static int HF_T5_BULK_FRAGMENTS = -1;
@@ -575,6 +627,16 @@ static hf_register_info HF_T5_BULK_FRAG[] = {
     },
 };
 
+/* The layout of the T5 interrupt packets hasn't been worked out yet, so they're only shown as raw data. */
+static int HF_T5_INTERRUPT_DATA = -1;
+
+static hf_register_info HF_T5_INTERRUPT[] = {
+    { &HF_T5_INTERRUPT_DATA,
+        { "Interrupt data", "trigger5.interrupt.data",
+        FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+};
+
 static int ETT_T5 = -1;
 static int ETT_T5_FIRMWARE_VERSION = -1;
 static int ETT_T5_FIRMWARE_DATE = -1;
@@ -595,29 +657,162 @@ static int * const ETT[] = {
 };
 
 static expert_field EI_T5_BULK_HEADER_CHECKSUM_INVALID = EI_INIT;
+static expert_field EI_T5_BULK_RESYNC = EI_INIT;
+static expert_field EI_T5_BULK_PAYLOAD_LEN_MISMATCH = EI_INIT;
 
 static ei_register_info EI_T5_BULK[] = {
     { &EI_T5_BULK_HEADER_CHECKSUM_INVALID,
         { "trigger5.bulk.header_checksum_invalid", PI_CHECKSUM, PI_WARN,
             "Header checksum is invalid", EXPFILL }
     },
+    { &EI_T5_BULK_RESYNC,
+        { "trigger5.bulk.resync", PI_SEQUENCE, PI_WARN,
+            "Lost sync with the packet stream, resynchronized on the next valid header", EXPFILL }
+    },
+    { &EI_T5_BULK_PAYLOAD_LEN_MISMATCH,
+        { "trigger5.bulk.payload_len_mismatch", PI_MALFORMED, PI_NOTE,
+            "Uncompressed payload length doesn't match the rectangle size", EXPFILL }
+    },
 };
 
-static uint8_t bulk_header_checksum(const uint8_t *buf, uint32_t len) {
-    int32_t checksum = 0;
+/* What the heuristic dissector knows about the device at an address from a given frame on. A device is recognized at
+ * one frame and all of its packets from then on are dissected as T5, on every pass, until a device with another
+ * identity shows up at the same address. */
+typedef struct heur_device_s {
+    gboolean recognized;
+    guint32 id;
+    guint16 version;
+} heur_device_t;
+
+/* wmem_tree_t of heur_device_t keyed by the frame they apply from, keyed by bus << 16 | address. */
+static wmem_map_t * HEUR_DEVICES = NULL;
+
+static gboolean PREF_T5_RESYNC = true;
+static gboolean PREF_T5_TRUNCATED_CAPTURE = false;
+
+/* Copies the header at the given offset into buf, returning false if there aren't enough bytes or the magic is wrong.
+ * Working on a single fixed-size copy avoids flattening composite tvbs just to look at 20 bytes. */
+static bool bulk_header_copy(tvbuff_t *tvb, int offset, uint8_t buf[MCT_T5_BULK_HEADER_LEN]) {
+    if (!tvb_bytes_exist(tvb, offset, MCT_T5_BULK_HEADER_LEN)) {
+        return false;
+    }
+
+    tvb_memcpy(tvb, buf, offset, MCT_T5_BULK_HEADER_LEN);
+
+    return mct_t5_bulk_header_magic_valid(buf);
+}
+
+/* Returns the offset of the first header with a valid magic and checksum at or after start_offset, or -1. */
+static int bulk_header_find(tvbuff_t *tvb, int start_offset, uint8_t buf[MCT_T5_BULK_HEADER_LEN]) {
+    int offset = start_offset;
+    while ((offset = tvb_find_guint8(tvb, offset, -1, 0xfb)) >= 0) {
+        if (!tvb_bytes_exist(tvb, offset, MCT_T5_BULK_HEADER_LEN)) {
+            return -1;
+        }
+
+        if (bulk_header_copy(tvb, offset, buf) && mct_t5_bulk_header_checksum_valid(buf)) {
+            return offset;
+        }
+
+        offset++;
+    }
+
+    return -1;
+}
+
+static fragment_info_t * fragment_info_lookup(wmem_array_t *fragment_infos, uint32_t frame_num) {
+    fragment_info_t * fragment_infos_raw = (fragment_info_t *)wmem_array_get_raw(fragment_infos);
+    guint count = wmem_array_get_count(fragment_infos);
+
+    guint low = 0;
+    guint high = count;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        if (fragment_infos_raw[mid].frame_num < frame_num) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
 
-    for (size_t i = 0; i < len; i++) {
-        checksum += buf[i];
+    if ((low < count) && (fragment_infos_raw[low].frame_num == frame_num)) {
+        return &fragment_infos_raw[low];
     }
 
-    return (-checksum) & 0xFF;
+    return NULL;
 }
 
-static uint8_t bulk_header_checksum_tvb_offset(tvbuff_t *tvb, uint32_t offset, uint32_t len) {
-    tvb_ensure_bytes_exist(tvb, offset, len);
-    const uint8_t * buf = tvb_get_ptr(tvb, offset, len);
+static control_conv_info_t * get_control_conv_info(packet_info *pinfo) {
+    conversation_t * conversation = find_or_create_conversation(pinfo);
+    control_conv_info_t * control_conv_info = (control_conv_info_t *)conversation_get_proto_data(conversation, PROTO_T5);
+    if (!control_conv_info) {
+        control_conv_info = wmem_new0(wmem_file_scope(), control_conv_info_t);
+        mct_edid_assembly_reset(&control_conv_info->edid_assembly);
+
+        conversation_add_proto_data(conversation, PROTO_T5, control_conv_info);
+    }
 
-    return bulk_header_checksum(buf, len);
+    return control_conv_info;
+}
+
+static void cache_video_modes(tvbuff_t *tvb, packet_info *pinfo) {
+    if (PINFO_FD_VISITED(pinfo)) {
+        return;
+    }
+
+    video_mode_table_t * table = wmem_new(wmem_file_scope(), video_mode_table_t);
+    table->frame_num = pinfo->num;
+    table->modes = wmem_array_new(wmem_file_scope(), sizeof(edid_adapter_mode_t));
+    for (int offset = 4; offset + 8 <= tvb_captured_length(tvb); offset += 8) {
+        edid_adapter_mode_t mode = {
+            .width = tvb_get_letohs(tvb, offset + 6),
+            .height = tvb_get_letohs(tvb, offset + 4),
+            .refresh_rate_hz = tvb_get_guint8(tvb, offset),
+            .pixel_clock_khz = tvb_get_guint8(tvb, offset + 1) * 1000,
+        };
+        wmem_array_append_one(table->modes, mode);
+    }
+
+    get_control_conv_info(pinfo)->video_mode_table = table;
+}
+
+/* Adds a "Get EDID block" response to the EDID being read, and remembers the whole EDID in the frame that completes
+ * it. */
+static void record_edid_block(tvbuff_t *tvb, packet_info *pinfo, uint16_t block_num) {
+    if (PINFO_FD_VISITED(pinfo) || (tvb_captured_length(tvb) < MCT_EDID_BLOCK_LEN)) {
+        return;
+    }
+
+    control_conv_info_t * control_conv_info = get_control_conv_info(pinfo);
+    size_t len = mct_edid_assembly_add_block(&control_conv_info->edid_assembly, block_num, tvb_get_ptr(tvb, 0, MCT_EDID_BLOCK_LEN));
+    if (len == 0) {
+        return;
+    }
+
+    edid_info_t * edid_info = wmem_new(wmem_file_scope(), edid_info_t);
+    edid_info->data = (guint8 *)wmem_memdup(wmem_file_scope(), control_conv_info->edid_assembly.data, len);
+    edid_info->len = len;
+    edid_info->table = control_conv_info->video_mode_table;
+    p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T5, PROTO_DATA_EDID_INFO, edid_info);
+}
+
+static void dissect_edid(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo) {
+    const edid_info_t * edid_info = (const edid_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T5, PROTO_DATA_EDID_INFO);
+    if (!edid_info) {
+        return;
+    }
+
+    tvbuff_t * edid_tvb = tvb_new_child_real_data(tvb, edid_info->data, edid_info->len, edid_info->len);
+    add_new_data_source(pinfo, edid_tvb, "Reassembled EDID");
+
+    edid_adapter_modes_t adapter_modes = { 0 };
+    if (edid_info->table) {
+        adapter_modes.modes = (const edid_adapter_mode_t *)wmem_array_get_raw(edid_info->table->modes);
+        adapter_modes.count = wmem_array_get_count(edid_info->table->modes);
+        adapter_modes.table_frame_num = edid_info->table->frame_num;
+    }
+
+    call_dissector_with_data(EDID_HANDLE, edid_tvb, pinfo, tree, edid_info->table ? &adapter_modes : NULL);
 }
 
 static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree, usb_conv_info_t *usb_conv_info) {
@@ -643,6 +838,17 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree,
 
     col_set_str(pinfo->cinfo, COL_PROTOCOL, "Trigger 5");
 
+    if (!ptree) {
+        /* The mode table and EDIDs are the only control requests that carry any state, so there's nothing else to do if
+         * the tree isn't going to be shown. */
+        if (in_not_out && !setup_not_completion && (bRequest == CTRL_REQ_A4)) {
+            cache_video_modes(tvb, pinfo);
+        } else if (in_not_out && !setup_not_completion && (bRequest == CTRL_REQ_A8)) {
+            record_edid_block(tvb, pinfo, wValue);
+        }
+        return tvb_captured_length(tvb);
+    }
+
     if (setup_not_completion) {
         proto_tree_add_item(tree, HF_T5_CONTROL_REQ, tvb, CTRL_BREQ_OFFSET, 1, ENC_LITTLE_ENDIAN);
     } else {
@@ -738,7 +944,7 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree,
                             uint32_t div1 = 0;
                             proto_tree_add_item_ret_uint(item_tree, HF_T5_CONTROL_REQ_SET_VIDEO_MODE_CUSTOM_PLL_CONFIG_DIV1, tvb, CTRL_SETUP_DATA_OFFSET+field_offset+4, 1, ENC_BIG_ENDIAN, &div1);
 
-                            pll_freq_khz = 10e3 / pre_div * mul0 * mul1 / div0 / div1;
+                            pll_freq_khz = mct_t5_pll_freq_khz(pre_div, mul0, mul1, div0, div1);
                             proto_item_append_text(item, ": %.5g MHz", pll_freq_khz/1e3);
                         }
 
@@ -786,6 +992,7 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree,
                 break;
             case CTRL_REQ_A4:
                 {
+                    cache_video_modes(tvb, pinfo);
                     proto_tree_add_item(tree, HF_T5_CONTROL_REQ_GET_VIDEO_MODES_COUNT, tvb, 0, 2, ENC_BIG_ENDIAN);
                     proto_item * video_modes_item = proto_tree_add_item(tree, HF_T5_CONTROL_REQ_GET_VIDEO_MODES_DATA, tvb, 4, -1, ENC_NA);
                     proto_tree * video_modes_tree = proto_item_add_subtree(video_modes_item, ETT_T5_VIDEO_MODES);
@@ -806,6 +1013,8 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree,
                 break;
             case CTRL_REQ_A8:
                 proto_tree_add_item(tree, HF_T5_CONTROL_REQ_EDID_BLOCK_DATA, tvb, 0, 128, ENC_NA);
+                record_edid_block(tvb, pinfo, wValue);
+                dissect_edid(tree, tvb, pinfo);
                 break;
             default:
                 proto_tree_add_item(tree, HF_T5_CONTROL_REQ_UNKNOWN_DATA, tvb, 0, -1, ENC_NA);
@@ -816,6 +1025,13 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree,
     return tvb_captured_length(tvb);
 }
 
+/* Key the reassembly on both the conversation (so the fragments of different adapters in the same capture can't be
+ * mixed up) and the 12-bit frame counter (so a packet that failed to reassemble doesn't swallow the fragments of the
+ * next one). */
+static uint32_t bulk_reassembly_id(const conversation_t *conversation, const mct_t5_bulk_header_t *header) {
+    return (conversation->conv_index << 12) | header->frame_counter;
+}
+
 static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree, usb_conv_info_t *usb_conv_info) {
     if (!(usb_conv_info->endpoint == 1 && !usb_conv_info->direction)) {
         return 0;
@@ -831,102 +1047,162 @@ static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree, usb
     conversation_t * conversation = find_or_create_conversation(pinfo);
     bulk_conv_info_t * bulk_conv_info = (bulk_conv_info_t *)conversation_get_proto_data(conversation, PROTO_T5);
     if (!bulk_conv_info) {
-        bulk_conv_info = wmem_new(wmem_file_scope(), bulk_conv_info_t);
-        bulk_conv_info->last_fragment_info = NULL;
-        bulk_conv_info->header_info_by_frame_num = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
-        bulk_conv_info->fragment_info_by_frame_num = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+        bulk_conv_info = wmem_new0(wmem_file_scope(), bulk_conv_info_t);
+        bulk_conv_info->header_infos = wmem_array_new(wmem_file_scope(), sizeof(header_info_t));
+        bulk_conv_info->fragment_infos = wmem_array_new(wmem_file_scope(), sizeof(fragment_info_t));
 
         conversation_add_proto_data(conversation, PROTO_T5, bulk_conv_info);
     }
 
     fragment_info_t * fragment_info = NULL;
     if (!PINFO_FD_VISITED(pinfo)) {
-        if ((bulk_conv_info->last_fragment_info == NULL) || (bulk_conv_info->last_fragment_info->packet_len_remaining == 0)) {
-            /* Packet with header */
+        uint8_t header_buf[MCT_T5_BULK_HEADER_LEN];
+        int header_offset = -1;
+        bool resynced = false;
+        if (mct_t5_bulk_expects_header(&bulk_conv_info->state)) {
+            if (bulk_header_copy(tvb, 0, header_buf)) {
+                header_offset = 0;
+            } else if (PREF_T5_RESYNC) {
+                /* Some data got lost, so skip ahead to the next header that looks real. */
+                header_offset = bulk_header_find(tvb, 1, header_buf);
+                resynced = header_offset >= 0;
+            }
 
-            if (tvb_get_ntohs(tvb, 0) != 0xfb14) {
+            if (header_offset < 0) {
                 return 0;
             }
+        } else if (PREF_T5_RESYNC && bulk_header_copy(tvb, 0, header_buf) && mct_t5_bulk_header_checksum_valid(header_buf)) {
+            /* A fragment was expected but this looks like the start of a new packet, so the rest of the previous
+             * packet must have been lost. Drop the fragments it already has, since they'll never be reassembled and
+             * would otherwise be mixed into the next packet that reuses its frame counter. */
+            header_offset = 0;
+            resynced = true;
+
+            const header_info_t * abandoned = (const header_info_t *)wmem_array_index(bulk_conv_info->header_infos,
+                wmem_array_get_count(bulk_conv_info->header_infos) - 1);
+            fragment_delete(&T5_REASSEMBLY_TABLE, pinfo, bulk_reassembly_id(conversation, &abandoned->header), NULL);
+        }
+
+        if (header_offset >= 0) {
+            /* Packet with header */
 
             /* Create new header info */
-            header_info_t * header_info = wmem_new(wmem_file_scope(), header_info_t);
-            uint16_t frame_counter_and_flags = tvb_get_letohs(tvb, 2);
-            header_info->frame_counter = frame_counter_and_flags & 0x0FFF;
-            header_info->frame_flags = frame_counter_and_flags >> 12;
-            header_info->horiz_offset = tvb_get_letohs(tvb, 4) & 0x1FFF;
-            header_info->vert_offset = tvb_get_letohs(tvb, 6) & 0x1FFF;
-            header_info->width = tvb_get_letohs(tvb, 8) & 0x1FFF;
-            header_info->height = tvb_get_letohs(tvb, 10) & 0x1FFF;
-            header_info->payload_len = tvb_get_letohl(tvb, 12) & 0x0FFFFFFF;
-            header_info->payload_flags = tvb_get_letohl(tvb, 12) >> 28;
-
-            wmem_map_insert(bulk_conv_info->header_info_by_frame_num, GUINT_TO_POINTER(pinfo->num), header_info);
-
-            /* Create new packet info */
-            fragment_info = wmem_new(wmem_file_scope(), fragment_info_t);
-            fragment_info->header_fragment_frame_num = pinfo->num;
-            fragment_info->fragment_offset = 0;
-            uint32_t total_packet_length = 20 + header_info->payload_len;
-            fragment_info->fragment_len = MIN(total_packet_length, tvb_reported_length(tvb));
-            fragment_info->packet_len_remaining = total_packet_length - fragment_info->fragment_len;
-
-            bulk_conv_info->last_fragment_info = fragment_info;
-
-            wmem_map_insert(bulk_conv_info->fragment_info_by_frame_num, GUINT_TO_POINTER(pinfo->num), fragment_info);
+            header_info_t header_info = { 0 };
+            header_info.frame_num = pinfo->num;
+            mct_t5_bulk_header_parse(header_buf, &header_info.header);
+
+            mct_t5_bulk_fragment_t fragment = { 0 };
+            mct_t5_bulk_start_packet(&bulk_conv_info->state, &header_info.header, tvb_reported_length(tvb) - header_offset, &fragment);
+
+            /* Create new fragment info */
+            fragment_info_t new_fragment_info = { 0 };
+            new_fragment_info.frame_num = pinfo->num;
+            new_fragment_info.header_index = wmem_array_get_count(bulk_conv_info->header_infos);
+            new_fragment_info.skipped_len = header_offset;
+            new_fragment_info.resynced = resynced;
+            new_fragment_info.fragment_offset = fragment.fragment_offset;
+            new_fragment_info.fragment_len = fragment.fragment_len;
+            new_fragment_info.packet_len_remaining = fragment.packet_len_remaining;
+
+            wmem_array_append_one(bulk_conv_info->header_infos, header_info);
+            wmem_array_append_one(bulk_conv_info->fragment_infos, new_fragment_info);
         } else {
             /* Fragment */
-            header_info_t * header_info = wmem_map_lookup(bulk_conv_info->header_info_by_frame_num,
-                                                          GUINT_TO_POINTER(bulk_conv_info->last_fragment_info->header_fragment_frame_num));
-            if (header_info) {
-                /* Create new frame info */
-                fragment_info = wmem_new(wmem_file_scope(), fragment_info_t);
-                fragment_info->header_fragment_frame_num = bulk_conv_info->last_fragment_info->header_fragment_frame_num;
-                fragment_info->fragment_offset = bulk_conv_info->last_fragment_info->fragment_offset + bulk_conv_info->last_fragment_info->fragment_len;
-                fragment_info->fragment_len = MIN(bulk_conv_info->last_fragment_info->packet_len_remaining, tvb_reported_length(tvb));
-                fragment_info->packet_len_remaining = bulk_conv_info->last_fragment_info->packet_len_remaining - fragment_info->fragment_len;
-
-                bulk_conv_info->last_fragment_info = fragment_info;
-
-                wmem_map_insert(bulk_conv_info->fragment_info_by_frame_num, GUINT_TO_POINTER(pinfo->num), fragment_info);
-            }
+            mct_t5_bulk_fragment_t fragment = { 0 };
+            mct_t5_bulk_continue_packet(&bulk_conv_info->state, tvb_reported_length(tvb), &fragment);
+
+            fragment_info_t new_fragment_info = { 0 };
+            new_fragment_info.frame_num = pinfo->num;
+            new_fragment_info.header_index = wmem_array_get_count(bulk_conv_info->header_infos) - 1;
+            new_fragment_info.fragment_offset = fragment.fragment_offset;
+            new_fragment_info.fragment_len = fragment.fragment_len;
+            new_fragment_info.packet_len_remaining = fragment.packet_len_remaining;
+
+            wmem_array_append_one(bulk_conv_info->fragment_infos, new_fragment_info);
         }
+
+        /* Fetch the record back out of the array, since appending may have moved it. */
+        fragment_info = (fragment_info_t *)wmem_array_index(bulk_conv_info->fragment_infos, wmem_array_get_count(bulk_conv_info->fragment_infos) - 1);
     } else {
-        fragment_info = wmem_map_lookup(bulk_conv_info->fragment_info_by_frame_num, GUINT_TO_POINTER(pinfo->num));
+        fragment_info = fragment_info_lookup(bulk_conv_info->fragment_infos, pinfo->num);
     }
 
     if (!fragment_info) {
         return 0;
     }
 
-    header_info_t * header_info = header_info = wmem_map_lookup(bulk_conv_info->header_info_by_frame_num, GUINT_TO_POINTER(fragment_info->header_fragment_frame_num));
-    if (!header_info) {
-        return 0;
+    if (fragment_info->resynced) {
+        expert_add_info_format(pinfo, t5_tree_item, &EI_T5_BULK_RESYNC,
+            "Lost sync with the packet stream, resynchronized on the header at offset %u", fragment_info->skipped_len);
+    }
+
+    if (fragment_info->skipped_len > 0) {
+        tvb = tvb_new_subset_remaining(tvb, fragment_info->skipped_len);
     }
 
+    header_info_t * header_info = (header_info_t *)wmem_array_index(bulk_conv_info->header_infos, fragment_info->header_index);
+
     tvbuff_t * next_tvb = NULL;
 
-    bool packet_has_header = pinfo->num == fragment_info->header_fragment_frame_num;
+    bool packet_has_header = pinfo->num == header_info->frame_num;
+
+    /* The last transfer of a packet is where its latency is known, once the transfer's completion has been seen. */
+    nstime_t latency;
+    bool have_latency = (fragment_info->packet_len_remaining == 0) &&
+        mct_stats_frame_latency(pinfo, usb_conv_info, header_info->frame_num, &latency);
+
+    if (mct_stats_tap_wanted()) {
+        mct_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_tap_info_t);
+        tap_info->proto_name = "Trigger 5";
+        tap_info->device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+        tap_info->bulk_bytes = tvb_reported_length(tvb);
+        tap_info->frame_start = packet_has_header;
+        tap_info->compressed = (header_info->header.frame_flags & MCT_T5_BULK_FRAME_FLAG_COMPRESSED) != 0;
+        tap_info->frame_bytes = MCT_T5_BULK_HEADER_LEN + header_info->header.payload_len;
+        tap_info->have_latency = have_latency;
+        if (have_latency) {
+            tap_info->latency = latency;
+        }
+        mct_stats_tap_queue(pinfo, tap_info);
+    }
     if (packet_has_header) {
         /* Packet with header */
-        proto_tree_add_item(tree, HF_T5_BULK_MAGIC, tvb, 0, 1, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_HEADER_LEN, tvb, 1, 1, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_FRAME_FLAGS, tvb, 2, 2, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_FRAME_COUNTER, tvb, 2, 2, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_H_OFFSET, tvb, 4, 2, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_V_OFFSET, tvb, 6, 2, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_WIDTH, tvb, 8, 2, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_HEIGHT, tvb, 10, 2, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_FLAGS, tvb, 12, 4, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_LEN, tvb, 12, 4, ENC_LITTLE_ENDIAN);
-        proto_tree_add_item(tree, HF_T5_BULK_OTHER_FLAGS, tvb, 16, 1, ENC_LITTLE_ENDIAN);
-        uint32_t header_checksum = 0;
-        proto_item * checksum_item = proto_tree_add_item_ret_uint(tree, HF_T5_BULK_HEADER_CHECKSUM, tvb, 19, 1, ENC_LITTLE_ENDIAN, &header_checksum);
-        if (bulk_header_checksum_tvb_offset(tvb, 0, 19) != header_checksum) {
+        proto_item * checksum_item = NULL;
+        if (tree) {
+            proto_tree_add_item(tree, HF_T5_BULK_MAGIC, tvb, 0, 1, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_HEADER_LEN, tvb, 1, 1, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_FRAME_FLAGS, tvb, 2, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_FRAME_COMPRESSED, tvb, 2, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_FRAME_BIT_DEPTH, tvb, 2, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_FRAME_COUNTER, tvb, 2, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_H_OFFSET, tvb, 4, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_V_OFFSET, tvb, 6, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_WIDTH, tvb, 8, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_HEIGHT, tvb, 10, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_FLAGS, tvb, 12, 4, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_LEN, tvb, 12, 4, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_OTHER_FLAGS, tvb, 16, 1, ENC_LITTLE_ENDIAN);
+            checksum_item = proto_tree_add_item(tree, HF_T5_BULK_HEADER_CHECKSUM, tvb, 19, 1, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_FRAGMENT, tvb, 20, MIN(header_info->header.payload_len, tvb_captured_length(tvb) - 20), ENC_NA);
+        }
+
+        /* Always check the checksum so the expert info is available to taps even without a tree. */
+        uint8_t header_buf[MCT_T5_BULK_HEADER_LEN];
+        if (bulk_header_copy(tvb, 0, header_buf) && !mct_t5_bulk_header_checksum_valid(header_buf)) {
             expert_add_info(pinfo, checksum_item, &EI_T5_BULK_HEADER_CHECKSUM_INVALID);
         }
-        proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_FRAGMENT, tvb, 20, MIN(header_info->payload_len, tvb_captured_length(tvb) - 20), ENC_NA);
 
-        if ((20 + header_info->payload_len > fragment_info->fragment_len)) {
+        /* Uncompressed payloads are just the rectangle's pixels, so their length is known from the header. */
+        uint32_t bytes_per_pixel = mct_t5_bulk_bytes_per_pixel(&header_info->header);
+        uint64_t rect_len = (uint64_t)header_info->header.width * header_info->header.height * bytes_per_pixel;
+        if (!(header_info->header.frame_flags & MCT_T5_BULK_FRAME_FLAG_COMPRESSED) && bytes_per_pixel > 0 &&
+            header_info->header.payload_len != rect_len) {
+            expert_add_info_format(pinfo, t5_tree_item, &EI_T5_BULK_PAYLOAD_LEN_MISMATCH,
+                "Uncompressed payload is %u bytes long, but a %ux%u rectangle is %" PRIu64 " bytes",
+                header_info->header.payload_len, header_info->header.width, header_info->header.height, rect_len);
+        }
+
+        if (MCT_T5_BULK_HEADER_LEN + header_info->header.payload_len > fragment_info->fragment_len) {
             /* Fragmented */
             pinfo->fragmented = true;
         } else {
@@ -937,24 +1213,33 @@ static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree, usb
         /* Fragment */
         pinfo->fragmented = true;
 
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_FRAME_FLAGS, tvb, 0, 0, header_info->frame_flags << 12));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_FRAME_COUNTER, tvb, 0, 0, header_info->frame_counter));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_H_OFFSET, tvb, 0, 0, header_info->horiz_offset));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_V_OFFSET, tvb, 0, 0, header_info->vert_offset));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_WIDTH, tvb, 0, 0, header_info->width));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_HEIGHT, tvb, 0, 0, header_info->height));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_PAYLOAD_FLAGS, tvb, 0, 0, header_info->payload_flags << 28));
-        proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_PAYLOAD_LEN, tvb, 0, 0, header_info->payload_len));
-
-        proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_FRAGMENT, tvb, 0, MIN(fragment_info->fragment_len, tvb_captured_length(tvb)), ENC_NA);
+        if (tree) {
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_FRAME_FLAGS, tvb, 0, 0, header_info->header.frame_flags << 12));
+            proto_item_set_generated(proto_tree_add_boolean(tree, HF_T5_BULK_FRAME_COMPRESSED, tvb, 0, 0, header_info->header.frame_flags << 12));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_FRAME_BIT_DEPTH, tvb, 0, 0, header_info->header.frame_flags << 12));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_FRAME_COUNTER, tvb, 0, 0, header_info->header.frame_counter));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_H_OFFSET, tvb, 0, 0, header_info->header.horiz_offset));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_V_OFFSET, tvb, 0, 0, header_info->header.vert_offset));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_WIDTH, tvb, 0, 0, header_info->header.width));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_HEIGHT, tvb, 0, 0, header_info->header.height));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_PAYLOAD_FLAGS, tvb, 0, 0, header_info->header.payload_flags << 28));
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T5_BULK_PAYLOAD_LEN, tvb, 0, 0, header_info->header.payload_len));
+
+            proto_tree_add_item(tree, HF_T5_BULK_PAYLOAD_FRAGMENT, tvb, 0, MIN(fragment_info->fragment_len, tvb_captured_length(tvb)), ENC_NA);
+        }
     }
 
-    if (pinfo->fragmented) {
+    if (pinfo->fragmented && PREF_T5_TRUNCATED_CAPTURE) {
+        /* Sizing only, don't hold on to fragments that will never be reassembled. */
+        col_append_fstr(pinfo->cinfo, COL_INFO, " (Fragment offset %u)", fragment_info->fragment_offset);
+    } else if (pinfo->fragmented) {
         /* Fragmented */
         gboolean more_frags = fragment_info->packet_len_remaining > 0;
 
+        uint32_t reassembly_id = bulk_reassembly_id(conversation, &header_info->header);
+
         fragment_head * frag_head = fragment_add_check(&T5_REASSEMBLY_TABLE,
-            tvb, 0, pinfo, 0, NULL, fragment_info->fragment_offset, tvb_captured_length(tvb), more_frags);
+            tvb, 0, pinfo, reassembly_id, NULL, fragment_info->fragment_offset, tvb_captured_length(tvb), more_frags);
 
         next_tvb = process_reassembled_data(tvb, 0, pinfo, "Reassembled Packet", frag_head, &T5_BULK_FRAG_ITEMS, NULL, tree);
 
@@ -971,20 +1256,32 @@ static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree, usb
         }
     }
 
-    if (next_tvb) {
-        proto_tree_add_item(tree, HF_T5_BULK_REASSEMBLED_PAYLOAD, next_tvb, 20, MIN(header_info->payload_len, tvb_captured_length(next_tvb) - 20), ENC_NA);
+    if (next_tvb && tree) {
+        proto_tree_add_item(tree, HF_T5_BULK_REASSEMBLED_PAYLOAD, next_tvb, 20, MIN(header_info->header.payload_len, tvb_captured_length(next_tvb) - 20), ENC_NA);
+    }
+
+    if (have_latency && tree) {
+        proto_item_set_generated(proto_tree_add_time(tree, HF_T5_BULK_FRAME_LATENCY, tvb, 0, 0, &latency));
     }
 
     return tvb_captured_length(tvb);
 }
 
-static int handle_interrupt(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_conv_info_t *usb_conv_info) {
-    if (!usb_conv_info->direction) {
+static int handle_interrupt(tvbuff_t *tvb, packet_info *pinfo, proto_tree *ptree, usb_conv_info_t *usb_conv_info) {
+    if (!usb_conv_info->direction || (tvb_reported_length(tvb) == 0)) {
         return 0;
     }
 
     /* INTERRUPT IN */
 
+    col_set_str(pinfo->cinfo, COL_PROTOCOL, "Trigger 5");
+
+    if (ptree) {
+        proto_item * t5_tree_item = proto_tree_add_item(ptree, PROTO_T5, tvb, 0, -1, ENC_NA);
+        proto_tree * tree = proto_item_add_subtree(t5_tree_item, ETT_T5);
+        proto_tree_add_item(tree, HF_T5_INTERRUPT_DATA, tvb, 0, -1, ENC_NA);
+    }
+
     return tvb_captured_length(tvb);
 }
 
@@ -1003,6 +1300,75 @@ static int dissect_t5(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void
     };
 }
 
+/* Notes what the heuristic dissector knows about the packet's device from the packet's frame on. */
+static heur_device_t * heur_device_insert(packet_info *pinfo, const usb_conv_info_t *usb_conv_info, gboolean recognized) {
+    gpointer device_key = GUINT_TO_POINTER((usb_conv_info->bus_id << 16) | usb_conv_info->device_address);
+    wmem_tree_t * history = (wmem_tree_t *)wmem_map_lookup(HEUR_DEVICES, device_key);
+    if (!history) {
+        history = wmem_tree_new(wmem_file_scope());
+        wmem_map_insert(HEUR_DEVICES, device_key, history);
+    }
+
+    heur_device_t * device = wmem_new0(wmem_file_scope(), heur_device_t);
+    device->recognized = recognized;
+    device->id = ((guint32)usb_conv_info->deviceVendor << 16) | usb_conv_info->deviceProduct;
+    device->version = usb_conv_info->deviceVersion;
+    wmem_tree_insert32(history, pinfo->num, device);
+    return device;
+}
+
+/* Returns whether the packet's device was recognized by the heuristic dissector at or before the packet's frame. Only
+ * the first pass recognizes devices, so that every pass starts dissecting a device's packets at the same frame, and a
+ * recognition is dropped once the address has a device with another identity, e.g. after re-enumeration. */
+static gboolean heur_device_recognized(packet_info *pinfo, const usb_conv_info_t *usb_conv_info) {
+    wmem_tree_t * history = (wmem_tree_t *)wmem_map_lookup(HEUR_DEVICES,
+        GUINT_TO_POINTER((usb_conv_info->bus_id << 16) | usb_conv_info->device_address));
+    const heur_device_t * device = history ? (const heur_device_t *)wmem_tree_lookup32_le(history, pinfo->num) : NULL;
+    if (!device || !device->recognized) {
+        return false;
+    }
+
+    if (!PINFO_FD_VISITED(pinfo) &&
+        ((device->id != (((guint32)usb_conv_info->deviceVendor << 16) | usb_conv_info->deviceProduct)) ||
+         (device->version != usb_conv_info->deviceVersion))) {
+        heur_device_insert(pinfo, usb_conv_info, false);
+        return false;
+    }
+
+    return true;
+}
+
+/* For adapters with other IDs (e.g., OEM-rebranded ones). A device is recognized by a bulk OUT packet starting with a
+ * valid header, which is checked without scanning the packet, and from then on all of its packets are dissected.
+ * Packets from before that frame aren't dissected on any pass, so the output is the same with one pass or two. */
+static gboolean dissect_t5_heur(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data) {
+    usb_conv_info_t * usb_conv_info = (usb_conv_info_t *)data;
+    if (!usb_conv_info) {
+        return false;
+    }
+
+    /* Devices with known IDs are already dissected through the usb.product table. */
+    if (value_is_in_range(&MCT_USB_PID_RANGE, ((guint32)usb_conv_info->deviceVendor << 16) | usb_conv_info->deviceProduct)) {
+        return false;
+    }
+
+    if (!heur_device_recognized(pinfo, usb_conv_info)) {
+        if (PINFO_FD_VISITED(pinfo)) {
+            return false;
+        }
+
+        uint8_t header_buf[MCT_T5_BULK_HEADER_LEN];
+        if ((usb_conv_info->transfer_type != URB_BULK) || (usb_conv_info->endpoint != 1) || usb_conv_info->direction ||
+            !bulk_header_copy(tvb, 0, header_buf) || !mct_t5_bulk_header_checksum_valid(header_buf)) {
+            return false;
+        }
+
+        heur_device_insert(pinfo, usb_conv_info, true);
+    }
+
+    return dissect_t5(tvb, pinfo, tree, data) > 0;
+}
+
 void proto_register_trigger5(void) {
     proto_register_subtree_array(ETT, array_length(ETT));
 
@@ -1017,14 +1383,34 @@ void proto_register_trigger5(void) {
     proto_register_field_array(PROTO_T5, HF_T5_CONTROL, array_length(HF_T5_CONTROL));
     proto_register_field_array(PROTO_T5, HF_T5_BULK, array_length(HF_T5_BULK));
     proto_register_field_array(PROTO_T5, HF_T5_BULK_FRAG, array_length(HF_T5_BULK_FRAG));
+    proto_register_field_array(PROTO_T5, HF_T5_INTERRUPT, array_length(HF_T5_INTERRUPT));
 
     expert_module_t * expert = expert_register_protocol(PROTO_T5);
     expert_register_field_array(expert, EI_T5_BULK, array_length(EI_T5_BULK));
 
+    HEUR_DEVICES = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+
+    module_t * t5_module = prefs_register_protocol(PROTO_T5, NULL);
+    prefs_register_bool_preference(t5_module, "resync", "Resynchronize after lost data",
+        "If a bulk packet doesn't start where the previous one says it should, scan for the next header with a valid "
+        "magic and checksum instead of giving up until the stream happens to line up again.",
+        &PREF_T5_RESYNC);
+    prefs_register_bool_preference(t5_module, "truncated_capture", "Capture has truncated bulk transfers",
+        "Don't try to reassemble fragmented bulk packets, and only track their sizes and timing. Use this for captures "
+        "where large bulk transfers were truncated (e.g., usbmon), where reassembly would fail anyway.",
+        &PREF_T5_TRUNCATED_CAPTURE);
+
     T5_HANDLE = register_dissector("trigger5", dissect_t5, PROTO_T5);
 }
 
 void proto_reg_handoff_trigger5(void) {
     dissector_add_uint_range("usb.product", (range_t *)&MCT_USB_PID_RANGE, T5_HANDLE);
     dissector_add_for_decode_as("usb.device", T5_HANDLE);
+
+    /* Once a device is recognized from its bulk stream, its control and interrupt packets are dissected as well. */
+    heur_dissector_add("usb.bulk", dissect_t5_heur, "MCT Trigger 5 over USB bulk", "trigger5_usb_bulk", PROTO_T5, HEURISTIC_ENABLE);
+    heur_dissector_add("usb.control", dissect_t5_heur, "MCT Trigger 5 over USB control", "trigger5_usb_control", PROTO_T5, HEURISTIC_ENABLE);
+    heur_dissector_add("usb.interrupt", dissect_t5_heur, "MCT Trigger 5 over USB interrupt", "trigger5_usb_interrupt", PROTO_T5, HEURISTIC_ENABLE);
+
+    EDID_HANDLE = find_dissector_add_dependency("mct_edid", PROTO_T5);
 }
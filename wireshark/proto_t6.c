@@ -18,13 +18,29 @@
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
+#include <inttypes.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
+#include <epan/crc32-tvb.h>
 #include <epan/dissectors/packet-usb.h>
+#include <epan/expert.h>
+#include <epan/export_object.h>
 #include <epan/packet.h>
+#include <epan/prefs.h>
 #include <epan/proto.h>
+#include <epan/range.h>
 #include <epan/reassemble.h>
-
+#include <wsutil/file_util.h>
+#include <wsutil/pint.h>
+#include <wsutil/report_message.h>
+
+#include "mct_edid.h"
+#include "mct_stats.h"
+#include "mct_t6.h"
+#include "proto_edid.h"
 #include "proto_t6.h"
 
 
@@ -39,37 +55,146 @@ typedef enum {
     FRAGMENT,
 } frame_type;
 
+/* Running totals of the bulk transfers sent in one session. bytes includes the selectors. */
+typedef struct session_counters_s {
+    uint64_t bytes;
+    uint64_t fragment_bytes;
+    uint32_t selectors;
+    uint32_t fragments;
+} session_counters_t;
+
 typedef struct selector_info_s {
     guint32 frame_num;
-    uint32_t session_num;
-    uint32_t payload_len;
-    uint32_t dest_addr;
-    uint32_t frag_len;
-    uint32_t frag_offset;
+    /* The frame of the first selector of the session payload this selector is part of. */
+    guint32 payload_start_frame_num;
+    mct_t6_selector_t selector;
+    /* The session's counters as of this selector (including it), and how many of the session's selectors so far
+     * were to the same destination address. */
+    session_counters_t session_counters;
+    uint32_t dest_addr_selectors;
 } selector_info_t;
 
 typedef struct frame_info_s {
+    guint32 frame_num;
     frame_type type;
-    selector_info_t * selector_info;
+    uint32_t selector_index;
     uint32_t payload_len_remaining;
     uint32_t frag_len_remaining;
 } frame_info_t;
 
+/* selectors_by_dest_addr counts the session's selectors by destination address. */
 typedef struct session_conv_info_s {
-    frame_info_t * last_frame;
+    uint32_t last_frame_index;
+    guint32 payload_start_frame_num;
+    session_counters_t counters;
+    wmem_map_t * selectors_by_dest_addr;
 } session_conv_info_t;
 
+/* Both arrays are only ever appended to on the first pass, which visits frames in order, so they're always sorted by
+ * frame number. Frames refer to their selector by index so each selector is only stored once. The stream state is
+ * likewise only advanced on the first pass. */
 typedef struct bulk_conv_info_s {
-    frame_info_t * last_frame;
     wmem_map_t * session_conv_info_by_session_num;
-    wmem_map_t * frame_info_by_frame_num;
+    wmem_array_t * selector_infos;
+    wmem_array_t * frame_infos;
+    mct_t6_bulk_state_t state;
 } bulk_conv_info_t;
 
+/* The supported modes (mct_t6_video_mode_t) of one video output, as returned by its last enumeration. frame_num is
+ * the frame of the first response of that enumeration. */
+typedef struct video_mode_table_s {
+    guint32 frame_num;
+    wmem_array_t * modes;
+} video_mode_table_t;
+
+/* The modes a "Get array of video modes" response added to its table. Tables are only ever appended to, so these stay
+ * valid after the output is enumerated again. */
+typedef struct video_modes_info_s {
+    video_mode_table_t * table;
+    guint first_index;
+    guint count;
+} video_modes_info_t;
+
+/* Total length (header plus pixel data) of the last cursor upload started for each cursor index, keyed by index, and
+ * the frame each distinct cursor image was first uploaded in, keyed by image hash. The hardware platform is keyed by
+ * the frame it was reported in, so each video mode is decoded with the platform reported before it, on any pass. The
+ * mode tables and the EDIDs being read are keyed by video output index, and are only updated on the first pass. */
+typedef struct control_conv_info_s {
+    wmem_map_t * cursor_upload_len_by_index;
+    wmem_map_t * cursor_first_frame_by_hash;
+    wmem_tree_t * hw_platform_by_frame;
+    wmem_map_t * video_mode_table_by_output;
+    wmem_map_t * edid_assembly_by_output;
+} control_conv_info_t;
+
+typedef struct cursor_image_info_s {
+    uint32_t hash;
+    guint32 duplicate_of;
+} cursor_image_info_t;
+
+/* An EDID completed by a "Get EDID block" response, along with the mode table of its output at the time. */
+typedef struct edid_info_s {
+    guint8 * data;
+    guint len;
+    video_mode_table_t * table;
+} edid_info_t;
+
+/* The decoded mode of a set video mode request, and where it was found in the output's mode table, resolved on the
+ * first pass. */
+typedef struct video_mode_set_info_s {
+    mct_t6_video_mode_t mode;
+    gint32 mode_index;
+    guint32 table_frame_num;
+} video_mode_set_info_t;
+
+/* An interrupt IN packet, along with the first bulk transfer and the first video frame that followed it, which are
+ * filled in on the first pass once they're seen. The bulk gap is the time from the last bulk transfer before the
+ * event to the first one after it. */
+typedef struct interrupt_info_s {
+    guint32 frame_num;
+    nstime_t ts;
+    mct_t6_interrupt_t interrupt;
+    guint32 next_bulk_frame_num;
+    bool have_bulk_gap;
+    nstime_t bulk_gap;
+    guint32 next_video_frame_num;
+    nstime_t video_delay;
+} interrupt_info_t;
+
+/* The interrupt infos (interrupt_info_t *) of one device in frame order, and the first of them that haven't been
+ * followed by a bulk transfer or a video frame yet. The interrupt and bulk endpoints are in different conversations,
+ * so these are keyed by device ID instead, and are only updated on the first pass. */
+typedef struct device_interrupt_info_s {
+    wmem_array_t * interrupt_infos;
+    guint first_pending_bulk;
+    guint first_pending_video;
+    bool have_last_bulk;
+    nstime_t last_bulk_ts;
+} device_interrupt_info_t;
+
+/* The interrupt events a bulk transfer was the first bulk transfer, or the first video frame, to follow. */
+typedef struct interrupt_follow_info_s {
+    wmem_array_t * interrupt_infos;
+    guint first_bulk_index;
+    guint bulk_count;
+    guint first_video_index;
+    guint video_count;
+} interrupt_follow_info_t;
+
 typedef struct bigger_range_s {
     guint nranges;
     range_admin_t ranges[2];
 } bigger_range_t;
 
+/* Keys for p_add_proto_data(). */
+#define PROTO_DATA_CURSOR_IMAGE_INFO 0
+#define PROTO_DATA_VIDEO_MODE_SET_INFO 1
+#define PROTO_DATA_VIDEO_MODES_INFO 2
+#define PROTO_DATA_EDID_INFO 3
+#define PROTO_DATA_INTERRUPT_INFO 4
+#define PROTO_DATA_INTERRUPT_FOLLOW_INFO 5
+#define PROTO_DATA_CURSOR_FRAGMENT_UNTRACKED 6
+
 static const uint32_t MCT_USB_VID = 0x0711;
 static const uint32_t INSIGNIA_USB_VID = 0x19FF;
 
@@ -88,7 +213,7 @@ static const value_string SESSIONS[] = {
     { 0, NULL },
 };
 
-#define INFO_FIELD_HW_PLAT 0
+#define INFO_FIELD_HW_PLAT MCT_T6_INFO_FIELD_HW_PLATFORM
 #define INFO_FIELD_BOOT_CODE 1
 #define INFO_FIELD_IMAGE_CODE 2
 #define INFO_FIELD_PROJECT_CODE 3
@@ -161,12 +286,65 @@ static const true_false_string tfs_sync_polarity = { "Positive", "Negative" };
 static const true_false_string tfs_timing = { "Customer", "Standard" };
 
 static dissector_handle_t T6_HANDLE = NULL;
+static dissector_handle_t JFIF_HANDLE = NULL;
+static dissector_handle_t EDID_HANDLE = NULL;
 
 static reassembly_table T6_REASSEMBLY_TABLE = { 0 };
 static reassembly_table T6_CONTROL_CURSOR_UPLOAD_REASSEMBLY_TABLE = { 0 };
 
 static int PROTO_T6 = -1;
 
+static int T6_EXPORT_OBJECT_TAP = -1;
+
+/* What's passed to the Export Objects tap for each reassembled firmware image. */
+typedef struct firmware_eo_info_s {
+    tvbuff_t * tvb;
+    const char * hostname;
+    const char * filename;
+} firmware_eo_info_t;
+
+static const char * PREF_VIDEO_EXPORT_DIR = NULL;
+
+/* Index of the frames written to PREF_VIDEO_EXPORT_DIR, open for the lifetime of the capture file. */
+static FILE * VIDEO_EXPORT_INDEX = NULL;
+
+static const char * PREF_AUDIO_EXPORT_FILE = NULL;
+static guint PREF_AUDIO_SAMPLE_RATE = 48000;
+
+static gboolean PREF_TRUNCATED_CAPTURE = false;
+
+static guint PREF_BULK_STALL_THRESHOLD_MS = 100;
+
+/* What the heuristic dissector knows about the device at an address from a given frame on. A device is recognized at
+ * one frame and all of its packets from then on are dissected as T6, on every pass, until a device with another
+ * identity shows up at the same address. */
+typedef struct heur_device_s {
+    gboolean recognized;
+    guint32 id;
+    guint16 version;
+} heur_device_t;
+
+/* wmem_tree_t of heur_device_t keyed by the frame they apply from, keyed by bus << 16 | address. */
+static wmem_map_t * HEUR_DEVICES = NULL;
+
+/* device_interrupt_info_t, keyed by device ID. */
+static wmem_map_t * DEVICE_INTERRUPT_INFOS = NULL;
+
+static const int AUDIO_CHANNELS = 2;
+static const int AUDIO_BYTES_PER_SAMPLE = 2;
+static const int WAV_HEADER_LEN = 44;
+
+/* WAV file a device's audio session is written to, open for the lifetime of the capture file. The header is rewritten
+ * with the final data length when the file is closed. */
+typedef struct audio_export_s {
+    FILE * file;
+    uint32_t data_len;
+} audio_export_t;
+
+/* audio_export_t, keyed by device ID. Only created when PREF_AUDIO_EXPORT_FILE is set, and devices whose file couldn't
+ * be opened map to an entry without one so the failure is only reported once. */
+static GHashTable * AUDIO_EXPORTS = NULL;
+
 static int HF_T6_CONTROL_REQ = -1;
 
 static int HF_T6_CONTROL_REQ_WVAL = -1;
@@ -180,11 +358,14 @@ static int HF_T6_CONTROL_REQ_CURSOR_IDX = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_ENABLE = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA_BYTE_OFFSET = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA = -1;
+static int HF_T6_CONTROL_REQ_CURSOR_DATA_FRAGMENT = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA_PIXEL_FORMAT = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA_WIDTH = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA_HEIGHT = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA_STRIDE = -1;
 static int HF_T6_CONTROL_REQ_CURSOR_DATA_PIXEL_DATA = -1;
+static int HF_T6_CONTROL_REQ_CURSOR_DATA_HASH = -1;
+static int HF_T6_CONTROL_REQ_CURSOR_DATA_DUPLICATE_OF = -1;
 
 static int HF_T6_CONTROL_REQ_VIDEO_CONN_IDX = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_OUTPUT_ENABLE = -1;
@@ -217,12 +398,16 @@ static int HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_IDIV = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL_X2_EN = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL_X4_EN = -1;
+static int HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_HW_PLAT = -1;
+static int HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_BASE_CLOCK_MHZ = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_HORIZONTAL_SYNC_POLARITY = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_VERTICAL_SYNC_POLARITY = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_REDUCED = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS_RESERVED = -1;
 static int HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS_TIMING = -1;
+static int HF_T6_CONTROL_REQ_VIDEO_MODE_INDEX = -1;
+static int HF_T6_CONTROL_REQ_VIDEO_MODE_TABLE_FRAME = -1;
 
 static int HF_T6_CONTROL_REQ_INFO_FIELD_IDX = -1;
 static int HF_T6_CONTROL_REQ_INFO_FIELD_HW_PLAT = -1;
@@ -242,6 +427,17 @@ static int HF_T6_CONTROL_REQ_CONF_INFO_SIZE = -1;
 static int HF_T6_CONTROL_REQ_CONF_INFO_VDEV_VID = -1;
 static int HF_T6_CONTROL_REQ_CONF_INFO_VDEV_PID = -1;
 static int HF_T6_CONTROL_REQ_CONF_INFO_VDEV_NAME = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UNKNOWN = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_DATA = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UHAL_CONFIG_USB2_START = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UHAL_CONFIG_USB3_START = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UHAL_BOS_START = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UHAL_UNK3_START = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UHAL_MANUFACTURER_START = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_UHAL_PRODUCT_START = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_AUD_VID = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_AUD_PID = -1;
+static int HF_T6_CONTROL_REQ_CONF_INFO_AUD_NAME = -1;
 
 static hf_register_info HF_T6_CONTROL[] = {
     { &HF_T6_CONTROL_REQ,
@@ -288,6 +484,10 @@ static hf_register_info HF_T6_CONTROL[] = {
         { "Cursor data", "trigger6.control.cursor_data",
         FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
     },
+    { &HF_T6_CONTROL_REQ_CURSOR_DATA_FRAGMENT,
+        { "Unreassembled cursor data fragment", "trigger6.control.cursor_data_fragment",
+        FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
     { &HF_T6_CONTROL_REQ_CURSOR_DATA_PIXEL_FORMAT,
         { "Pixel format", "trigger6.control.cursor_data.pixel_format",
         FT_UINT16, BASE_DEC, VALS(CURSOR_PIXEL_FORMATS), 0x0, NULL, HFILL }
@@ -308,6 +508,14 @@ static hf_register_info HF_T6_CONTROL[] = {
         { "Pixel data", "trigger6.control.cursor_data.pixel_data",
         FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
     },
+    { &HF_T6_CONTROL_REQ_CURSOR_DATA_HASH,
+        { "Cursor image hash", "trigger6.control.cursor_data.hash",
+        FT_UINT32, BASE_HEX, NULL, 0x0, "CRC-32 of the cursor header and pixel data", HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CURSOR_DATA_DUPLICATE_OF,
+        { "Duplicate of", "trigger6.control.cursor_data.duplicate_of",
+        FT_FRAMENUM, BASE_NONE, FRAMENUM_TYPE(FT_FRAMENUM_DUP_ACK), 0x0, "Frame the same cursor image was first uploaded in", HFILL }
+    },
     { &HF_T6_CONTROL_REQ_VIDEO_CONN_IDX,
         { "Video connector index", "trigger6.control.video_connector",
         FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }
@@ -412,6 +620,14 @@ static hf_register_info HF_T6_CONTROL[] = {
         { "x4 multiplier enabled", "trigger6.control.video_mode.pixel_clock_pll_config.mul.x4_en",
         FT_BOOLEAN, 8, NULL, 0x01, NULL, HFILL }
     },
+    { &HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_HW_PLAT,
+        { "Hardware Platform", "trigger6.control.video_mode.pixel_clock_pll_config.hw_plat",
+        FT_UINT32, BASE_HEX, VALS(HARDWARE_PLATFORMS), 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_BASE_CLOCK_MHZ,
+        { "Base clock (MHz)", "trigger6.control.video_mode.pixel_clock_pll_config.base_clock_mhz",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
     { &HF_T6_CONTROL_REQ_VIDEO_MODE_HORIZONTAL_SYNC_POLARITY,
         { "Horizontal sync polarity", "trigger6.control.video_mode.horizontal_sync_polarity",
         FT_BOOLEAN, BASE_NONE, TFS(&tfs_sync_polarity), 0x0, NULL, HFILL }
@@ -436,6 +652,14 @@ static hf_register_info HF_T6_CONTROL[] = {
         { "Timing", "trigger6.control.video_mode.flags.timing",
         FT_BOOLEAN, 8, TFS(&tfs_timing), 0x01, NULL, HFILL }
     },
+    { &HF_T6_CONTROL_REQ_VIDEO_MODE_INDEX,
+        { "Index into supported modes", "trigger6.control.video_mode.index",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_VIDEO_MODE_TABLE_FRAME,
+        { "Supported modes in", "trigger6.control.video_mode.table_frame",
+        FT_FRAMENUM, BASE_NONE, FRAMENUM_TYPE(FT_FRAMENUM_RESPONSE), 0x0, "First frame of the mode enumeration the mode was found in", HFILL }
+    },
     { &HF_T6_CONTROL_REQ_INFO_FIELD_IDX,
         { "Info field", "trigger6.control.info_field.index",
         FT_UINT16, BASE_HEX, VALS(INFO_FIELDS), 0x0, NULL, HFILL }
@@ -500,6 +724,50 @@ static hf_register_info HF_T6_CONTROL[] = {
         { "Virtual device name", "trigger6.control.conf_info.disp.name",
         FT_STRINGZ, BASE_NONE, NULL, 0x0, NULL, HFILL }
     },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UNKNOWN,
+        { "Unknown", "trigger6.control.conf_info.unknown",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_DATA,
+        { "Configuration data", "trigger6.control.conf_info.data",
+        FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UHAL_CONFIG_USB2_START,
+        { "USB 2.0 configuration descriptor offset", "trigger6.control.conf_info.uhal.config_usb2_start",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UHAL_CONFIG_USB3_START,
+        { "USB 3.0 configuration descriptor offset", "trigger6.control.conf_info.uhal.config_usb3_start",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UHAL_BOS_START,
+        { "Binary object store descriptor offset", "trigger6.control.conf_info.uhal.bos_start",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UHAL_UNK3_START,
+        { "Unknown descriptor offset", "trigger6.control.conf_info.uhal.unk3_start",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UHAL_MANUFACTURER_START,
+        { "Manufacturer string descriptor offset", "trigger6.control.conf_info.uhal.manufacturer_start",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_UHAL_PRODUCT_START,
+        { "Product string descriptor offset", "trigger6.control.conf_info.uhal.product_start",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_AUD_VID,
+        { "Audio device vendor ID", "trigger6.control.conf_info.aud.vid",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_AUD_PID,
+        { "Audio device product ID", "trigger6.control.conf_info.aud.pid",
+        FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_CONTROL_REQ_CONF_INFO_AUD_NAME,
+        { "Audio device name", "trigger6.control.conf_info.aud.name",
+        FT_STRINGZ, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
 };
 
 static int HF_T6_BULK_SESSION_SELECTOR = -1;
@@ -509,6 +777,23 @@ static int HF_T6_BULK_SESSION_PAYLOAD_DEST_ADDR = -1;
 static int HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_LENGTH = -1;
 static int HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_OFFSET = -1;
 static int HF_T6_BULK_SESSION_PAYLOAD_DATA = -1;
+static int HF_T6_BULK_FRAME_LATENCY = -1;
+static int HF_T6_BULK_SESSION_BYTES = -1;
+static int HF_T6_BULK_SESSION_SELECTORS = -1;
+static int HF_T6_BULK_SESSION_FRAGMENTS = -1;
+static int HF_T6_BULK_SESSION_AVG_FRAGMENT_LEN = -1;
+static int HF_T6_BULK_SESSION_DEST_ADDR_SELECTORS = -1;
+
+static int HF_T6_BULK_VIDEO_HEADER = -1;
+static int HF_T6_BULK_VIDEO_PACKET_TYPE = -1;
+static int HF_T6_BULK_VIDEO_DATA_LEN = -1;
+static int HF_T6_BULK_VIDEO_SEQ = -1;
+static int HF_T6_BULK_VIDEO_UNK_0C = -1;
+static int HF_T6_BULK_VIDEO_WIDTH = -1;
+static int HF_T6_BULK_VIDEO_HEIGHT = -1;
+static int HF_T6_BULK_VIDEO_LUMA_ADDR = -1;
+static int HF_T6_BULK_VIDEO_CHROMA_ADDR = -1;
+static int HF_T6_BULK_VIDEO_UNKNOWN = -1;
 
 static hf_register_info HF_T6_BULK[] = {
     { &HF_T6_BULK_SESSION_SELECTOR,
@@ -539,6 +824,288 @@ static hf_register_info HF_T6_BULK[] = {
         { "Session payload data", "trigger6.bulk.session.payload.data",
         FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
     },
+    { &HF_T6_BULK_FRAME_LATENCY,
+        { "Frame latency", "trigger6.bulk.frame_latency",
+        FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0,
+        "Time from the submission of the video payload's first selector to the completion of its last fragment", HFILL }
+    },
+    { &HF_T6_BULK_SESSION_BYTES,
+        { "Session bytes so far", "trigger6.bulk.session.stats.bytes",
+        FT_UINT64, BASE_DEC, NULL, 0x0,
+        "Bulk bytes sent in this session up to and including this selector, including the selectors", HFILL }
+    },
+    { &HF_T6_BULK_SESSION_SELECTORS,
+        { "Session selectors so far", "trigger6.bulk.session.stats.selectors",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_SESSION_FRAGMENTS,
+        { "Session fragments so far", "trigger6.bulk.session.stats.fragments",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_SESSION_AVG_FRAGMENT_LEN,
+        { "Session average fragment length", "trigger6.bulk.session.stats.avg_frag_len",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_SESSION_DEST_ADDR_SELECTORS,
+        { "Session selectors to this destination address so far", "trigger6.bulk.session.stats.dest_addr_selectors",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_HEADER,
+        { "Video packet header", "trigger6.bulk.video.header",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_PACKET_TYPE,
+        { "Packet type?", "trigger6.bulk.video.type",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_DATA_LEN,
+        { "Data length", "trigger6.bulk.video.data_len",
+        FT_UINT32, BASE_DEC_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_SEQ,
+        { "Sequence counter", "trigger6.bulk.video.seq",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_UNK_0C,
+        { "Unknown", "trigger6.bulk.video.unk_0c",
+        FT_UINT32, BASE_DEC_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_WIDTH,
+        { "Width or chroma stride", "trigger6.bulk.video.width",
+        FT_UINT16, BASE_DEC, NULL, 0x0,
+        "The JPEG width for type 7 packets, and the stride of the framebuffer's chroma plane for full frames", HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_HEIGHT,
+        { "Height or luma stride", "trigger6.bulk.video.height",
+        FT_UINT16, BASE_DEC, NULL, 0x0,
+        "The JPEG height for type 7 packets, and the stride of the framebuffer's luma plane for full frames", HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_LUMA_ADDR,
+        { "Luma plane address", "trigger6.bulk.video.luma_addr",
+        FT_UINT32, BASE_HEX, NULL, 0x0, "For full frames, where the frame is decoded to in the video RAM", HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_CHROMA_ADDR,
+        { "Chroma plane address", "trigger6.bulk.video.chroma_addr",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_VIDEO_UNKNOWN,
+        { "Unknown", "trigger6.bulk.video.unknown",
+        FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+};
+
+static int HF_T6_FIRMWARE_IMAGE = -1;
+static int HF_T6_FIRMWARE_MAGIC = -1;
+static int HF_T6_FIRMWARE_LEN = -1;
+static int HF_T6_FIRMWARE_CRC = -1;
+static int HF_T6_FIRMWARE_UNK_0C = -1;
+static int HF_T6_FIRMWARE_UNK_10 = -1;
+static int HF_T6_FIRMWARE_IMAGE_CODE_VERSION = -1;
+static int HF_T6_FIRMWARE_CODE_OFFSET = -1;
+static int HF_T6_FIRMWARE_CODE_LEN = -1;
+static int HF_T6_FIRMWARE_CODE = -1;
+static int HF_T6_FIRMWARE_CONFIG_OFFSET = -1;
+static int HF_T6_FIRMWARE_PROJECT_CODE = -1;
+static int HF_T6_FIRMWARE_UNK_60 = -1;
+static int HF_T6_FIRMWARE_CONFIG = -1;
+
+static hf_register_info HF_T6_FIRMWARE[] = {
+    { &HF_T6_FIRMWARE_IMAGE,
+        { "Firmware image", "trigger6.firmware",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_MAGIC,
+        { "Magic", "trigger6.firmware.magic",
+        FT_STRING, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_LEN,
+        { "Image length", "trigger6.firmware.len",
+        FT_UINT32, BASE_DEC_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_CRC,
+        { "CRC?", "trigger6.firmware.crc",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_UNK_0C,
+        { "Unknown", "trigger6.firmware.unk_0c",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_UNK_10,
+        { "Unknown", "trigger6.firmware.unk_10",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_IMAGE_CODE_VERSION,
+        { "Image code version", "trigger6.firmware.image_code_version",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_CODE_OFFSET,
+        { "Firmware offset", "trigger6.firmware.code.offset",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_CODE_LEN,
+        { "Firmware length", "trigger6.firmware.code.len",
+        FT_UINT32, BASE_DEC_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_CODE,
+        { "Firmware", "trigger6.firmware.code",
+        FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_CONFIG_OFFSET,
+        { "Configuration offset", "trigger6.firmware.config_offset",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_PROJECT_CODE,
+        { "Project code", "trigger6.firmware.project_code",
+        FT_STRINGZ, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_UNK_60,
+        { "Unknown", "trigger6.firmware.unk_60",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_FIRMWARE_CONFIG,
+        { "Configuration", "trigger6.firmware.config",
+        FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+};
+
+static int HF_T6_INTERRUPT_TYPE = -1;
+static int HF_T6_INTERRUPT_TYPE_STATUS_CHANGE = -1;
+static int HF_T6_INTERRUPT_TYPE_CURRENT_STATE = -1;
+static int HF_T6_INTERRUPT_TYPE_FIRMWARE_UPDATE_STATUS = -1;
+static int HF_T6_INTERRUPT_COUNTER = -1;
+static int HF_T6_INTERRUPT_CHANGE_FLAGS = -1;
+static int HF_T6_INTERRUPT_CHANGE_CONNECTOR_0 = -1;
+static int HF_T6_INTERRUPT_CHANGE_CONNECTOR_1 = -1;
+static int HF_T6_INTERRUPT_CHANGE_UNKNOWN_26 = -1;
+static int HF_T6_INTERRUPT_STATE_FLAGS = -1;
+static int HF_T6_INTERRUPT_STATE_CONNECTOR_0_CONNECTED = -1;
+static int HF_T6_INTERRUPT_STATE_CONNECTOR_1_CONNECTED = -1;
+static int HF_T6_INTERRUPT_FIRMWARE_UPDATE_STATUS = -1;
+static int HF_T6_INTERRUPT_FIRMWARE_UPDATE_PROGRESS = -1;
+static int HF_T6_INTERRUPT_UNKNOWN = -1;
+static int HF_T6_INTERRUPT_NEXT_BULK = -1;
+static int HF_T6_INTERRUPT_BULK_GAP = -1;
+static int HF_T6_INTERRUPT_NEXT_VIDEO_FRAME = -1;
+static int HF_T6_INTERRUPT_VIDEO_DELAY = -1;
+static int HF_T6_BULK_INTERRUPT_EVENT = -1;
+static int HF_T6_BULK_INTERRUPT_VIDEO_EVENT = -1;
+static int HF_T6_BULK_INTERRUPT_DELAY = -1;
+static int HF_T6_BULK_INTERRUPT_BULK_GAP = -1;
+
+static hf_register_info HF_T6_INTERRUPT[] = {
+    { &HF_T6_INTERRUPT_TYPE,
+        { "Packet type?", "trigger6.interrupt.type",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_TYPE_STATUS_CHANGE,
+        { "Status change?", "trigger6.interrupt.type.status_change",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_TYPE_STATUS_CHANGE, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_TYPE_CURRENT_STATE,
+        { "Current state?", "trigger6.interrupt.type.current_state",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_TYPE_CURRENT_STATE, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_TYPE_FIRMWARE_UPDATE_STATUS,
+        { "Firmware update status?", "trigger6.interrupt.type.firmware_update_status",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_TYPE_FIRMWARE_UPDATE_STATUS, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_COUNTER,
+        { "Packet counter?", "trigger6.interrupt.counter",
+        FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_CHANGE_FLAGS,
+        { "Change flags?", "trigger6.interrupt.change_flags",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_CHANGE_CONNECTOR_0,
+        { "Connector 0 status change", "trigger6.interrupt.change_flags.connector_0",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_CHANGE_CONNECTOR_0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_CHANGE_CONNECTOR_1,
+        { "Connector 1 status change", "trigger6.interrupt.change_flags.connector_1",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_CHANGE_CONNECTOR_1, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_CHANGE_UNKNOWN_26,
+        { "Unknown", "trigger6.interrupt.change_flags.unknown_26",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_CHANGE_UNKNOWN_26, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_STATE_FLAGS,
+        { "State flags?", "trigger6.interrupt.state_flags",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_STATE_CONNECTOR_0_CONNECTED,
+        { "Connector 0 connected", "trigger6.interrupt.state_flags.connector_0",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_STATE_CONNECTOR_0_CONNECTED, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_STATE_CONNECTOR_1_CONNECTED,
+        { "Connector 1 connected", "trigger6.interrupt.state_flags.connector_1",
+        FT_BOOLEAN, 32, NULL, MCT_T6_INTERRUPT_STATE_CONNECTOR_1_CONNECTED, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_FIRMWARE_UPDATE_STATUS,
+        { "Firmware update status?", "trigger6.interrupt.firmware_update_status",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_FIRMWARE_UPDATE_PROGRESS,
+        { "Firmware update progress?", "trigger6.interrupt.firmware_update_progress",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_UNKNOWN,
+        { "Unknown", "trigger6.interrupt.unknown",
+        FT_UINT32, BASE_HEX, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_NEXT_BULK,
+        { "Next bulk transfer in", "trigger6.interrupt.next_bulk_in",
+        FT_FRAMENUM, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_BULK_GAP,
+        { "Bulk gap across event", "trigger6.interrupt.bulk_gap",
+        FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0,
+        "Time from the last bulk transfer before this event to the first one after it", HFILL }
+    },
+    { &HF_T6_INTERRUPT_NEXT_VIDEO_FRAME,
+        { "Next video frame in", "trigger6.interrupt.next_video_frame_in",
+        FT_FRAMENUM, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_INTERRUPT_VIDEO_DELAY,
+        { "Time to next video frame", "trigger6.interrupt.video_delay",
+        FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_INTERRUPT_EVENT,
+        { "First bulk transfer after interrupt event in", "trigger6.bulk.interrupt.event_in",
+        FT_FRAMENUM, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_INTERRUPT_VIDEO_EVENT,
+        { "First video frame after interrupt event in", "trigger6.bulk.interrupt.video_event_in",
+        FT_FRAMENUM, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_INTERRUPT_DELAY,
+        { "Time since interrupt event", "trigger6.bulk.interrupt.delay",
+        FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0, NULL, HFILL }
+    },
+    { &HF_T6_BULK_INTERRUPT_BULK_GAP,
+        { "Bulk gap across interrupt event", "trigger6.bulk.interrupt.bulk_gap",
+        FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0,
+        "Time from the last bulk transfer before the interrupt event to this one", HFILL }
+    },
+};
+
+static expert_field EI_T6_INTERRUPT_LEN_INVALID = EI_INIT;
+static expert_field EI_T6_BULK_STALL = EI_INIT;
+static expert_field EI_T6_BULK_VIDEO_DATA_LEN_INVALID = EI_INIT;
+
+static ei_register_info EI_T6[] = {
+    { &EI_T6_INTERRUPT_LEN_INVALID,
+        { "trigger6.interrupt.len_invalid", PI_MALFORMED, PI_ERROR,
+            "Interrupt packet isn't 64 bytes long", EXPFILL }
+    },
+    { &EI_T6_BULK_STALL,
+        { "trigger6.bulk.interrupt.stall", PI_SEQUENCE, PI_WARN,
+            "Bulk stream stalled across an interrupt event", EXPFILL }
+    },
+    { &EI_T6_BULK_VIDEO_DATA_LEN_INVALID,
+        { "trigger6.bulk.video.data_len_invalid", PI_MALFORMED, PI_WARN,
+            "Video data length doesn't match the rest of the session payload", EXPFILL }
+    },
 };
 
 static int HF_T6_CONTROL_CURSOR_UPLOAD_FRAGMENTS = -1;
@@ -689,29 +1256,6 @@ static hf_register_info HF_T6_BULK_FRAG[] = {
     },
 };
 
-typedef struct field_sizes_s {
-    int * hf;
-    int size;
-} field_sizes_t;
-
-static const field_sizes_t video_mode_fields[] = {
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_PIXEL_CLK_KHZ, 4 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_REFRESH_RATE_HZ, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_TOTAL_PIXELS, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_ACTIVE_PIXELS, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_ACTIVE_PLUS_FRONT_PORCH_PIXELS, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_SYNC_WIDTH, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_TOTAL_LINES, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_ACTIVE_LINES, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_ACTIVE_PLUS_FRONT_PORCH_LINES, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_SYNC_WIDTH, 2 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG, 6 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_HORIZONTAL_SYNC_POLARITY, 1 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_VERTICAL_SYNC_POLARITY, 1 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_REDUCED, 1 },
-    { &HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS, 1 },
-};
-
 static int ETT_T6 = -1;
 static int ETT_T6_VIDEO_MODES = -1;
 static int ETT_T6_VIDEO_MODE = -1;
@@ -719,6 +1263,9 @@ static int ETT_T6_VIDEO_MODE_PLL_CONFIG = -1;
 static int ETT_T6_VIDEO_MODE_PLL_CONFIG_MUL = -1;
 static int ETT_T6_VIDEO_MODE_FLAGS = -1;
 static int ETT_T6_CURSOR_DATA = -1;
+static int ETT_T6_VIDEO_HEADER = -1;
+static int ETT_T6_FIRMWARE = -1;
+static int ETT_T6_FIRMWARE_CONFIG = -1;
 static int * const ETT[] = {
     &ETT_T6,
     &ETT_T6_VIDEO_MODES,
@@ -727,35 +1274,239 @@ static int * const ETT[] = {
     &ETT_T6_VIDEO_MODE_PLL_CONFIG_MUL,
     &ETT_T6_VIDEO_MODE_FLAGS,
     &ETT_T6_CURSOR_DATA,
+    &ETT_T6_VIDEO_HEADER,
+    &ETT_T6_FIRMWARE,
+    &ETT_T6_FIRMWARE_CONFIG,
     &ETT_T6_CONTROL_CURSOR_UPLOAD_FRAGMENT,
     &ETT_T6_CONTROL_CURSOR_UPLOAD_FRAGMENTS,
     &ETT_T6_BULK_FRAGMENT,
     &ETT_T6_BULK_FRAGMENTS,
 };
 
-static void dissect_cursor_upload(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, uint16_t cursor_index, uint16_t cursor_data_byte_offset) {
+static control_conv_info_t * get_control_conv_info(packet_info *pinfo) {
+    conversation_t * conversation = find_or_create_conversation(pinfo);
+    control_conv_info_t * control_conv_info = (control_conv_info_t *)conversation_get_proto_data(conversation, PROTO_T6);
+    if (!control_conv_info) {
+        control_conv_info = wmem_new(wmem_file_scope(), control_conv_info_t);
+        control_conv_info->cursor_upload_len_by_index = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+        control_conv_info->cursor_first_frame_by_hash = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+        control_conv_info->hw_platform_by_frame = wmem_tree_new(wmem_file_scope());
+        control_conv_info->video_mode_table_by_output = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+        control_conv_info->edid_assembly_by_output = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+
+        conversation_add_proto_data(conversation, PROTO_T6, control_conv_info);
+    }
+
+    return control_conv_info;
+}
+
+/* Remembers the hardware platform from an INFO_FIELD_HW_PLAT response, since it sets the PLL base clock. */
+static void record_hw_platform(tvbuff_t *tvb, packet_info *pinfo) {
+    if (PINFO_FD_VISITED(pinfo) || (tvb_captured_length(tvb) < 4)) {
+        return;
+    }
+
+    guint32 * hw_platform = wmem_new(wmem_file_scope(), guint32);
+    *hw_platform = tvb_get_letohl(tvb, 0);
+    wmem_tree_insert32(get_control_conv_info(pinfo)->hw_platform_by_frame, pinfo->num, hw_platform);
+}
+
+/* Returns the hardware platform reported at or before the current frame, or NULL if it hasn't been seen. */
+static const guint32 * lookup_hw_platform(packet_info *pinfo) {
+    return (const guint32 *)wmem_tree_lookup32_le(get_control_conv_info(pinfo)->hw_platform_by_frame, pinfo->num);
+}
+
+/* Adds a "Get EDID block" response to the EDID being read from the output, and remembers the whole EDID in the frame
+ * that completes it. */
+static void record_edid_block(tvbuff_t *tvb, packet_info *pinfo, uint16_t output_index, uint16_t byte_offset) {
+    if (PINFO_FD_VISITED(pinfo) || (tvb_captured_length(tvb) < MCT_EDID_BLOCK_LEN) || (byte_offset % MCT_EDID_BLOCK_LEN)) {
+        return;
+    }
+
+    control_conv_info_t * control_conv_info = get_control_conv_info(pinfo);
+    mct_edid_assembly_t * assembly = (mct_edid_assembly_t *)wmem_map_lookup(control_conv_info->edid_assembly_by_output, GUINT_TO_POINTER(output_index));
+    if (!assembly) {
+        assembly = wmem_new(wmem_file_scope(), mct_edid_assembly_t);
+        mct_edid_assembly_reset(assembly);
+        wmem_map_insert(control_conv_info->edid_assembly_by_output, GUINT_TO_POINTER(output_index), assembly);
+    }
+
+    size_t len = mct_edid_assembly_add_block(assembly, byte_offset / MCT_EDID_BLOCK_LEN, tvb_get_ptr(tvb, 0, MCT_EDID_BLOCK_LEN));
+    if (len == 0) {
+        return;
+    }
+
+    edid_info_t * edid_info = wmem_new(wmem_file_scope(), edid_info_t);
+    edid_info->data = (guint8 *)wmem_memdup(wmem_file_scope(), assembly->data, len);
+    edid_info->len = len;
+    edid_info->table = (video_mode_table_t *)wmem_map_lookup(control_conv_info->video_mode_table_by_output, GUINT_TO_POINTER(output_index));
+    p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_EDID_INFO, edid_info);
+}
+
+static void dissect_edid(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo) {
+    const edid_info_t * edid_info = (const edid_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_EDID_INFO);
+    if (!edid_info) {
+        return;
+    }
+
+    tvbuff_t * edid_tvb = tvb_new_child_real_data(tvb, edid_info->data, edid_info->len, edid_info->len);
+    add_new_data_source(pinfo, edid_tvb, "Reassembled EDID");
+
+    edid_adapter_modes_t adapter_modes = { 0 };
+    if (edid_info->table) {
+        const mct_t6_video_mode_t * modes = (const mct_t6_video_mode_t *)wmem_array_get_raw(edid_info->table->modes);
+        adapter_modes.count = wmem_array_get_count(edid_info->table->modes);
+        adapter_modes.table_frame_num = edid_info->table->frame_num;
+
+        edid_adapter_mode_t * adapter_mode_list = wmem_alloc_array(pinfo->pool, edid_adapter_mode_t, adapter_modes.count);
+        for (guint i = 0; i < adapter_modes.count; i++) {
+            adapter_mode_list[i].width = modes[i].line_active_pixels;
+            adapter_mode_list[i].height = modes[i].frame_active_lines;
+            adapter_mode_list[i].refresh_rate_hz = modes[i].refresh_rate_hz;
+            adapter_mode_list[i].pixel_clock_khz = modes[i].pixel_clock_khz;
+        }
+        adapter_modes.modes = adapter_mode_list;
+    }
+
+    call_dissector_with_data(EDID_HANDLE, edid_tvb, pinfo, tree, edid_info->table ? &adapter_modes : NULL);
+}
+
+static void decode_video_mode(tvbuff_t *tvb, int offset, mct_t6_video_mode_t *mode) {
+    uint8_t mode_buf[MCT_T6_VIDEO_MODE_LEN];
+    tvb_memcpy(tvb, mode_buf, offset, MCT_T6_VIDEO_MODE_LEN);
+    mct_t6_video_mode_parse(mode_buf, mode);
+}
+
+/* Decodes the modes in a response to "Get array of video modes" and adds them to the output's mode table. A response
+ * for byte offset 0 starts a new enumeration, and responses that don't continue the current one are ignored. Returns
+ * the decoded modes of this response, or NULL if they weren't cached. */
+static const video_modes_info_t * cache_video_modes(tvbuff_t *tvb, packet_info *pinfo, uint16_t output_index, uint16_t byte_offset) {
+    video_modes_info_t * modes_info = (video_modes_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_VIDEO_MODES_INFO);
+    if (modes_info || PINFO_FD_VISITED(pinfo)) {
+        return modes_info;
+    }
+
+    control_conv_info_t * control_conv_info = get_control_conv_info(pinfo);
+    video_mode_table_t * table = NULL;
+    if (byte_offset == 0) {
+        table = wmem_new(wmem_file_scope(), video_mode_table_t);
+        table->frame_num = pinfo->num;
+        table->modes = wmem_array_sized_new(wmem_file_scope(), sizeof(mct_t6_video_mode_t), 64);
+        wmem_map_insert(control_conv_info->video_mode_table_by_output, GUINT_TO_POINTER(output_index), table);
+    } else {
+        table = (video_mode_table_t *)wmem_map_lookup(control_conv_info->video_mode_table_by_output, GUINT_TO_POINTER(output_index));
+        if (!table || (byte_offset != wmem_array_get_count(table->modes) * MCT_T6_VIDEO_MODE_LEN)) {
+            return NULL;
+        }
+    }
+
+    modes_info = wmem_new(wmem_file_scope(), video_modes_info_t);
+    modes_info->table = table;
+    modes_info->first_index = wmem_array_get_count(table->modes);
+    modes_info->count = tvb_captured_length(tvb) / MCT_T6_VIDEO_MODE_LEN;
+
+    for (guint i = 0; i < modes_info->count; i++) {
+        mct_t6_video_mode_t mode;
+        decode_video_mode(tvb, i * MCT_T6_VIDEO_MODE_LEN, &mode);
+        wmem_array_append_one(table->modes, mode);
+    }
+
+    p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_VIDEO_MODES_INFO, modes_info);
+
+    return modes_info;
+}
+
+/* Finds the mode of a set video mode request in the output's mode table, and queues it for the mode change tap. */
+static const video_mode_set_info_t * resolve_video_mode_set(tvbuff_t *tvb, packet_info *pinfo, usb_conv_info_t *usb_conv_info, uint16_t output_index) {
+    if (tvb_captured_length(tvb) < MCT_T6_VIDEO_MODE_LEN) {
+        return NULL;
+    }
+
+    video_mode_set_info_t * set_info = (video_mode_set_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_VIDEO_MODE_SET_INFO);
+    if (!set_info && !PINFO_FD_VISITED(pinfo)) {
+        set_info = wmem_new0(wmem_file_scope(), video_mode_set_info_t);
+        decode_video_mode(tvb, 0, &set_info->mode);
+        set_info->mode_index = -1;
+
+        video_mode_table_t * table = (video_mode_table_t *)wmem_map_lookup(get_control_conv_info(pinfo)->video_mode_table_by_output, GUINT_TO_POINTER(output_index));
+        if (table) {
+            const mct_t6_video_mode_t * modes = (const mct_t6_video_mode_t *)wmem_array_get_raw(table->modes);
+            guint count = wmem_array_get_count(table->modes);
+            for (guint i = 0; i < count; i++) {
+                if (mct_t6_video_mode_same_timing(&set_info->mode, &modes[i])) {
+                    set_info->mode_index = i;
+                    set_info->table_frame_num = table->frame_num;
+                    break;
+                }
+            }
+        }
+
+        p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_VIDEO_MODE_SET_INFO, set_info);
+    }
+
+    if (set_info && mct_stats_mode_tap_wanted()) {
+        mct_mode_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_mode_tap_info_t);
+        tap_info->device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+        tap_info->output_index = output_index;
+        tap_info->mode_index = set_info->mode_index;
+        tap_info->mode = &set_info->mode;
+        mct_stats_mode_tap_queue(pinfo, tap_info);
+    }
+
+    return set_info;
+}
+
+static void dissect_cursor_upload(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, usb_conv_info_t *usb_conv_info, uint16_t cursor_index, uint16_t cursor_data_byte_offset) {
     tvbuff_t * next_tvb = NULL;
 
+    control_conv_info_t * control_conv_info = get_control_conv_info(pinfo);
+
     gboolean initial_and_fragmented = false;
+    uint32_t total_cursor_bytes = 0;
     if (cursor_data_byte_offset == 0) {
-        uint16_t height = tvb_get_letohs(tvb, 4);
-        uint16_t pitch = tvb_get_letohs(tvb, 6);
-        uint32_t total_cursor_bytes = height * pitch;
-        if (total_cursor_bytes > tvb_captured_length(tvb)) {
-            initial_and_fragmented = true;
+        /* Without the header the upload's length is unknown, so a truncated initial request is dissected on its own.
+         * Its length is still recorded (as zero) so any later fragments aren't matched to an earlier upload. */
+        if (tvb_captured_length(tvb) >= MCT_T6_CURSOR_HEADER_LEN) {
+            uint16_t height = tvb_get_letohs(tvb, 4);
+            uint16_t pitch = tvb_get_letohs(tvb, 6);
+            total_cursor_bytes = MCT_T6_CURSOR_HEADER_LEN + (uint32_t)height * pitch;
+            if (total_cursor_bytes > tvb_captured_length(tvb)) {
+                initial_and_fragmented = true;
+            }
         }
+
+        if (!PINFO_FD_VISITED(pinfo)) {
+            wmem_map_insert(control_conv_info->cursor_upload_len_by_index, GUINT_TO_POINTER(cursor_index), GUINT_TO_POINTER(total_cursor_bytes));
+        }
+    } else {
+        total_cursor_bytes = GPOINTER_TO_UINT(wmem_map_lookup(control_conv_info->cursor_upload_len_by_index, GUINT_TO_POINTER(cursor_index)));
+    }
+
+    /* The initial request (or its header) wasn't captured, so the upload's length is unknown and the fragments could
+     * never be reassembled. They're shown on their own instead of being added to the reassembly table, where they'd be
+     * kept until the file is closed. The tracked length may have changed by the time a later pass gets here, so the
+     * first pass's decision is kept with the packet. */
+    gboolean untracked_fragment;
+    if (!PINFO_FD_VISITED(pinfo)) {
+        untracked_fragment = (cursor_data_byte_offset > 0) && (total_cursor_bytes == 0);
+        if (untracked_fragment) {
+            p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_CURSOR_FRAGMENT_UNTRACKED, GUINT_TO_POINTER(true));
+        }
+    } else {
+        untracked_fragment = p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_CURSOR_FRAGMENT_UNTRACKED) != NULL;
     }
 
-    if (initial_and_fragmented || (cursor_data_byte_offset > 0)) {
+    if (untracked_fragment) {
+        pinfo->fragmented = true;
+        col_append_fstr(pinfo->cinfo, COL_INFO, " (Fragment offset %u)", cursor_data_byte_offset);
+        proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CURSOR_DATA_FRAGMENT, tvb, 0, -1, ENC_NA);
+    } else if (initial_and_fragmented || (cursor_data_byte_offset > 0)) {
         /* Fragmented */
         pinfo->fragmented = true;
 
-        /* TODO: Keep track of the initial cursor upload requests and the number of bytes remaining to upload, then use
-         * that value to determine if more fragments are needed.
-         *
-         * For now, just assume that if the payload size is not exactly 512 bytes (a full packet) the cursor data is
-         * fragmented. */
-        gboolean more_frags = tvb_captured_length(tvb) == 512;
+        /* The upload is complete once the initial request's header plus pixel data has been sent. The tracked length
+         * only matters on the first pass, since the reassembly table remembers the result after that. */
+        gboolean more_frags = (cursor_data_byte_offset + tvb_reported_length(tvb)) < total_cursor_bytes;
 
         fragment_head * frag_head = fragment_add_check(&T6_CONTROL_CURSOR_UPLOAD_REASSEMBLY_TABLE,
             tvb, 0, pinfo, cursor_index, NULL,
@@ -775,7 +1526,33 @@ static void dissect_cursor_upload(proto_tree *tree, tvbuff_t *tvb, packet_info *
         next_tvb = tvb;
     }
 
-    if (next_tvb) {
+    cursor_image_info_t * image_info = NULL;
+    if (next_tvb && (tvb_captured_length(next_tvb) == tvb_reported_length(next_tvb))) {
+        image_info = (cursor_image_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_CURSOR_IMAGE_INFO);
+        if (!image_info && !PINFO_FD_VISITED(pinfo)) {
+            image_info = wmem_new0(wmem_file_scope(), cursor_image_info_t);
+            image_info->hash = crc32_ccitt_tvb(next_tvb, tvb_captured_length(next_tvb));
+
+            guint32 first_frame = GPOINTER_TO_UINT(wmem_map_lookup(control_conv_info->cursor_first_frame_by_hash, GUINT_TO_POINTER(image_info->hash)));
+            if (first_frame) {
+                image_info->duplicate_of = first_frame;
+            } else {
+                wmem_map_insert(control_conv_info->cursor_first_frame_by_hash, GUINT_TO_POINTER(image_info->hash), GUINT_TO_POINTER(pinfo->num));
+            }
+
+            p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_CURSOR_IMAGE_INFO, image_info);
+        }
+    }
+
+    if (image_info && mct_stats_cursor_tap_wanted()) {
+        mct_cursor_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_cursor_tap_info_t);
+        tap_info->device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+        tap_info->upload_bytes = tvb_reported_length(next_tvb);
+        tap_info->duplicate = image_info->duplicate_of != 0;
+        mct_stats_cursor_tap_queue(pinfo, tap_info);
+    }
+
+    if (next_tvb && tree) {
         proto_item * cursor_data_item = proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CURSOR_DATA, next_tvb, 0, -1, ENC_NA);
         proto_tree * cursor_data_tree = proto_item_add_subtree(cursor_data_item, ETT_T6_CURSOR_DATA);
         proto_tree_add_item(cursor_data_tree, HF_T6_CONTROL_REQ_CURSOR_DATA_PIXEL_FORMAT, next_tvb, 0, 2, ENC_LITTLE_ENDIAN);
@@ -783,50 +1560,43 @@ static void dissect_cursor_upload(proto_tree *tree, tvbuff_t *tvb, packet_info *
         proto_tree_add_item(cursor_data_tree, HF_T6_CONTROL_REQ_CURSOR_DATA_HEIGHT, next_tvb, 4, 2, ENC_LITTLE_ENDIAN);
         proto_tree_add_item(cursor_data_tree, HF_T6_CONTROL_REQ_CURSOR_DATA_STRIDE, next_tvb, 6, 2, ENC_LITTLE_ENDIAN);
         proto_tree_add_item(cursor_data_tree, HF_T6_CONTROL_REQ_CURSOR_DATA_PIXEL_DATA, next_tvb, 8, -1, ENC_LITTLE_ENDIAN);
+
+        if (image_info) {
+            proto_item_set_generated(proto_tree_add_uint(cursor_data_tree, HF_T6_CONTROL_REQ_CURSOR_DATA_HASH, next_tvb, 0, 0, image_info->hash));
+            if (image_info->duplicate_of) {
+                proto_item_set_generated(proto_tree_add_uint(cursor_data_tree, HF_T6_CONTROL_REQ_CURSOR_DATA_DUPLICATE_OF, next_tvb, 0, 0, image_info->duplicate_of));
+            }
+        }
     }
 }
 
-static double dissect_pll_config(proto_item *item, tvbuff_t *tvb) {
-    double pll_freq_khz = 0;
-
+static uint32_t dissect_pll_config(proto_item *item, tvbuff_t *tvb, const mct_t6_pll_config_t *pll_config, const guint32 *hw_platform) {
     proto_tree * item_tree = proto_item_add_subtree(item, ETT_T6_VIDEO_MODE_PLL_CONFIG);
 
-    uint32_t fnum = 0;
-    proto_tree_add_item_ret_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_FNUM, tvb, 0, 2, ENC_LITTLE_ENDIAN, &fnum);
-
-    uint32_t fden = 0;
-    proto_tree_add_item_ret_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_FDEN, tvb, 2, 2, ENC_LITTLE_ENDIAN, &fden);
-
-    uint32_t idiv = 0;
-    proto_tree_add_item_ret_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_IDIV, tvb, 4, 1, ENC_LITTLE_ENDIAN, &idiv);
+    proto_tree_add_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_FNUM, tvb, 0, 2, pll_config->fnum);
+    proto_tree_add_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_FDEN, tvb, 2, 2, pll_config->fden);
+    proto_tree_add_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_IDIV, tvb, 4, 1, pll_config->idiv);
 
     proto_item * mul2_item = proto_tree_add_item(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL, tvb, 5, 1, ENC_NA);
     proto_tree * mul2_tree = proto_item_add_subtree(mul2_item, ETT_T6_VIDEO_MODE_PLL_CONFIG_MUL);
+    proto_tree_add_item(mul2_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL_X2_EN, tvb, 5, 1, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(mul2_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL_X4_EN, tvb, 5, 1, ENC_LITTLE_ENDIAN);
+    proto_item_append_text(mul2_item, ": %d", mct_t6_pll_mul(pll_config));
 
-    gboolean x2_en = false;
-    proto_tree_add_item_ret_boolean(mul2_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL_X2_EN, tvb, 5, 1, ENC_LITTLE_ENDIAN, &x2_en);
-
-    gboolean x4_en = false;
-    proto_tree_add_item_ret_boolean(mul2_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_MUL_X4_EN, tvb, 5, 1, ENC_LITTLE_ENDIAN, &x4_en);
-
-    uint32_t mul = 1;
-
-    if (x2_en) {
-        mul *= 2;
+    uint32_t base_clock_mhz = mct_t6_pll_base_clock_mhz(hw_platform ? *hw_platform : MCT_T6_HW_PLATFORM_SUPER_LITE);
+    if (hw_platform) {
+        proto_item_set_generated(proto_tree_add_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_HW_PLAT, tvb, 0, 0, *hw_platform));
     }
-
-    if (x4_en) {
-        mul *= 4;
+    proto_item * base_clock_item = proto_tree_add_uint(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG_BASE_CLOCK_MHZ, tvb, 0, 0, base_clock_mhz);
+    proto_item_set_generated(base_clock_item);
+    if (!hw_platform) {
+        proto_item_append_text(base_clock_item, " (hardware platform not captured, assuming Super Lite)");
     }
 
-    proto_item_append_text(mul2_item, ": %d", mul);
-
-    /* TODO: Replace "40" with base clock MHz value based on parsed hardware platform value (Lite: 48 MHz, Super Lite:
-     * 40 MHz). Pass through args from main dissector function? */
-    pll_freq_khz = ((fnum + fden * idiv) * mul * 40) / 32.0;
+    double pll_freq_khz = mct_t6_pll_freq_khz(pll_config, base_clock_mhz);
     proto_item_append_text(item, ": %.5g MHz", pll_freq_khz/1e3);
 
-    return pll_freq_khz;
+    return base_clock_mhz;
 }
 
 static void dissect_video_mode_flags(proto_item *item, tvbuff_t *tvb) {
@@ -835,41 +1605,391 @@ static void dissect_video_mode_flags(proto_item *item, tvbuff_t *tvb) {
     proto_tree_add_item(item_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS_TIMING, tvb, 0, 1, ENC_LITTLE_ENDIAN);
 }
 
-static void dissect_video_mode(proto_tree *tree, tvbuff_t *tvb) {
-    proto_item * video_mode_item = proto_tree_add_item(tree, HF_T6_CONTROL_REQ_VIDEO_MODE, tvb, 0, 32, ENC_NA);
+/* Adds an already-decoded video mode to the tree. The offsets are the ones mct_t6_video_mode_parse() reads from. */
+static proto_tree * dissect_video_mode(proto_tree *tree, tvbuff_t *tvb, const mct_t6_video_mode_t *mode, const guint32 *hw_platform) {
+    proto_item * video_mode_item = proto_tree_add_item(tree, HF_T6_CONTROL_REQ_VIDEO_MODE, tvb, 0, MCT_T6_VIDEO_MODE_LEN, ENC_NA);
     proto_tree * video_mode_tree = proto_item_add_subtree(video_mode_item, ETT_T6_VIDEO_MODE);
 
-    uint32_t refresh_rate_hz_reported = 0;
-    uint32_t clocks_per_frame = 1;
-    uint32_t h_res = 0;
-    uint32_t v_res = 0;
-    double pll_freq_khz = 0;
-
-    int field_offset = 0;
-    for (int i = 0; i < array_length(video_mode_fields); i++) {
-        proto_item * item = proto_tree_add_item(video_mode_tree, *video_mode_fields[i].hf, tvb, field_offset, video_mode_fields[i].size, ENC_LITTLE_ENDIAN);
-
-        if (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_REFRESH_RATE_HZ) {
-            refresh_rate_hz_reported = tvb_get_letohs(tvb, field_offset);
-        } else if (
-            (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_TOTAL_PIXELS) ||
-            (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_TOTAL_LINES)) {
-            clocks_per_frame *= tvb_get_letohs(tvb, field_offset);
-        } else if (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_ACTIVE_PIXELS) {
-            h_res = tvb_get_letohs(tvb, field_offset);
-        } else if (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_ACTIVE_LINES) {
-            v_res = tvb_get_letohs(tvb, field_offset);
-        } else if (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG) {
-            pll_freq_khz = dissect_pll_config(item, tvb_new_subset_length(tvb, field_offset, 6));
-        } else if (video_mode_fields[i].hf == &HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS) {
-            dissect_video_mode_flags(item, tvb_new_subset_length(tvb, field_offset, 1));
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PIXEL_CLK_KHZ, tvb, 0, 4, mode->pixel_clock_khz);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_REFRESH_RATE_HZ, tvb, 4, 2, mode->refresh_rate_hz);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_TOTAL_PIXELS, tvb, 6, 2, mode->line_total_pixels);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_ACTIVE_PIXELS, tvb, 8, 2, mode->line_active_pixels);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_ACTIVE_PLUS_FRONT_PORCH_PIXELS, tvb, 10, 2, mode->line_active_plus_front_porch_pixels);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_LINE_SYNC_WIDTH, tvb, 12, 2, mode->line_sync_width);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_TOTAL_LINES, tvb, 14, 2, mode->frame_total_lines);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_ACTIVE_LINES, tvb, 16, 2, mode->frame_active_lines);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_ACTIVE_PLUS_FRONT_PORCH_LINES, tvb, 18, 2, mode->frame_active_plus_front_porch_lines);
+    proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_FRAME_SYNC_WIDTH, tvb, 20, 2, mode->frame_sync_width);
+
+    proto_item * pll_config_item = proto_tree_add_item(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_PLL_CONFIG, tvb, MCT_T6_VIDEO_MODE_PLL_CONFIG_OFFSET, MCT_T6_PLL_CONFIG_LEN, ENC_NA);
+    uint32_t base_clock_mhz = dissect_pll_config(pll_config_item, tvb_new_subset_length(tvb, MCT_T6_VIDEO_MODE_PLL_CONFIG_OFFSET, MCT_T6_PLL_CONFIG_LEN), &mode->pll_config, hw_platform);
+
+    proto_tree_add_boolean(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_HORIZONTAL_SYNC_POLARITY, tvb, 28, 1, mode->horizontal_sync_polarity);
+    proto_tree_add_boolean(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_VERTICAL_SYNC_POLARITY, tvb, 29, 1, mode->vertical_sync_polarity);
+    proto_tree_add_boolean(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_REDUCED, tvb, 30, 1, mode->reduced);
+
+    proto_item * flags_item = proto_tree_add_item(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_FLAGS, tvb, 31, 1, ENC_NA);
+    dissect_video_mode_flags(flags_item, tvb_new_subset_length(tvb, 31, 1));
+
+    proto_item_append_text(video_mode_item, ": %d x %d @ %d Hz (%.5g Hz)", mode->line_active_pixels, mode->frame_active_lines,
+        mode->refresh_rate_hz, mct_t6_video_mode_refresh_rate_hz(mode, base_clock_mhz));
+
+    return video_mode_tree;
+}
+
+/* Packet type 7 carries a JPEG with its dimensions in the header, while full frames (type 4) have the strides of the
+ * framebuffer they're decoded into there instead. */
+#define VIDEO_PACKET_TYPE_SIZED_JPEG 7
+
+static void dissect_video_packet(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree) {
+    proto_item * header_item = proto_tree_add_item(tree, HF_T6_BULK_VIDEO_HEADER, tvb, 0, MCT_T6_VIDEO_HEADER_LEN, ENC_NA);
+    proto_tree * header_tree = proto_item_add_subtree(header_item, ETT_T6_VIDEO_HEADER);
+
+    uint32_t packet_type = 0;
+    uint32_t data_len = 0;
+    uint32_t seq = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    proto_tree_add_item_ret_uint(header_tree, HF_T6_BULK_VIDEO_PACKET_TYPE, tvb, 0, 4, ENC_LITTLE_ENDIAN, &packet_type);
+    proto_item * data_len_item = proto_tree_add_item_ret_uint(header_tree, HF_T6_BULK_VIDEO_DATA_LEN, tvb, 4, 4,
+        ENC_LITTLE_ENDIAN, &data_len);
+    proto_tree_add_item_ret_uint(header_tree, HF_T6_BULK_VIDEO_SEQ, tvb, 8, 4, ENC_LITTLE_ENDIAN, &seq);
+    proto_tree_add_item(header_tree, HF_T6_BULK_VIDEO_UNK_0C, tvb, 12, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item_ret_uint(header_tree, HF_T6_BULK_VIDEO_WIDTH, tvb, 16, 2, ENC_LITTLE_ENDIAN, &width);
+    proto_tree_add_item_ret_uint(header_tree, HF_T6_BULK_VIDEO_HEIGHT, tvb, 18, 2, ENC_LITTLE_ENDIAN, &height);
+    proto_tree_add_item(header_tree, HF_T6_BULK_VIDEO_LUMA_ADDR, tvb, 20, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(header_tree, HF_T6_BULK_VIDEO_CHROMA_ADDR, tvb, 24, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(header_tree, HF_T6_BULK_VIDEO_UNKNOWN, tvb, 28, MCT_T6_VIDEO_HEADER_LEN - 28, ENC_NA);
+
+    if (packet_type == VIDEO_PACKET_TYPE_SIZED_JPEG) {
+        proto_item_append_text(header_item, ": Seq %u, %u x %u, %u bytes", seq, width, height, data_len);
+    } else {
+        proto_item_append_text(header_item, ": Seq %u, strides %u/%u, %u bytes", seq, width, height, data_len);
+    }
+
+    uint32_t remaining = tvb_reported_length_remaining(tvb, MCT_T6_VIDEO_HEADER_LEN);
+    if (data_len != remaining) {
+        expert_add_info_format(pinfo, data_len_item, &EI_T6_BULK_VIDEO_DATA_LEN_INVALID,
+            "Video data length is %u bytes, but %u bytes follow the header", data_len, remaining);
+        if (data_len > remaining) {
+            data_len = remaining;
+        }
+    }
+
+    if (!tvb_bytes_exist(tvb, MCT_T6_VIDEO_HEADER_LEN, 2) || (tvb_get_ntohs(tvb, MCT_T6_VIDEO_HEADER_LEN) != 0xFFD8)) {
+        /* Not a JPEG, probably a raw framebuffer update. */
+        proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_DATA, tvb, MCT_T6_VIDEO_HEADER_LEN, -1, ENC_NA);
+        return;
+    }
+
+    tvbuff_t * jpeg_tvb = tvb_new_subset_length(tvb, MCT_T6_VIDEO_HEADER_LEN, data_len);
+    call_dissector(JFIF_HANDLE, jpeg_tvb, pinfo, tree);
+}
+
+/* The configs returned by CONTROL_REQ_B3 have the same layout as the ones in the firmware image. Only as much as the
+ * tvb holds is decoded, since the driver doesn't always read a whole config. */
+static void dissect_config(proto_tree *tree, tvbuff_t *tvb) {
+    uint32_t conf_type = 0;
+    proto_tree_add_item_ret_uint(tree, HF_T6_CONTROL_REQ_CONF_INFO_TYPE, tvb, 0, 4, ENC_LITTLE_ENDIAN, &conf_type);
+    proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_SIZE, tvb, 4, 4, ENC_LITTLE_ENDIAN);
+    if (!tvb_bytes_exist(tvb, MCT_T6_IMG_CONFIG_HEADER_LEN, 1)) {
+        return;
+    }
+    proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UNKNOWN, tvb, 8, 4, ENC_LITTLE_ENDIAN);
+
+    switch (conf_type) {
+        case CONF_TYPE_UHAL:
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UHAL_CONFIG_USB2_START, tvb, 12, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UHAL_CONFIG_USB3_START, tvb, 14, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UHAL_BOS_START, tvb, 16, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UHAL_UNK3_START, tvb, 18, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UHAL_MANUFACTURER_START, tvb, 20, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_UHAL_PRODUCT_START, tvb, 22, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_DATA, tvb, 24, -1, ENC_NA);
+            break;
+        case CONF_TYPE_DISP:
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_VDEV_VID, tvb, 12, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_VDEV_PID, tvb, 14, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_VDEV_NAME, tvb, 16, 64, ENC_UTF_16 | ENC_LITTLE_ENDIAN);
+            if (tvb_bytes_exist(tvb, 112, MCT_T6_VIDEO_MODE_LEN)) {
+                /* The default modes of the virtual display, in the same format as the ones read from the adapter. */
+                proto_item * video_modes_item = proto_tree_add_item(tree, HF_T6_CONTROL_REQ_VIDEO_MODES_DATA, tvb, 112, -1, ENC_NA);
+                proto_tree * video_modes_tree = proto_item_add_subtree(video_modes_item, ETT_T6_VIDEO_MODES);
+                for (int offset = 112; tvb_bytes_exist(tvb, offset, MCT_T6_VIDEO_MODE_LEN); offset += MCT_T6_VIDEO_MODE_LEN) {
+                    tvbuff_t * mode_tvb = tvb_new_subset_length(tvb, offset, MCT_T6_VIDEO_MODE_LEN);
+                    mct_t6_video_mode_t mode;
+                    decode_video_mode(mode_tvb, 0, &mode);
+                    dissect_video_mode(video_modes_tree, mode_tvb, &mode, NULL);
+                }
+            }
+            break;
+        case CONF_TYPE_AUD_:
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_AUD_VID, tvb, 12, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_AUD_PID, tvb, 14, 2, ENC_LITTLE_ENDIAN);
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_AUD_NAME, tvb, 16, 64, ENC_UTF_16 | ENC_LITTLE_ENDIAN);
+            break;
+        default:
+            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_DATA, tvb, 12, -1, ENC_NA);
+            break;
+    }
+}
+
+/* Returns a name for the exported image made from its project code and version, with anything that doesn't belong in
+ * a file name replaced. */
+static const char * firmware_image_filename(packet_info *pinfo, const mct_t6_img_header_t *header) {
+    char * filename = wmem_strdup_printf(pinfo->pool, "%s-%08x.t6img", header->project_code[0] ? header->project_code : "firmware",
+        header->image_code_version);
+    for (char * c = filename; *c; c++) {
+        if (!g_ascii_isalnum(*c) && (*c != '-') && (*c != '_') && (*c != '.')) {
+            *c = '_';
+        }
+    }
+    return filename;
+}
+
+/* The image is decoded straight out of the reassembled payload: the firmware blob and configs are subsets of it, and
+ * Export Objects gets the tvb itself, so nothing is copied unless the image is actually exported. */
+static void dissect_firmware_image(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_conv_info_t *usb_conv_info) {
+    if (!tvb_bytes_exist(tvb, 0, MCT_T6_IMG_HEADER_LEN) || !mct_t6_img_magic_valid(tvb_get_ptr(tvb, 0, 4), 4)) {
+        proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_DATA, tvb, 0, -1, ENC_NA);
+        return;
+    }
+
+    mct_t6_img_header_t header;
+    mct_t6_img_header_parse(tvb_get_ptr(tvb, 0, MCT_T6_IMG_HEADER_LEN), &header);
+
+    if (have_tap_listener(T6_EXPORT_OBJECT_TAP)) {
+        firmware_eo_info_t * eo_info = wmem_new(pinfo->pool, firmware_eo_info_t);
+        eo_info->tvb = tvb;
+        eo_info->hostname = wmem_strdup_printf(pinfo->pool, "%u.%u", usb_conv_info->bus_id, usb_conv_info->device_address);
+        eo_info->filename = firmware_image_filename(pinfo, &header);
+        tap_queue_packet(T6_EXPORT_OBJECT_TAP, pinfo, eo_info);
+    }
+
+    if (!tree) {
+        return;
+    }
+
+    proto_item * image_item = proto_tree_add_item(tree, HF_T6_FIRMWARE_IMAGE, tvb, 0, -1, ENC_NA);
+    proto_tree * image_tree = proto_item_add_subtree(image_item, ETT_T6_FIRMWARE);
+    proto_item_append_text(image_item, ": %s, version 0x%08x", header.project_code, header.image_code_version);
+
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_MAGIC, tvb, 0, 4, ENC_ASCII);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_LEN, tvb, 4, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_CRC, tvb, 8, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_UNK_0C, tvb, 12, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_UNK_10, tvb, 16, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_IMAGE_CODE_VERSION, tvb, 20, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_CODE_OFFSET, tvb, 24, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_CODE_LEN, tvb, 28, 4, ENC_LITTLE_ENDIAN);
+    if (tvb_bytes_exist(tvb, header.firmware_offset, header.firmware_len)) {
+        proto_tree_add_item(image_tree, HF_T6_FIRMWARE_CODE, tvb, header.firmware_offset, header.firmware_len, ENC_NA);
+    }
+
+    for (int i = 0; i < MCT_T6_IMG_CONFIG_COUNT; i++) {
+        proto_tree_add_item(image_tree, HF_T6_FIRMWARE_CONFIG_OFFSET, tvb, MCT_T6_IMG_CONFIG_OFFSETS_OFFSET + 4 * i, 4, ENC_LITTLE_ENDIAN);
+    }
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_PROJECT_CODE, tvb, MCT_T6_IMG_PROJECT_CODE_OFFSET, MCT_T6_IMG_PROJECT_CODE_LEN, ENC_ASCII);
+    proto_tree_add_item(image_tree, HF_T6_FIRMWARE_UNK_60, tvb, 96, 4, ENC_LITTLE_ENDIAN);
+
+    for (int i = 0; i < MCT_T6_IMG_CONFIG_COUNT; i++) {
+        uint32_t config_offset = header.config_offsets[i];
+        if ((config_offset == 0) || !tvb_bytes_exist(tvb, config_offset, MCT_T6_IMG_CONFIG_HEADER_LEN)) {
+            continue;
         }
 
-        field_offset += video_mode_fields[i].size;
+        mct_t6_img_config_header_t config_header;
+        mct_t6_img_config_header_parse(tvb_get_ptr(tvb, config_offset, MCT_T6_IMG_CONFIG_HEADER_LEN), &config_header);
+        gint config_len = MIN(config_header.len, (guint)tvb_captured_length_remaining(tvb, config_offset));
+
+        tvbuff_t * config_tvb = tvb_new_subset_length(tvb, config_offset, config_len);
+        proto_item * config_item = proto_tree_add_item(image_tree, HF_T6_FIRMWARE_CONFIG, config_tvb, 0, -1, ENC_NA);
+        proto_tree * config_tree = proto_item_add_subtree(config_item, ETT_T6_FIRMWARE_CONFIG);
+        proto_item_append_text(config_item, " %d: %s", i, config_header.type);
+        dissect_config(config_tree, config_tvb);
     }
+}
+
+static tap_packet_status firmware_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags) {
+    export_object_list_t * object_list = (export_object_list_t *)tapdata;
+    const firmware_eo_info_t * eo_info = (const firmware_eo_info_t *)data;
 
-    double refresh_rate_hz_actual = (pll_freq_khz*1e3) / clocks_per_frame;
-    proto_item_append_text(video_mode_item, ": %d x %d @ %d Hz (%.5g Hz)", h_res, v_res, refresh_rate_hz_reported, refresh_rate_hz_actual);
+    export_object_entry_t * entry = g_new0(export_object_entry_t, 1);
+    entry->pkt_num = pinfo->num;
+    entry->hostname = g_strdup(eo_info->hostname);
+    entry->content_type = g_strdup("application/octet-stream");
+    entry->filename = g_strdup(eo_info->filename);
+    entry->payload_len = tvb_captured_length(eo_info->tvb);
+    entry->payload_data = (guint8 *)tvb_memdup(NULL, eo_info->tvb, 0, entry->payload_len);
+
+    object_list->add_entry(object_list->gui_data, entry);
+
+    return TAP_PACKET_REDRAW;
+}
+
+static gboolean jpeg_get_dimensions(tvbuff_t *tvb, int offset, uint16_t *width, uint16_t *height) {
+    /* Skip the SOI marker, then walk the marker segments until we hit a start-of-frame. */
+    offset += 2;
+    while (tvb_bytes_exist(tvb, offset, 4)) {
+        uint8_t marker_prefix = tvb_get_guint8(tvb, offset);
+        uint8_t marker = tvb_get_guint8(tvb, offset + 1);
+        if (marker_prefix != 0xFF) {
+            return false;
+        }
+
+        if ((marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) && (marker != 0xC8) && (marker != 0xCC)) {
+            if (!tvb_bytes_exist(tvb, offset + 5, 4)) {
+                return false;
+            }
+            *height = tvb_get_ntohs(tvb, offset + 5);
+            *width = tvb_get_ntohs(tvb, offset + 7);
+            return true;
+        }
+
+        if ((marker == 0xD9) || (marker == 0xDA)) {
+            /* End of image or start of scan without a frame header. */
+            return false;
+        }
+
+        offset += 2 + tvb_get_ntohs(tvb, offset + 2);
+    }
+
+    return false;
+}
+
+static void export_video_frame(tvbuff_t *tvb, packet_info *pinfo) {
+    if (!tvb_bytes_exist(tvb, 0, MCT_T6_VIDEO_HEADER_LEN + 2)) {
+        return;
+    }
+
+    uint32_t jpeg_len = tvb_get_letohl(tvb, 4);
+    uint32_t seq = tvb_get_letohl(tvb, 8);
+
+    /* Packet type 3 is sometimes used for raw framebuffer updates, so check for the SOI marker instead of relying on
+     * the type field. */
+    if ((tvb_get_ntohs(tvb, MCT_T6_VIDEO_HEADER_LEN) != 0xFFD8) || !tvb_bytes_exist(tvb, MCT_T6_VIDEO_HEADER_LEN, jpeg_len)) {
+        return;
+    }
+
+    /* Only type 7 packets have the image dimensions in the header, full frames have the framebuffer strides there
+     * instead, so take them from the JPEG itself. */
+    uint16_t width = 0;
+    uint16_t height = 0;
+    jpeg_get_dimensions(tvb, MCT_T6_VIDEO_HEADER_LEN, &width, &height);
+
+    gchar * filename = wmem_strdup_printf(pinfo->pool, "frame-%08u.jpg", pinfo->num);
+    gchar * path = g_build_filename(PREF_VIDEO_EXPORT_DIR, filename, NULL);
+    FILE * jpeg_file = ws_fopen(path, "wb");
+    if (!jpeg_file) {
+        report_open_failure(path, errno, true);
+        g_free(path);
+        return;
+    }
+
+    size_t written = fwrite(tvb_get_ptr(tvb, MCT_T6_VIDEO_HEADER_LEN, jpeg_len), 1, jpeg_len, jpeg_file);
+    bool closed = fclose(jpeg_file) == 0;
+    if ((written != jpeg_len) || !closed) {
+        /* Leave the frame out of the index so it never points at a truncated file. */
+        report_failure("Only %zu of %u bytes of video frame %u could be written to \"%s\".", written, jpeg_len,
+            pinfo->num, path);
+        g_free(path);
+        return;
+    }
+    g_free(path);
+
+    fprintf(VIDEO_EXPORT_INDEX, "%u,%u,%" PRId64 ".%09d,%u,%u,%u,%s\n", pinfo->num, seq,
+        (int64_t)pinfo->abs_ts.secs, pinfo->abs_ts.nsecs, width, height, jpeg_len, filename);
+}
+
+static void write_wav_header(FILE *file, uint32_t data_len) {
+    uint32_t block_align = AUDIO_CHANNELS * AUDIO_BYTES_PER_SAMPLE;
+    uint8_t header[WAV_HEADER_LEN];
+
+    memcpy(&header[0], "RIFF", 4);
+    phtoles32(&header[4], WAV_HEADER_LEN - 8 + data_len);
+    memcpy(&header[8], "WAVE", 4);
+    memcpy(&header[12], "fmt ", 4);
+    phtoles32(&header[16], 16);
+    phtoles16(&header[20], 1); /* PCM */
+    phtoles16(&header[22], AUDIO_CHANNELS);
+    phtoles32(&header[24], PREF_AUDIO_SAMPLE_RATE);
+    phtoles32(&header[28], PREF_AUDIO_SAMPLE_RATE * block_align);
+    phtoles16(&header[32], block_align);
+    phtoles16(&header[34], AUDIO_BYTES_PER_SAMPLE * 8);
+    memcpy(&header[36], "data", 4);
+    phtoles32(&header[40], data_len);
+
+    fseek(file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), file);
+}
+
+static void audio_export_free(gpointer data) {
+    audio_export_t * audio_export = (audio_export_t *)data;
+    if (audio_export->file) {
+        write_wav_header(audio_export->file, audio_export->data_len);
+        fclose(audio_export->file);
+    }
+    g_free(audio_export);
+}
+
+/* Each device gets its own file, named after PREF_AUDIO_EXPORT_FILE with the bus and device address inserted before
+ * the extension, e.g. "audio.wav" becomes "audio-bus1-dev5.wav". */
+static gchar * audio_export_path(uint32_t device_id) {
+    gchar * dirname = g_path_get_dirname(PREF_AUDIO_EXPORT_FILE);
+    gchar * basename = g_path_get_basename(PREF_AUDIO_EXPORT_FILE);
+    const char * extension = "";
+    char * dot = strrchr(basename, '.');
+    if (dot && (dot != basename)) {
+        *dot = '\0';
+        extension = dot + 1;
+    }
+
+    gchar * filename = g_strdup_printf("%s-bus%u-dev%u%s%s", basename, device_id >> 16, device_id & 0xFFFF,
+        extension[0] ? "." : "", extension);
+    gchar * path = g_build_filename(dirname, filename, NULL);
+
+    g_free(filename);
+    g_free(basename);
+    g_free(dirname);
+    return path;
+}
+
+static void export_audio_chunk(tvbuff_t *tvb, uint32_t device_id) {
+    audio_export_t * audio_export = (audio_export_t *)g_hash_table_lookup(AUDIO_EXPORTS, GUINT_TO_POINTER(device_id));
+    if (!audio_export) {
+        audio_export = g_new0(audio_export_t, 1);
+        gchar * path = audio_export_path(device_id);
+        audio_export->file = ws_fopen(path, "wb");
+        if (audio_export->file) {
+            write_wav_header(audio_export->file, 0);
+        } else {
+            report_open_failure(path, errno, true);
+        }
+        g_free(path);
+        g_hash_table_insert(AUDIO_EXPORTS, GUINT_TO_POINTER(device_id), audio_export);
+    }
+
+    if (!audio_export->file) {
+        return;
+    }
+
+    /* Chunks that weren't captured in full are padded with silence, so the rest of the stream stays in sync. */
+    uint32_t captured_len = tvb_captured_length(tvb);
+    uint32_t len = tvb_reported_length(tvb);
+    if (fwrite(tvb_get_ptr(tvb, 0, captured_len), 1, captured_len, audio_export->file) != captured_len) {
+        return;
+    }
+    audio_export->data_len += captured_len;
+
+    static const uint8_t silence[256] = { 0 };
+    while (captured_len < len) {
+        uint32_t pad_len = MIN(len - captured_len, (uint32_t)sizeof(silence));
+        if (fwrite(silence, 1, pad_len, audio_export->file) != pad_len) {
+            return;
+        }
+        audio_export->data_len += pad_len;
+        captured_len += pad_len;
+    }
 }
 
 static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_conv_info_t *usb_conv_info) {
@@ -885,6 +2005,24 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
         return 0;
     }
 
+    if (!tree) {
+        /* Cursor uploads and EDIDs (for reassembly), the hardware platform (for the PLL base clock), and the video mode
+         * tables and mode changes are the only control requests that need any state tracking, so skip everything else
+         * if the tree isn't going to be shown. */
+        if (!in_not_out && setup_not_completion && (bRequest == CONTROL_REQ_10)) {
+            dissect_cursor_upload(tree, tvb_new_subset_remaining(tvb, CTRL_SETUP_DATA_OFFSET), pinfo, usb_conv_info, wValue, wIndex);
+        } else if (!in_not_out && setup_not_completion && (bRequest == CONTROL_REQ_12)) {
+            resolve_video_mode_set(tvb_new_subset_length(tvb, CTRL_SETUP_DATA_OFFSET, MCT_T6_VIDEO_MODE_LEN), pinfo, usb_conv_info, wValue);
+        } else if (in_not_out && !setup_not_completion && (bRequest == CONTROL_REQ_89)) {
+            cache_video_modes(tvb, pinfo, wValue, wIndex);
+        } else if (in_not_out && !setup_not_completion && (bRequest == CONTROL_REQ_80)) {
+            record_edid_block(tvb, pinfo, wIndex, wValue);
+        } else if (in_not_out && !setup_not_completion && (bRequest == CONTROL_REQ_B0) && (wIndex == INFO_FIELD_HW_PLAT)) {
+            record_hw_platform(tvb, pinfo);
+        }
+        return tvb_captured_length(tvb);
+    }
+
 #define DISSECT_CONTROL_REQ_SETUP_FIELD(HFINDEX, OFFSET, LENGTH, FIELD)                 \
     if (setup_not_completion) {                                                         \
         proto_tree_add_item(tree, HFINDEX, tvb, OFFSET, LENGTH, ENC_LITTLE_ENDIAN);     \
@@ -967,10 +2105,24 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
         // printf("CONTROL OUT: 0x%02x\n", bRequest);
         switch (bRequest) {
             case CONTROL_REQ_10:
-                dissect_cursor_upload(tree, tvb_new_subset_remaining(tvb, CTRL_SETUP_DATA_OFFSET), pinfo, wValue, wIndex);
+                dissect_cursor_upload(tree, tvb_new_subset_remaining(tvb, CTRL_SETUP_DATA_OFFSET), pinfo, usb_conv_info, wValue, wIndex);
                 break;
             case CONTROL_REQ_12:
-                dissect_video_mode(tree, tvb_new_subset_length(tvb, CTRL_SETUP_DATA_OFFSET, 32));
+                {
+                    tvbuff_t * mode_tvb = tvb_new_subset_length(tvb, CTRL_SETUP_DATA_OFFSET, MCT_T6_VIDEO_MODE_LEN);
+                    const video_mode_set_info_t * set_info = resolve_video_mode_set(mode_tvb, pinfo, usb_conv_info, wValue);
+                    mct_t6_video_mode_t mode;
+                    if (set_info) {
+                        mode = set_info->mode;
+                    } else {
+                        decode_video_mode(mode_tvb, 0, &mode);
+                    }
+                    proto_tree * video_mode_tree = dissect_video_mode(tree, mode_tvb, &mode, lookup_hw_platform(pinfo));
+                    if (set_info && (set_info->mode_index >= 0)) {
+                        proto_item_set_generated(proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_INDEX, mode_tvb, 0, 0, set_info->mode_index));
+                        proto_item_set_generated(proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_TABLE_FRAME, mode_tvb, 0, 0, set_info->table_frame_num));
+                    }
+                }
                 break;
             default:
                 if (tvb_captured_length(tvb) > CTRL_SETUP_DATA_OFFSET) {
@@ -983,6 +2135,8 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
         switch (bRequest) {
             case CONTROL_REQ_80:
                 proto_tree_add_item(tree, HF_T6_CONTROL_REQ_EDID_BLOCK_DATA, tvb, 0, 128, ENC_NA);
+                record_edid_block(tvb, pinfo, wIndex, wValue);
+                dissect_edid(tree, tvb, pinfo);
                 break;
             case CONTROL_REQ_87:
                 proto_tree_add_item(tree, HF_T6_CONTROL_REQ_VIDEO_CONNECTOR_STATUS, tvb, 0, 1, ENC_LITTLE_ENDIAN);
@@ -994,8 +2148,19 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
                 {
                     proto_item * video_modes_item = proto_tree_add_item(tree, HF_T6_CONTROL_REQ_VIDEO_MODES_DATA, tvb, 0, -1, ENC_NA);
                     proto_tree * video_modes_tree = proto_item_add_subtree(video_modes_item, ETT_T6_VIDEO_MODES);
-                    for (int offset = 0; offset < tvb_reported_length(tvb); offset += 32) {
-                        dissect_video_mode(video_modes_tree, tvb_new_subset_length(tvb, offset, 32));
+                    const guint32 * hw_platform = lookup_hw_platform(pinfo);
+                    const video_modes_info_t * modes_info = cache_video_modes(tvb, pinfo, wValue, wIndex);
+                    for (int offset = 0; offset < tvb_reported_length(tvb); offset += MCT_T6_VIDEO_MODE_LEN) {
+                        tvbuff_t * mode_tvb = tvb_new_subset_length(tvb, offset, MCT_T6_VIDEO_MODE_LEN);
+                        guint i = offset / MCT_T6_VIDEO_MODE_LEN;
+                        mct_t6_video_mode_t mode;
+                        if (modes_info && (i < modes_info->count)) {
+                            mode = *(const mct_t6_video_mode_t *)wmem_array_index(modes_info->table->modes, modes_info->first_index + i);
+                        } else {
+                            decode_video_mode(mode_tvb, 0, &mode);
+                        }
+                        proto_tree * video_mode_tree = dissect_video_mode(video_modes_tree, mode_tvb, &mode, hw_platform);
+                        proto_item_set_generated(proto_tree_add_uint(video_mode_tree, HF_T6_CONTROL_REQ_VIDEO_MODE_INDEX, mode_tvb, 0, 0, (wIndex + offset) / MCT_T6_VIDEO_MODE_LEN));
                     }
                 }
                 break;
@@ -1003,6 +2168,7 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
                 switch (wIndex) {
                     case INFO_FIELD_HW_PLAT:
                         proto_tree_add_item(tree, HF_T6_CONTROL_REQ_INFO_FIELD_HW_PLAT, tvb, 0, 4, ENC_LITTLE_ENDIAN);
+                        record_hw_platform(tvb, pinfo);
                         break;
                     case INFO_FIELD_BOOT_CODE:
                         proto_tree_add_item(tree, HF_T6_CONTROL_REQ_INFO_FIELD_BOOT_CODE, tvb, 0, 4, ENC_LITTLE_ENDIAN);
@@ -1030,18 +2196,7 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
                 proto_tree_add_item(tree, HF_T6_CONTROL_REQ_SESSION_INFO_VDEV_NAME, tvb, 4, 64, ENC_UTF_16 | ENC_LITTLE_ENDIAN);
                 break;
             case CONTROL_REQ_B3:
-                {
-                    uint32_t conf_type = 0;
-                    proto_tree_add_item_ret_uint(tree, HF_T6_CONTROL_REQ_CONF_INFO_TYPE, tvb, 0, 4, ENC_LITTLE_ENDIAN, &conf_type);
-                    proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_SIZE, tvb, 4, 4, ENC_LITTLE_ENDIAN);
-                    switch (conf_type) {
-                        case CONF_TYPE_DISP:
-                            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_VDEV_VID, tvb, 12, 2, ENC_LITTLE_ENDIAN);
-                            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_VDEV_PID, tvb, 14, 2, ENC_LITTLE_ENDIAN);
-                            proto_tree_add_item(tree, HF_T6_CONTROL_REQ_CONF_INFO_VDEV_NAME, tvb, 16, 64, ENC_UTF_16 | ENC_LITTLE_ENDIAN);
-                            break;
-                    }
-                }
+                dissect_config(tree, tvb);
                 break;
             default:
                 proto_tree_add_item(tree, HF_T6_CONTROL_REQ_UNKNOWN_DATA, tvb, 0, -1, ENC_NA);
@@ -1052,6 +2207,171 @@ static int handle_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
     return tvb_captured_length(tvb);
 }
 
+static frame_info_t * frame_info_lookup(wmem_array_t *frame_infos, uint32_t frame_num) {
+    frame_info_t * frame_infos_raw = (frame_info_t *)wmem_array_get_raw(frame_infos);
+    guint count = wmem_array_get_count(frame_infos);
+
+    guint low = 0;
+    guint high = count;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        if (frame_infos_raw[mid].frame_num < frame_num) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if ((low < count) && (frame_infos_raw[low].frame_num == frame_num)) {
+        return &frame_infos_raw[low];
+    }
+
+    return NULL;
+}
+
+static const char * interrupt_event_name(const mct_t6_interrupt_t *interrupt) {
+    if (interrupt->type & MCT_T6_INTERRUPT_TYPE_STATUS_CHANGE) {
+        switch (interrupt->change_flags) {
+            case MCT_T6_INTERRUPT_CHANGE_CONNECTOR_0:
+                return "Connector 0 status change";
+            case MCT_T6_INTERRUPT_CHANGE_CONNECTOR_1:
+                return "Connector 1 status change";
+            case MCT_T6_INTERRUPT_CHANGE_UNKNOWN_26:
+                return "Status change (bit 26)";
+            default:
+                return "Status change";
+        }
+    } else if (interrupt->type & MCT_T6_INTERRUPT_TYPE_CURRENT_STATE) {
+        return "Current state";
+    } else if (interrupt->type & MCT_T6_INTERRUPT_TYPE_FIRMWARE_UPDATE_STATUS) {
+        return "Firmware update status";
+    }
+
+    return "Unknown event";
+}
+
+static device_interrupt_info_t * get_device_interrupt_info(usb_conv_info_t *usb_conv_info) {
+    guint32 device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+
+    device_interrupt_info_t * device_info = (device_interrupt_info_t *)wmem_map_lookup(DEVICE_INTERRUPT_INFOS, GUINT_TO_POINTER(device_id));
+    if (!device_info) {
+        device_info = wmem_new0(wmem_file_scope(), device_interrupt_info_t);
+        device_info->interrupt_infos = wmem_array_new(wmem_file_scope(), sizeof(interrupt_info_t *));
+
+        wmem_map_insert(DEVICE_INTERRUPT_INFOS, GUINT_TO_POINTER(device_id), device_info);
+    }
+
+    return device_info;
+}
+
+static interrupt_info_t * interrupt_info_at(wmem_array_t *interrupt_infos, guint index) {
+    return *(interrupt_info_t **)wmem_array_index(interrupt_infos, index);
+}
+
+/* Makes this bulk transfer the one following every interrupt event that hasn't been followed by a bulk transfer yet,
+ * and, if it starts a video frame, every event that hasn't been followed by a video frame yet. Only called on the
+ * first pass. */
+static void interrupt_follow_track(packet_info *pinfo, usb_conv_info_t *usb_conv_info, bool video_frame_start) {
+    device_interrupt_info_t * device_info = get_device_interrupt_info(usb_conv_info);
+    guint count = wmem_array_get_count(device_info->interrupt_infos);
+
+    interrupt_follow_info_t follow_info = { 0 };
+    follow_info.interrupt_infos = device_info->interrupt_infos;
+
+    follow_info.first_bulk_index = device_info->first_pending_bulk;
+    follow_info.bulk_count = count - device_info->first_pending_bulk;
+    for (guint i = device_info->first_pending_bulk; i < count; i++) {
+        interrupt_info_t * interrupt_info = interrupt_info_at(device_info->interrupt_infos, i);
+        interrupt_info->next_bulk_frame_num = pinfo->num;
+        if (device_info->have_last_bulk) {
+            interrupt_info->have_bulk_gap = true;
+            nstime_delta(&interrupt_info->bulk_gap, &pinfo->abs_ts, &device_info->last_bulk_ts);
+        }
+    }
+    device_info->first_pending_bulk = count;
+    device_info->have_last_bulk = true;
+    device_info->last_bulk_ts = pinfo->abs_ts;
+
+    if (video_frame_start) {
+        follow_info.first_video_index = device_info->first_pending_video;
+        follow_info.video_count = count - device_info->first_pending_video;
+        for (guint i = device_info->first_pending_video; i < count; i++) {
+            interrupt_info_t * interrupt_info = interrupt_info_at(device_info->interrupt_infos, i);
+            interrupt_info->next_video_frame_num = pinfo->num;
+            nstime_delta(&interrupt_info->video_delay, &pinfo->abs_ts, &interrupt_info->ts);
+        }
+        device_info->first_pending_video = count;
+    }
+
+    if ((follow_info.bulk_count > 0) || (follow_info.video_count > 0)) {
+        p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_INTERRUPT_FOLLOW_INFO,
+            wmem_memdup(wmem_file_scope(), &follow_info, sizeof(follow_info)));
+    }
+}
+
+static void dissect_interrupt_follow(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_conv_info_t *usb_conv_info) {
+    const interrupt_follow_info_t * follow_info = (const interrupt_follow_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_INTERRUPT_FOLLOW_INFO);
+    if (!follow_info) {
+        return;
+    }
+
+    guint32 device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+
+    for (guint i = 0; i < follow_info->bulk_count; i++) {
+        const interrupt_info_t * interrupt_info = interrupt_info_at(follow_info->interrupt_infos, follow_info->first_bulk_index + i);
+        if (tree) {
+            nstime_t delay;
+            nstime_delta(&delay, &pinfo->abs_ts, &interrupt_info->ts);
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_INTERRUPT_EVENT, tvb, 0, 0, interrupt_info->frame_num));
+            proto_item_set_generated(proto_tree_add_time(tree, HF_T6_BULK_INTERRUPT_DELAY, tvb, 0, 0, &delay));
+        }
+    }
+
+    if (follow_info->bulk_count > 0) {
+        /* Every event since the last bulk transfer has the same bulk gap, so it's only counted once, for the first
+         * of them. */
+        const interrupt_info_t * interrupt_info = interrupt_info_at(follow_info->interrupt_infos, follow_info->first_bulk_index);
+        bool stall = interrupt_info->have_bulk_gap && (nstime_to_msec(&interrupt_info->bulk_gap) >= PREF_BULK_STALL_THRESHOLD_MS);
+
+        if (interrupt_info->have_bulk_gap) {
+            proto_item * gap_item = proto_tree_add_time(tree, HF_T6_BULK_INTERRUPT_BULK_GAP, tvb, 0, 0, &interrupt_info->bulk_gap);
+            proto_item_set_generated(gap_item);
+            if (stall) {
+                expert_add_info_format(pinfo, gap_item, &EI_T6_BULK_STALL,
+                    "No bulk transfers for %.3f ms across the interrupt event in frame %u",
+                    nstime_to_msec(&interrupt_info->bulk_gap), interrupt_info->frame_num);
+            }
+        }
+
+        if (interrupt_info->have_bulk_gap && mct_stats_interrupt_tap_wanted()) {
+            mct_interrupt_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_interrupt_tap_info_t);
+            tap_info->device_id = device_id;
+            tap_info->event_name = interrupt_event_name(&interrupt_info->interrupt);
+            tap_info->have_bulk_gap = true;
+            tap_info->bulk_gap = interrupt_info->bulk_gap;
+            tap_info->bulk_stall = stall;
+            mct_stats_interrupt_tap_queue(pinfo, tap_info);
+        }
+    }
+
+    for (guint i = 0; i < follow_info->video_count; i++) {
+        const interrupt_info_t * interrupt_info = interrupt_info_at(follow_info->interrupt_infos, follow_info->first_video_index + i);
+        if (tree) {
+            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_INTERRUPT_VIDEO_EVENT, tvb, 0, 0, interrupt_info->frame_num));
+            proto_item_set_generated(proto_tree_add_time(tree, HF_T6_BULK_INTERRUPT_DELAY, tvb, 0, 0, &interrupt_info->video_delay));
+        }
+
+        if (mct_stats_interrupt_tap_wanted()) {
+            mct_interrupt_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_interrupt_tap_info_t);
+            tap_info->device_id = device_id;
+            tap_info->event_name = interrupt_event_name(&interrupt_info->interrupt);
+            tap_info->have_video_delay = true;
+            tap_info->video_delay = interrupt_info->video_delay;
+            mct_stats_interrupt_tap_queue(pinfo, tap_info);
+        }
+    }
+}
+
 static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_conv_info_t *usb_conv_info) {
     if (usb_conv_info->endpoint == 1 && usb_conv_info->direction) {
         /* BULK 1 IN */
@@ -1060,121 +2380,244 @@ static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_
         conversation_t * conversation = find_or_create_conversation(pinfo);
         bulk_conv_info_t * bulk_conv_info = (bulk_conv_info_t *)conversation_get_proto_data(conversation, PROTO_T6);
         if (!bulk_conv_info) {
-            bulk_conv_info = wmem_new(wmem_file_scope(), bulk_conv_info_t);
-            bulk_conv_info->last_frame = NULL;
+            bulk_conv_info = wmem_new0(wmem_file_scope(), bulk_conv_info_t);
             bulk_conv_info->session_conv_info_by_session_num = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
-            bulk_conv_info->frame_info_by_frame_num = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+            bulk_conv_info->selector_infos = wmem_array_new(wmem_file_scope(), sizeof(selector_info_t));
+            bulk_conv_info->frame_infos = wmem_array_new(wmem_file_scope(), sizeof(frame_info_t));
 
             conversation_add_proto_data(conversation, PROTO_T6, bulk_conv_info);
         }
 
         frame_info_t * frame_info = NULL;
         if (!PINFO_FD_VISITED(pinfo)) {
-            if ((bulk_conv_info->last_frame == NULL) || (bulk_conv_info->last_frame->frag_len_remaining == 0)) {
+            guint frame_count = wmem_array_get_count(bulk_conv_info->frame_infos);
+            bool video_frame_start = false;
+
+            if (mct_t6_bulk_expects_selector(&bulk_conv_info->state)) {
                 /* Selector */
 
                 /* Create new selector info */
-                selector_info_t * selector_info = wmem_new(wmem_file_scope(), selector_info_t);
-                selector_info->frame_num = pinfo->num;
-                selector_info->session_num = tvb_get_letohl(tvb, 0);
-                selector_info->payload_len = tvb_get_letohl(tvb, 4);
-                selector_info->dest_addr = tvb_get_letohl(tvb, 8);
-                selector_info->frag_len = tvb_get_letohl(tvb, 12);
-                selector_info->frag_offset = tvb_get_letohl(tvb, 16);
+                uint8_t selector_buf[MCT_T6_SELECTOR_LEN];
+                tvb_memcpy(tvb, selector_buf, 0, MCT_T6_SELECTOR_LEN);
 
-                /* Create new frame info */
-                frame_info = wmem_new(wmem_file_scope(), frame_info_t);
-                frame_info->type = SELECTOR;
-                frame_info->selector_info = selector_info;
-                frame_info->payload_len_remaining = selector_info->payload_len - selector_info->frag_offset;
-                frame_info->frag_len_remaining = selector_info->frag_len;
+                selector_info_t selector_info = { 0 };
+                selector_info.frame_num = pinfo->num;
+                mct_t6_selector_parse(selector_buf, &selector_info.selector);
 
-                bulk_conv_info->last_frame = frame_info;
+                mct_t6_bulk_select(&bulk_conv_info->state, &selector_info.selector);
 
-                session_conv_info_t * session_conv_info = wmem_map_lookup(bulk_conv_info->session_conv_info_by_session_num, GUINT_TO_POINTER(selector_info->session_num));
+                session_conv_info_t * session_conv_info = wmem_map_lookup(bulk_conv_info->session_conv_info_by_session_num, GUINT_TO_POINTER(selector_info.selector.session_num));
                 if (!session_conv_info) {
-                    session_conv_info = wmem_new(wmem_file_scope(), session_conv_info_t);
+                    session_conv_info = wmem_new0(wmem_file_scope(), session_conv_info_t);
+                    session_conv_info->selectors_by_dest_addr = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
                 }
-                session_conv_info->last_frame = frame_info;
+                session_conv_info->last_frame_index = frame_count;
+                if (selector_info.selector.frag_offset == 0) {
+                    session_conv_info->payload_start_frame_num = pinfo->num;
+                    video_frame_start = selector_info.selector.session_num == MCT_T6_SESSION_VIDEO;
+                }
+                selector_info.payload_start_frame_num = session_conv_info->payload_start_frame_num;
 
-                wmem_map_insert(bulk_conv_info->session_conv_info_by_session_num, GUINT_TO_POINTER(selector_info->session_num), session_conv_info);
-                wmem_map_insert(bulk_conv_info->frame_info_by_frame_num, GUINT_TO_POINTER(pinfo->num), frame_info);
-            } else {
-                /* Fragment */
-                selector_info_t * selector_info = bulk_conv_info->last_frame->selector_info;
-                session_conv_info_t * session_conv_info = wmem_map_lookup(bulk_conv_info->session_conv_info_by_session_num, GUINT_TO_POINTER(selector_info->session_num));
-                if (session_conv_info) {
-                    frame_info_t * last_frame_in_session = session_conv_info->last_frame;
+                session_conv_info->counters.bytes += tvb_reported_length(tvb);
+                session_conv_info->counters.selectors++;
+                selector_info.session_counters = session_conv_info->counters;
 
-                    /* Create new frame info */
-                    frame_info = wmem_new(wmem_file_scope(), frame_info_t);
-                    frame_info->type = FRAGMENT;
-                    frame_info->selector_info = selector_info;
-                    frame_info->payload_len_remaining = last_frame_in_session->payload_len_remaining - tvb_reported_length(tvb);
-                    frame_info->frag_len_remaining = last_frame_in_session->frag_len_remaining - tvb_reported_length(tvb);
+                gpointer dest_addr_key = GUINT_TO_POINTER(selector_info.selector.dest_addr);
+                selector_info.dest_addr_selectors = GPOINTER_TO_UINT(wmem_map_lookup(session_conv_info->selectors_by_dest_addr, dest_addr_key)) + 1;
+                wmem_map_insert(session_conv_info->selectors_by_dest_addr, dest_addr_key, GUINT_TO_POINTER(selector_info.dest_addr_selectors));
 
-                    bulk_conv_info->last_frame = frame_info;
+                /* Create new frame info */
+                frame_info_t new_frame_info = { 0 };
+                new_frame_info.frame_num = pinfo->num;
+                new_frame_info.type = SELECTOR;
+                new_frame_info.selector_index = wmem_array_get_count(bulk_conv_info->selector_infos);
+                new_frame_info.payload_len_remaining = bulk_conv_info->state.payload_len_remaining;
+                new_frame_info.frag_len_remaining = bulk_conv_info->state.frag_len_remaining;
 
-                    session_conv_info->last_frame = frame_info;
+                wmem_array_append_one(bulk_conv_info->selector_infos, selector_info);
+                wmem_array_append_one(bulk_conv_info->frame_infos, new_frame_info);
 
-                    wmem_map_insert(bulk_conv_info->frame_info_by_frame_num, GUINT_TO_POINTER(pinfo->num), frame_info);
+                wmem_map_insert(bulk_conv_info->session_conv_info_by_session_num, GUINT_TO_POINTER(selector_info.selector.session_num), session_conv_info);
+            } else {
+                /* Fragment */
+                mct_t6_bulk_continue(&bulk_conv_info->state, tvb_reported_length(tvb));
+
+                /* Create new frame info */
+                frame_info_t new_frame_info = { 0 };
+                new_frame_info.frame_num = pinfo->num;
+                new_frame_info.type = FRAGMENT;
+                new_frame_info.selector_index = wmem_array_get_count(bulk_conv_info->selector_infos) - 1;
+                new_frame_info.payload_len_remaining = bulk_conv_info->state.payload_len_remaining;
+                new_frame_info.frag_len_remaining = bulk_conv_info->state.frag_len_remaining;
+
+                session_conv_info_t * session_conv_info = wmem_map_lookup(bulk_conv_info->session_conv_info_by_session_num, GUINT_TO_POINTER(bulk_conv_info->state.selector.session_num));
+                if (session_conv_info) {
+                    session_conv_info->last_frame_index = frame_count;
+                    session_conv_info->counters.bytes += tvb_reported_length(tvb);
+                    session_conv_info->counters.fragment_bytes += tvb_reported_length(tvb);
+                    session_conv_info->counters.fragments++;
                 }
+
+                wmem_array_append_one(bulk_conv_info->frame_infos, new_frame_info);
             }
+
+            interrupt_follow_track(pinfo, usb_conv_info, video_frame_start);
+
+            /* Fetch the record back out of the array, since appending may have moved it. */
+            frame_info = (frame_info_t *)wmem_array_index(bulk_conv_info->frame_infos, frame_count);
         } else {
-            frame_info = wmem_map_lookup(bulk_conv_info->frame_info_by_frame_num, GUINT_TO_POINTER(pinfo->num));
+            frame_info = frame_info_lookup(bulk_conv_info->frame_infos, pinfo->num);
         }
 
         if (!frame_info) {
             return 0;
         }
 
+        selector_info_t * selector_info = (selector_info_t *)wmem_array_index(bulk_conv_info->selector_infos, frame_info->selector_index);
+
+        /* The last fragment of a video session payload is where the frame's latency is known, once its completion has
+         * been seen. */
+        nstime_t latency;
+        bool have_latency = (frame_info->type == FRAGMENT) && (selector_info->selector.session_num == MCT_T6_SESSION_VIDEO) &&
+            (frame_info->payload_len_remaining == 0) &&
+            mct_stats_frame_latency(pinfo, usb_conv_info, selector_info->payload_start_frame_num, &latency);
+
+        if (mct_stats_tap_wanted()) {
+            mct_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_tap_info_t);
+            tap_info->proto_name = "Trigger 6";
+            tap_info->device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+            tap_info->bulk_bytes = tvb_reported_length(tvb);
+
+            /* A video frame starts with the first fragment of a session 0 payload, which is the only one that has the
+             * video packet header. */
+            uint32_t payload_offset = selector_info->selector.payload_len - frame_info->payload_len_remaining - tvb_reported_length(tvb);
+            if ((frame_info->type == FRAGMENT) && (selector_info->selector.session_num == MCT_T6_SESSION_VIDEO) && (payload_offset == 0) &&
+                tvb_bytes_exist(tvb, 0, MCT_T6_VIDEO_HEADER_LEN + 2)) {
+                tap_info->frame_start = true;
+                tap_info->compressed = tvb_get_ntohs(tvb, MCT_T6_VIDEO_HEADER_LEN) == 0xFFD8;
+                tap_info->frame_bytes = MCT_T6_VIDEO_HEADER_LEN + tvb_get_letohl(tvb, 4);
+            }
+
+            tap_info->have_latency = have_latency;
+            if (have_latency) {
+                tap_info->latency = latency;
+            }
+
+            mct_stats_tap_queue(pinfo, tap_info);
+        }
+
+        dissect_interrupt_follow(tvb, pinfo, tree, usb_conv_info);
+
+        if (mct_stats_session_tap_wanted()) {
+            mct_session_tap_info_t * session_tap_info = wmem_new0(pinfo->pool, mct_session_tap_info_t);
+            session_tap_info->device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+            session_tap_info->session_name = val_to_str(selector_info->selector.session_num, SESSIONS, "Session %u");
+            session_tap_info->selector = frame_info->type == SELECTOR;
+            session_tap_info->dest_addr = selector_info->selector.dest_addr;
+            session_tap_info->bytes = tvb_reported_length(tvb);
+            mct_stats_session_tap_queue(pinfo, session_tap_info);
+        }
+
         if (frame_info->type == SELECTOR) {
             /* Selector */
-            proto_tree_add_item(tree, HF_T6_BULK_SESSION_NUM, tvb, 0, 4, ENC_LITTLE_ENDIAN);
-            proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_LEN, tvb, 4, 4, ENC_LITTLE_ENDIAN);
-            proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_DEST_ADDR, tvb, 8, 4, ENC_LITTLE_ENDIAN);
-            proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_LENGTH, tvb, 12, 4, ENC_LITTLE_ENDIAN);
-            proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_OFFSET, tvb, 16, 4, ENC_LITTLE_ENDIAN);
+            if (tree) {
+                proto_tree_add_item(tree, HF_T6_BULK_SESSION_NUM, tvb, 0, 4, ENC_LITTLE_ENDIAN);
+                proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_LEN, tvb, 4, 4, ENC_LITTLE_ENDIAN);
+                proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_DEST_ADDR, tvb, 8, 4, ENC_LITTLE_ENDIAN);
+                proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_LENGTH, tvb, 12, 4, ENC_LITTLE_ENDIAN);
+                proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_OFFSET, tvb, 16, 4, ENC_LITTLE_ENDIAN);
+
+                const session_counters_t * counters = &selector_info->session_counters;
+                proto_item_set_generated(proto_tree_add_uint64(tree, HF_T6_BULK_SESSION_BYTES, tvb, 0, 0, counters->bytes));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_SELECTORS, tvb, 0, 0, counters->selectors));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_FRAGMENTS, tvb, 0, 0, counters->fragments));
+                if (counters->fragments > 0) {
+                    proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_AVG_FRAGMENT_LEN, tvb, 0, 0,
+                        (uint32_t)(counters->fragment_bytes / counters->fragments)));
+                }
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_DEST_ADDR_SELECTORS, tvb, 0, 0, selector_info->dest_addr_selectors));
+            }
         } else {
             /* Fragment */
-            selector_info_t * selector_info = frame_info->selector_info;
-
-            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_SELECTOR, tvb, 0, 0, selector_info->frame_num));
-            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_NUM, tvb, 0, 0, selector_info->session_num));
-            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_LEN, tvb, 0, 0, selector_info->payload_len));
-            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_DEST_ADDR, tvb, 0, 0, selector_info->dest_addr));
-            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_LENGTH, tvb, 0, 0, selector_info->frag_len));
-            proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_OFFSET, tvb, 0, 0, selector_info->frag_offset));
+            if (tree) {
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_SELECTOR, tvb, 0, 0, selector_info->frame_num));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_NUM, tvb, 0, 0, selector_info->selector.session_num));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_LEN, tvb, 0, 0, selector_info->selector.payload_len));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_DEST_ADDR, tvb, 0, 0, selector_info->selector.dest_addr));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_LENGTH, tvb, 0, 0, selector_info->selector.frag_len));
+                proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_BULK_SESSION_PAYLOAD_FRAGMENT_OFFSET, tvb, 0, 0, selector_info->selector.frag_offset));
+                if (have_latency) {
+                    proto_item_set_generated(proto_tree_add_time(tree, HF_T6_BULK_FRAME_LATENCY, tvb, 0, 0, &latency));
+                }
+            }
 
             tvbuff_t * next_tvb = NULL;
-            if ((selector_info->payload_len > selector_info->frag_len) || (selector_info->frag_len > tvb_reported_length(tvb))) {
+            if ((selector_info->selector.payload_len > selector_info->selector.frag_len) || (selector_info->selector.frag_len > tvb_reported_length(tvb))) {
                 /* Fragmented */
                 pinfo->fragmented = true;
 
-                uint32_t calc_frag_offset = selector_info->payload_len - frame_info->payload_len_remaining - tvb_reported_length(tvb);
-                gboolean more_frags = frame_info->payload_len_remaining > 0;
+                uint32_t calc_frag_offset = selector_info->selector.payload_len - frame_info->payload_len_remaining - tvb_reported_length(tvb);
+
+                if (PREF_TRUNCATED_CAPTURE) {
+                    /* Sizing only, don't hold on to fragments that will never be reassembled. */
+                    col_append_fstr(pinfo->cinfo, COL_INFO, " (Fragment offset %u)", calc_frag_offset);
+                } else {
+                    gboolean more_frags = frame_info->payload_len_remaining > 0;
 
-                fragment_head * frag_head = fragment_add_check(&T6_REASSEMBLY_TABLE,
-                    tvb, 0, pinfo, selector_info->session_num, NULL,
-                    calc_frag_offset, tvb_captured_length(tvb), more_frags);
+                    fragment_head * frag_head = fragment_add_check(&T6_REASSEMBLY_TABLE,
+                        tvb, 0, pinfo, selector_info->selector.session_num, NULL,
+                        calc_frag_offset, tvb_captured_length(tvb), more_frags);
 
-                next_tvb = process_reassembled_data(tvb, 0, pinfo, "Reassembled Payload", frag_head, &T6_BULK_FRAG_ITEMS, NULL, tree);
+                    next_tvb = process_reassembled_data(tvb, 0, pinfo, "Reassembled Payload", frag_head, &T6_BULK_FRAG_ITEMS, NULL, tree);
 
-                if (frag_head) {
-                    /* Reassembled */
-                    col_append_str(pinfo->cinfo, COL_INFO, " (Payload Reassembled)");
-                } else {
-                    /* Failed to reassemble. This can happen when a packet captures less data than was reported, which
-                     * seems to be common with captured firmware updates. */
-                    col_append_fstr(pinfo->cinfo, COL_INFO, " (Fragment offset %u)", calc_frag_offset);
+                    if (frag_head) {
+                        /* Reassembled */
+                        col_append_str(pinfo->cinfo, COL_INFO, " (Payload Reassembled)");
+                    } else {
+                        /* Failed to reassemble. This can happen when a packet captures less data than was reported,
+                         * which seems to be common with captured firmware updates. */
+                        col_append_fstr(pinfo->cinfo, COL_INFO, " (Fragment offset %u)", calc_frag_offset);
+                    }
                 }
             } else {
                 /* Not fragmented */
                 next_tvb = tvb;
             }
 
-            if (next_tvb) {
-                proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_DATA, next_tvb, 0, -1, ENC_NA);
+            if (next_tvb && VIDEO_EXPORT_INDEX && (selector_info->selector.session_num == MCT_T6_SESSION_VIDEO) && !PINFO_FD_VISITED(pinfo)) {
+                /* Frames are written out as soon as they're reassembled so nothing needs to be kept around. */
+                export_video_frame(next_tvb, pinfo);
+            }
+
+            if (next_tvb && (selector_info->selector.session_num == MCT_T6_SESSION_AUDIO)) {
+                uint32_t device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+                if (AUDIO_EXPORTS && !PINFO_FD_VISITED(pinfo)) {
+                    export_audio_chunk(next_tvb, device_id);
+                }
+
+                if (mct_stats_audio_tap_wanted()) {
+                    mct_audio_tap_info_t * audio_tap_info = wmem_new0(pinfo->pool, mct_audio_tap_info_t);
+                    audio_tap_info->device_id = device_id;
+                    audio_tap_info->nominal_sample_rate = PREF_AUDIO_SAMPLE_RATE;
+                    audio_tap_info->truncated = tvb_captured_length(next_tvb) < tvb_reported_length(next_tvb);
+                    audio_tap_info->samples = tvb_reported_length(next_tvb) / (AUDIO_CHANNELS * AUDIO_BYTES_PER_SAMPLE);
+                    mct_stats_audio_tap_queue(pinfo, audio_tap_info);
+                }
+            }
+
+            if (next_tvb && (selector_info->selector.session_num == MCT_T6_SESSION_VIDEO) &&
+                (tvb_captured_length(next_tvb) >= 12)) {
+                col_append_fstr(pinfo->cinfo, COL_INFO, " (Video seq %u)", tvb_get_letohl(next_tvb, 8));
+            }
+
+            if (next_tvb && (selector_info->selector.session_num == MCT_T6_SESSION_FIRMWARE_UPDATE)) {
+                dissect_firmware_image(next_tvb, pinfo, tree, usb_conv_info);
+            } else if (next_tvb && tree) {
+                if ((selector_info->selector.session_num == MCT_T6_SESSION_VIDEO) && (tvb_reported_length(next_tvb) >= MCT_T6_VIDEO_HEADER_LEN)) {
+                    dissect_video_packet(next_tvb, pinfo, tree);
+                } else {
+                    proto_tree_add_item(tree, HF_T6_BULK_SESSION_PAYLOAD_DATA, next_tvb, 0, -1, ENC_NA);
+                }
             }
         }
     } else {
@@ -1185,8 +2628,91 @@ static int handle_bulk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_
 }
 
 static int handle_interrupt(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, usb_conv_info_t *usb_conv_info) {
+    if (!usb_conv_info->direction || (tvb_reported_length(tvb) == 0)) {
+        return 0;
+    }
+
     /* INTERRUPT IN */
 
+    if (tvb_reported_length(tvb) != MCT_T6_INTERRUPT_LEN) {
+        expert_add_info(pinfo, proto_tree_get_parent(tree), &EI_T6_INTERRUPT_LEN_INVALID);
+        return tvb_captured_length(tvb);
+    }
+
+    interrupt_info_t * interrupt_info = NULL;
+    if (!PINFO_FD_VISITED(pinfo)) {
+        uint8_t interrupt_buf[MCT_T6_INTERRUPT_LEN];
+        tvb_memcpy(tvb, interrupt_buf, 0, MCT_T6_INTERRUPT_LEN);
+
+        interrupt_info = wmem_new0(wmem_file_scope(), interrupt_info_t);
+        interrupt_info->frame_num = pinfo->num;
+        interrupt_info->ts = pinfo->abs_ts;
+        mct_t6_interrupt_parse(interrupt_buf, &interrupt_info->interrupt);
+
+        device_interrupt_info_t * device_info = get_device_interrupt_info(usb_conv_info);
+        wmem_array_append_one(device_info->interrupt_infos, interrupt_info);
+
+        p_add_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_INTERRUPT_INFO, interrupt_info);
+    } else {
+        interrupt_info = (interrupt_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, PROTO_T6, PROTO_DATA_INTERRUPT_INFO);
+    }
+
+    if (!interrupt_info) {
+        return 0;
+    }
+
+    const char * event_name = interrupt_event_name(&interrupt_info->interrupt);
+    col_append_fstr(pinfo->cinfo, COL_INFO, " (%s)", event_name);
+
+    if (mct_stats_interrupt_tap_wanted()) {
+        mct_interrupt_tap_info_t * tap_info = wmem_new0(pinfo->pool, mct_interrupt_tap_info_t);
+        tap_info->device_id = (usb_conv_info->bus_id << 16) | usb_conv_info->device_address;
+        tap_info->event_name = event_name;
+        tap_info->event = true;
+        mct_stats_interrupt_tap_queue(pinfo, tap_info);
+    }
+
+    if (!tree) {
+        return tvb_captured_length(tvb);
+    }
+
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_TYPE, tvb, 0x00, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_TYPE_STATUS_CHANGE, tvb, 0x00, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_TYPE_CURRENT_STATE, tvb, 0x00, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_TYPE_FIRMWARE_UPDATE_STATUS, tvb, 0x00, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_UNKNOWN, tvb, 0x04, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_UNKNOWN, tvb, 0x08, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_COUNTER, tvb, 0x0C, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_CHANGE_FLAGS, tvb, 0x10, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_CHANGE_CONNECTOR_0, tvb, 0x10, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_CHANGE_CONNECTOR_1, tvb, 0x10, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_CHANGE_UNKNOWN_26, tvb, 0x10, 4, ENC_LITTLE_ENDIAN);
+    for (guint offset = 0x14; offset < 0x20; offset += 4) {
+        proto_tree_add_item(tree, HF_T6_INTERRUPT_UNKNOWN, tvb, offset, 4, ENC_LITTLE_ENDIAN);
+    }
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_STATE_FLAGS, tvb, 0x20, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_STATE_CONNECTOR_0_CONNECTED, tvb, 0x20, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_STATE_CONNECTOR_1_CONNECTED, tvb, 0x20, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_UNKNOWN, tvb, 0x24, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_UNKNOWN, tvb, 0x28, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_FIRMWARE_UPDATE_STATUS, tvb, 0x2C, 4, ENC_LITTLE_ENDIAN);
+    proto_tree_add_item(tree, HF_T6_INTERRUPT_FIRMWARE_UPDATE_PROGRESS, tvb, 0x30, 4, ENC_LITTLE_ENDIAN);
+    for (guint offset = 0x34; offset < MCT_T6_INTERRUPT_LEN; offset += 4) {
+        proto_tree_add_item(tree, HF_T6_INTERRUPT_UNKNOWN, tvb, offset, 4, ENC_LITTLE_ENDIAN);
+    }
+
+    /* What followed the event, which is only known once the following bulk transfers have been dissected. */
+    if (interrupt_info->next_bulk_frame_num) {
+        proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_INTERRUPT_NEXT_BULK, tvb, 0, 0, interrupt_info->next_bulk_frame_num));
+    }
+    if (interrupt_info->have_bulk_gap) {
+        proto_item_set_generated(proto_tree_add_time(tree, HF_T6_INTERRUPT_BULK_GAP, tvb, 0, 0, &interrupt_info->bulk_gap));
+    }
+    if (interrupt_info->next_video_frame_num) {
+        proto_item_set_generated(proto_tree_add_uint(tree, HF_T6_INTERRUPT_NEXT_VIDEO_FRAME, tvb, 0, 0, interrupt_info->next_video_frame_num));
+        proto_item_set_generated(proto_tree_add_time(tree, HF_T6_INTERRUPT_VIDEO_DELAY, tvb, 0, 0, &interrupt_info->video_delay));
+    }
+
     return tvb_captured_length(tvb);
 }
 
@@ -1214,6 +2740,121 @@ static int dissect_t6(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void
     };
 }
 
+/* Notes what the heuristic dissector knows about the packet's device from the packet's frame on. */
+static heur_device_t * heur_device_insert(packet_info *pinfo, const usb_conv_info_t *usb_conv_info, gboolean recognized) {
+    gpointer device_key = GUINT_TO_POINTER((usb_conv_info->bus_id << 16) | usb_conv_info->device_address);
+    wmem_tree_t * history = (wmem_tree_t *)wmem_map_lookup(HEUR_DEVICES, device_key);
+    if (!history) {
+        history = wmem_tree_new(wmem_file_scope());
+        wmem_map_insert(HEUR_DEVICES, device_key, history);
+    }
+
+    heur_device_t * device = wmem_new0(wmem_file_scope(), heur_device_t);
+    device->recognized = recognized;
+    device->id = ((guint32)usb_conv_info->deviceVendor << 16) | usb_conv_info->deviceProduct;
+    device->version = usb_conv_info->deviceVersion;
+    wmem_tree_insert32(history, pinfo->num, device);
+    return device;
+}
+
+/* Returns whether the packet's device was recognized by the heuristic dissector at or before the packet's frame. Only
+ * the first pass recognizes devices, so that every pass starts dissecting a device's packets at the same frame, and a
+ * recognition is dropped once the address has a device with another identity, e.g. after re-enumeration. */
+static gboolean heur_device_recognized(packet_info *pinfo, const usb_conv_info_t *usb_conv_info) {
+    wmem_tree_t * history = (wmem_tree_t *)wmem_map_lookup(HEUR_DEVICES,
+        GUINT_TO_POINTER((usb_conv_info->bus_id << 16) | usb_conv_info->device_address));
+    const heur_device_t * device = history ? (const heur_device_t *)wmem_tree_lookup32_le(history, pinfo->num) : NULL;
+    if (!device || !device->recognized) {
+        return false;
+    }
+
+    if (!PINFO_FD_VISITED(pinfo) &&
+        ((device->id != (((guint32)usb_conv_info->deviceVendor << 16) | usb_conv_info->deviceProduct)) ||
+         (device->version != usb_conv_info->deviceVersion))) {
+        heur_device_insert(pinfo, usb_conv_info, false);
+        return false;
+    }
+
+    return true;
+}
+
+/* For adapters with other IDs (e.g., OEM-rebranded ones). A device is recognized by a bulk OUT packet that's a
+ * plausible select session packet, which is checked in constant time, and from then on all of its packets are
+ * dissected. Since the bulk stream state starts out expecting a selector, it stays in sync. Control transfers from
+ * before that frame aren't dissected on any pass, so the EDID and mode state is the same with one pass or two. */
+static gboolean dissect_t6_heur(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data) {
+    usb_conv_info_t * usb_conv_info = (usb_conv_info_t *)data;
+    if (!usb_conv_info) {
+        return false;
+    }
+
+    /* Devices with known IDs are already dissected through the usb.product table. */
+    if (value_is_in_range((range_t *)&MCT_USB_PID_RANGE, ((guint32)usb_conv_info->deviceVendor << 16) | usb_conv_info->deviceProduct)) {
+        return false;
+    }
+
+    if (!heur_device_recognized(pinfo, usb_conv_info)) {
+        if (PINFO_FD_VISITED(pinfo)) {
+            return false;
+        }
+
+        if ((usb_conv_info->transfer_type != URB_BULK) || (usb_conv_info->endpoint != 2) || usb_conv_info->direction ||
+            (tvb_reported_length(tvb) != MCT_T6_SELECTOR_PACKET_LEN) || !tvb_bytes_exist(tvb, 0, MCT_T6_SELECTOR_LEN)) {
+            return false;
+        }
+
+        uint8_t selector_buf[MCT_T6_SELECTOR_LEN];
+        tvb_memcpy(tvb, selector_buf, 0, MCT_T6_SELECTOR_LEN);
+
+        mct_t6_selector_t selector = { 0 };
+        mct_t6_selector_parse(selector_buf, &selector);
+        if (!mct_t6_selector_plausible(&selector)) {
+            return false;
+        }
+
+        heur_device_insert(pinfo, usb_conv_info, true);
+    }
+
+    return dissect_t6(tvb, pinfo, tree, data) > 0;
+}
+
+static void video_export_init(void) {
+    if (!PREF_VIDEO_EXPORT_DIR || !PREF_VIDEO_EXPORT_DIR[0]) {
+        return;
+    }
+
+    gchar * path = g_build_filename(PREF_VIDEO_EXPORT_DIR, "index.csv", NULL);
+    VIDEO_EXPORT_INDEX = ws_fopen(path, "w");
+    g_free(path);
+
+    if (VIDEO_EXPORT_INDEX) {
+        fprintf(VIDEO_EXPORT_INDEX, "frame_num,session_seq,timestamp,jpeg_width,jpeg_height,payload_len,filename\n");
+    }
+}
+
+static void video_export_cleanup(void) {
+    if (VIDEO_EXPORT_INDEX) {
+        fclose(VIDEO_EXPORT_INDEX);
+        VIDEO_EXPORT_INDEX = NULL;
+    }
+}
+
+static void audio_export_init(void) {
+    if (!PREF_AUDIO_EXPORT_FILE || !PREF_AUDIO_EXPORT_FILE[0]) {
+        return;
+    }
+
+    /* The files themselves are only created once a device's first audio payload is seen. */
+    AUDIO_EXPORTS = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, audio_export_free);
+}
+
+static void audio_export_cleanup(void) {
+    if (AUDIO_EXPORTS) {
+        g_hash_table_destroy(AUDIO_EXPORTS);
+        AUDIO_EXPORTS = NULL;
+    }
+}
+
 void proto_register_trigger6(void) {
     proto_register_subtree_array(ETT, array_length(ETT));
 
@@ -1230,6 +2871,44 @@ void proto_register_trigger6(void) {
     proto_register_field_array(PROTO_T6, HF_T6_CONTROL_CURSOR_UPLOAD_FRAG, array_length(HF_T6_CONTROL_CURSOR_UPLOAD_FRAG));
     proto_register_field_array(PROTO_T6, HF_T6_BULK, array_length(HF_T6_BULK));
     proto_register_field_array(PROTO_T6, HF_T6_BULK_FRAG, array_length(HF_T6_BULK_FRAG));
+    proto_register_field_array(PROTO_T6, HF_T6_FIRMWARE, array_length(HF_T6_FIRMWARE));
+    proto_register_field_array(PROTO_T6, HF_T6_INTERRUPT, array_length(HF_T6_INTERRUPT));
+
+    expert_module_t * expert = expert_register_protocol(PROTO_T6);
+    expert_register_field_array(expert, EI_T6, array_length(EI_T6));
+
+    HEUR_DEVICES = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+    DEVICE_INTERRUPT_INFOS = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+
+    T6_EXPORT_OBJECT_TAP = register_export_object(PROTO_T6, firmware_eo_packet, NULL);
+
+    module_t * t6_module = prefs_register_protocol(PROTO_T6, NULL);
+    prefs_register_directory_preference(t6_module, "video_export_dir", "Video frame export directory",
+        "If set, every JPEG video frame is written to this directory as it's reassembled, along with an index.csv "
+        "listing each frame's number, sequence counter, timestamp, and dimensions.",
+        &PREF_VIDEO_EXPORT_DIR);
+
+    prefs_register_filename_preference(t6_module, "audio_export_file", "Audio export file",
+        "If set, the PCM data of each device's audio session is written to a WAV file as it's reassembled, named after "
+        "this one with the device's bus and address added, e.g. audio-bus1-dev5.wav.",
+        &PREF_AUDIO_EXPORT_FILE, true);
+    prefs_register_uint_preference(t6_module, "audio_sample_rate", "Nominal audio sample rate (Hz)",
+        "The sample rate the audio session is expected to run at. Used for the exported WAV file and the audio "
+        "statistics.",
+        10, &PREF_AUDIO_SAMPLE_RATE);
+    prefs_register_bool_preference(t6_module, "truncated_capture", "Capture has truncated bulk transfers",
+        "Don't try to reassemble fragmented bulk payloads, and only track their sizes and timing. Use this for "
+        "captures where large bulk transfers were truncated (e.g., usbmon), where reassembly would fail anyway.",
+        &PREF_TRUNCATED_CAPTURE);
+    prefs_register_uint_preference(t6_module, "bulk_stall_threshold_ms", "Bulk stall threshold (ms)",
+        "Flag the first bulk transfer after an interrupt event when the bulk stream was idle for at least this long "
+        "across the event.",
+        10, &PREF_BULK_STALL_THRESHOLD_MS);
+
+    register_init_routine(video_export_init);
+    register_init_routine(audio_export_init);
+    register_cleanup_routine(video_export_cleanup);
+    register_cleanup_routine(audio_export_cleanup);
 
     T6_HANDLE = register_dissector("trigger6", dissect_t6, PROTO_T6);
 }
@@ -1237,4 +2916,12 @@ void proto_register_trigger6(void) {
 void proto_reg_handoff_trigger6(void) {
     dissector_add_uint_range("usb.product", (range_t *)&MCT_USB_PID_RANGE, T6_HANDLE);
     dissector_add_for_decode_as("usb.device", T6_HANDLE);
+
+    /* Once a device is recognized from its bulk stream, its control and interrupt packets are dissected as well. */
+    heur_dissector_add("usb.bulk", dissect_t6_heur, "MCT Trigger 6 over USB bulk", "trigger6_usb_bulk", PROTO_T6, HEURISTIC_ENABLE);
+    heur_dissector_add("usb.control", dissect_t6_heur, "MCT Trigger 6 over USB control", "trigger6_usb_control", PROTO_T6, HEURISTIC_ENABLE);
+    heur_dissector_add("usb.interrupt", dissect_t6_heur, "MCT Trigger 6 over USB interrupt", "trigger6_usb_interrupt", PROTO_T6, HEURISTIC_ENABLE);
+
+    JFIF_HANDLE = find_dissector_add_dependency("image-jfif", PROTO_T6);
+    EDID_HANDLE = find_dissector_add_dependency("mct_edid", PROTO_T6);
 }